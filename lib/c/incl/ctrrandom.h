@@ -0,0 +1,80 @@
+#ifndef CTRRANDOM_HEADER
+#define CTRRANDOM_HEADER
+
+/* ==== HEADER ctrrandom.h ==== */
+
+/* Counter-based random number generator. The random numbers
+ * are obtained by encrypting a counter with a key made up of
+ * the seed and the run number, using the Threefry-2x32 block
+ * function with 20 rounds. There is no global state: each
+ * caller owns a small Ctrrand_ structure, and the N-th number
+ * of a (seed, run, stream) triplet is always the same no matter
+ * which process or thread generates it, or in which order.
+ * Reference:
+ * J.K. Salmon, M.A. Moraes, R.O. Dror, D.E. Shaw: Parallel
+ * random numbers: as easy as 1, 2, 3. Proc. SC11 (2011).
+ */
+
+/* ---- STANDARD HEADERS ---- */
+
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+/* ---- TYPEDEFS ---- */
+
+/* Ctrrand_: the state of a random number stream. Do not access
+ * the members directly, use the functions below.
+ */
+typedef struct
+{
+    unsigned long Key[3];   /* seed, run, key schedule parity */
+    unsigned long Ctr[2];   /* block counter and stream ID */
+    int Spare;		    /* Gauss variables */
+    double Spval;
+}
+Ctrrand_;
+
+/* ---- PROTOTYPES ---- */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* init_ctrrand: initialises the random number stream Rng
+ * for the seed Seed, the run number Run and the stream Stream.
+ * Only the lower 32 bits of the arguments are used.
+ */
+void init_ctrrand(Ctrrand_ *Rng, long Seed,
+	unsigned long Run, unsigned long Stream);
+
+/* ctr_block: the Threefry-2x32 block function. Encrypts the counter
+ * words Ctr[0..1] with the key words Key[0..1] and puts the
+ * result into Out[0..1]. All values are 32-bit. Stateless.
+ */
+void ctr_block(const unsigned long Key[2], const unsigned long Ctr[2],
+	unsigned long Out[2]);
+
+/* ctr_rand: returns a non-negative pseudo-random number
+ * from the stream Rng (all 31 bits random).
+ */
+long ctr_rand(Ctrrand_ *Rng);
+
+/* ctr_random: returns a pseudo-random number in the interval
+ * (0.0 .. 1.0) from the stream Rng, with 53 random bits.
+ */
+double ctr_random(Ctrrand_ *Rng);
+
+/* ctrrandom_gauss: returns normally distributed random numbers with
+ * zero mean and unit variance from the stream Rng.
+ * Based on the Box/Muller method as described in Numerical Recipes.
+ */
+double ctrrandom_gauss(Ctrrand_ *Rng);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* ==== END OF HEADER ctrrandom.h ==== */
+
+#endif	/* CTRRANDOM_HEADER */
@@ -0,0 +1,159 @@
+/* ==== FUNCTIONS ctrrandom.c ==== */
+
+/* Counter-based random number generator. The random numbers
+ * are obtained by encrypting a counter with a key made up of
+ * the seed and the run number, using the Threefry-2x32 block
+ * function with 20 rounds.
+ * Reference:
+ * J.K. Salmon, M.A. Moraes, R.O. Dror, D.E. Shaw: Parallel
+ * random numbers: as easy as 1, 2, 3. Proc. SC11 (2011).
+ */
+
+/* ---- HEADER ---- */
+
+#include "ctrrandom.h"
+
+/* ---- PRIVATE CONSTANTS ---- */
+
+#define MASK32 0xFFFFFFFFUL	/* unsigned long may be longer than 32 bits */
+#define PARITY32 0x1BD11BDAUL	/* Skein key schedule parity constant */
+#define ROUNDS 20
+
+/* rotation constants for Threefry-2x32 */
+static const int Rot[8]={13, 15, 26, 6, 17, 29, 16, 24};
+
+/* 32-bit left rotation */
+#define ROTL32(x, n) ((((x)<<(n)) | ((x)>>(32-(n)))) & MASK32)
+
+/* ==== FUNCTIONS ==== */
+
+/* init_ctrrand: initialises the random number stream Rng
+ * for the seed Seed, the run number Run and the stream Stream.
+ * Only the lower 32 bits of the arguments are used.
+ */
+void init_ctrrand(Ctrrand_ *Rng, long Seed,
+	unsigned long Run, unsigned long Stream)
+{
+    Rng->Key[0]=((unsigned long)Seed) & MASK32;
+    Rng->Key[1]=Run & MASK32;
+    Rng->Key[2]=PARITY32 ^ Rng->Key[0] ^ Rng->Key[1];
+    Rng->Ctr[0]=0UL;
+    Rng->Ctr[1]=Stream & MASK32;
+    Rng->Spare=0;
+    Rng->Spval=0.0;
+}
+/* END of init_ctrrand */
+
+/* ctr_round: the body of the block function, Ks is the
+ * extended key schedule [0..2].
+ */
+static void ctr_round(const unsigned long Ks[3], const unsigned long Ctr[2],
+	unsigned long Out[2])
+{
+    register unsigned long X0, X1;
+    register int r, i;
+
+    X0=(Ctr[0]+Ks[0]) & MASK32;
+    X1=(Ctr[1]+Ks[1]) & MASK32;
+    for (r=0; r<ROUNDS; r++)
+    {
+	X0=(X0+X1) & MASK32;
+	X1=ROTL32(X1, Rot[r%8]);
+	X1^=X0;
+
+	/* inject the key after every 4 rounds */
+	if (r%4==3)
+	{
+	    i=(r+1)/4;
+	    X0=(X0+Ks[i%3]) & MASK32;
+	    X1=(X1+Ks[(i+1)%3]+i) & MASK32;
+	}
+    }
+    Out[0]=X0; Out[1]=X1;
+}
+/* END of ctr_round */
+
+/* ctr_block: the Threefry-2x32 block function. Encrypts the counter
+ * words Ctr[0..1] with the key words Key[0..1] and puts the
+ * result into Out[0..1]. All values are 32-bit. Stateless.
+ */
+void ctr_block(const unsigned long Key[2], const unsigned long Ctr[2],
+	unsigned long Out[2])
+{
+    unsigned long Ks[3];
+
+    Ks[0]=Key[0] & MASK32; Ks[1]=Key[1] & MASK32;
+    Ks[2]=PARITY32 ^ Ks[0] ^ Ks[1];
+    ctr_round(Ks, Ctr, Out);
+}
+/* END of ctr_block */
+
+/* ctr_rand: returns a non-negative pseudo-random number
+ * from the stream Rng (all 31 bits random).
+ */
+long ctr_rand(Ctrrand_ *Rng)
+{
+    unsigned long Out[2];
+
+    ctr_round(Rng->Key, Rng->Ctr, Out);
+    Rng->Ctr[0]=(Rng->Ctr[0]+1UL) & MASK32;
+    return((long)(Out[0]>>1));
+}
+/* END of ctr_rand */
+
+/* ctr_random: returns a pseudo-random number in the interval
+ * (0.0 .. 1.0) from the stream Rng, with 53 random bits.
+ */
+double ctr_random(Ctrrand_ *Rng)
+{
+    unsigned long Out[2];
+
+    ctr_round(Rng->Key, Rng->Ctr, Out);
+    Rng->Ctr[0]=(Rng->Ctr[0]+1UL) & MASK32;
+
+    /* 27+26 bits, shifted by half a unit so that 0.0 is never returned */
+    return(((Out[0]>>5)*67108864.0+(Out[1]>>6)+0.5)/9007199254740992.0);
+}
+/* END of ctr_random */
+
+/* ctrrandom_gauss: returns normally distributed random numbers with
+ * zero mean and unit variance from the stream Rng.
+ * Based on the Box/Muller method as described in Numerical Recipes.
+ */
+#ifndef DBL_EPSILON
+#define EPSILON 2.2e-15
+#else
+#define EPSILON DBL_EPSILON
+#endif
+double ctrrandom_gauss(Ctrrand_ *Rng)
+{
+    register double Fac, R, V1, V2;
+
+    if (Rng->Spare)	/* we had a value from a previous call: return it */
+    {
+	Rng->Spare=0;
+	return(Rng->Spval);
+    }
+    else    /* make two values, save one, return the other */
+    {
+	do  /* get two random numbers within the unit circle */
+	{
+	    V1=2.0*ctr_random(Rng)-1.0; V2=2.0*ctr_random(Rng)-1.0;
+	    R=V1*V1+V2*V2;
+	}
+	while (R>=1.0 || R<=EPSILON);
+	Fac=sqrt(-2.0*log(R)/R);
+	Rng->Spval=V1*Fac;	/* spare value to be returned next time */
+	Rng->Spare=1;
+	return(V2*Fac);
+    }
+}
+#undef EPSILON
+/* END of ctrrandom_gauss */
+
+#undef MASK32
+#undef PARITY32
+#undef ROUNDS
+#undef ROTL32
+
+/* ==== END OF FUNCTIONS ctrrandom.c ==== */
@@ -78,6 +78,11 @@ class Bits_
      */
     Bits_& operator=(const Bits_& Other);
     
+    /* swap(): exchanges the contents of the calling object and Other
+     * without copying the bits.
+     */
+    void swap(Bits_& Other);
+    
 	// equality
     /* ==,!=: return an appropriate Boolean value. Two Bits_ arrays are
      * equal if they have the same number of bits and all bits are set
@@ -0,0 +1,183 @@
+#ifndef COORDS_CLASS
+#define COORDS_CLASS
+
+// ==== HEADER Coords.h ====
+
+/* Point coordinates stored column-wise ("structure of arrays")
+ * for the time-critical loops. Complements the Points_ class.
+ */
+
+// ---- STANDARD HEADERS ----
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <iostream.h>
+
+// ---- INCLUDE FILES ----
+
+#include "Bits.h"	// activation mask
+#include "Vector.h"	// the Vector_ class
+#include "Trimat.h"	// triangular matrix class
+#include "Points.h"	// conversions
+
+// ==== CLASSES ====
+
+/* Class Coords_ : stores Len points of the same dimension Dim.
+ * The d-th coordinates of all points (the "x[]", "y[]", "z[]"...
+ * columns) are kept in contiguous arrays, so that loops over
+ * the points run over adjacent memory locations instead of
+ * chasing the separately allocated Vector_-s of a Points_ object.
+ * All columns are in one block and each column starts at an
+ * address aligned to COORDS_ALIGN doubles.
+ * Points can be switched on and off as in Points_: the indices
+ * of the active points are kept in a list, and the (i,d) access
+ * and the "overall" operations work on the active points only.
+ */
+class Coords_
+{
+    // data
+    private:
+
+    double *Block, *X;	// the storage and its aligned start (column 0)
+    unsigned int Len, Dim, Stride;  // no. of points, dimension, column stride
+    unsigned int Cap, Maxlen;	// allocated no. of doubles (from X on) and points
+    unsigned int *Act, Actno;	// indices of the active points and their number
+    Bits_ Mask;	    // the activation status
+
+    // methods
+    public:
+
+	// constructors and dtor
+    /* Initialises to hold N (default=1) points, each D-dimensional
+     * (default=3). All points will be active, the coordinates are 0.0.
+     */
+    Coords_(unsigned int N=1, unsigned int D=3);
+
+    /* Initialises with the active points of Points (cf. get() below). */
+    Coords_(const Points_& Points);
+
+    Coords_(const Coords_& Coords);
+    ~Coords_() { delete [] Block; delete [] Act; }
+
+    Coords_& operator=(const Coords_& Coords);
+
+    /* swap(): exchanges the contents of the calling object and Coords.
+     * Only the storage addresses are swapped, the coordinates are not copied.
+     */
+    void swap(Coords_& Coords);
+
+	// size
+    unsigned int len() const { return(Len); }
+    unsigned int dim() const { return(Dim); }
+    unsigned int active_len() const { return(Actno); }
+
+    /* len_dim(): adjusts the size to N points in D dimensions (default 3)
+     * and switches on all points. Reallocates only if the new size
+     * does not fit into the old storage. The coordinates will be 0.0.
+     */
+    void len_dim(unsigned int N, unsigned int D=3);
+
+	// activation
+    /* mask(): returns the current activation mask.
+     * mask(Newmask): sets the activation mask to Newmask which must
+     * be len() long, otherwise nothing happens (with a warning).
+     * mask(Value): sets all activation bits to Value.
+     * Both "set" versions return the old mask.
+     */
+    const Bits_& mask() const { return(Mask); }
+    Bits_ mask(const Bits_& Newmask);
+    Bits_ mask(bool Value);
+
+    /* idx(): returns the storage index of the i-th active point,
+     * i.e. its position in the columns.
+     */
+    unsigned int idx(unsigned int i) const { return(Act[i]); }
+
+	// access
+    /* col(): returns the address of the d-th column which holds
+     * the d-th coordinate of all points (active or not) in
+     * storage order. No range checks.
+     */
+    double *col(unsigned int d) { return(X+d*Stride); }
+    const double *col(unsigned int d) const { return(X+d*Stride); }
+
+    /* (i, d): the d-th coordinate of the i-th active point. No range checks. */
+    double& operator()(unsigned int i, unsigned int d) { return(X[d*Stride+Act[i]]); }
+    double operator()(unsigned int i, unsigned int d) const { return(X[d*Stride+Act[i]]); }
+
+	// conversions
+    /* get(): sets the calling object to hold the active points of Points
+     * (all of which will be active). The dimension is the highest
+     * dimension in Points, lower-dimensional vectors are padded with 0.0-s.
+     * Returns the calling object.
+     */
+    Coords_& get(const Points_& Points);
+
+    /* put(): copies the active points into the active points of Points
+     * in the same order. The dimension of the vectors in Points is
+     * set to dim(). Return value: 1 if OK, 0 if the active point numbers
+     * differ (Points is not modified then).
+     */
+    int put(Points_& Points) const;
+
+	// arithmetics
+    /* Coords+=Vector, Coords-=Vector: adds/subtracts Vector to all active
+     * points. If the dimensions don't match, then nothing happens (a
+     * warning is printed). Returns calling object.
+     */
+    Coords_& operator+=(const Vector_& Vector);
+    Coords_& operator-=(const Vector_& Vector);
+
+    /* centroid(): returns the centroid of the active points or
+     * a 3D null-vector (with a warning) if there are no active points.
+     */
+    Vector_ centroid() const;
+
+	// distance matrices
+    /* dist_mat(Dist), dist_mat2(Dist2): construct the interpoint distance
+     * and squared distance matrices using the active points only.
+     * The matrix size will be adjusted silently if necessary.
+     * If all points are active, then AVX2/AVX-512 code is used on x86-64
+     * processors supporting it (GCC only, define NO_SIMD to disable).
+     * The vectorised and the portable code give bitwise identical results.
+     * Return calling object.
+     */
+    const Coords_& dist_mat(Trimat_& Dist) const;
+    const Coords_& dist_mat2(Trimat_& Dist2) const;
+
+    /* dist_mat2(Dist2, Moved): updates the squared distance matrix Dist2
+     * which was built from the active points by dist_mat2() earlier,
+     * assuming that only the points marked in Moved (indexed over the
+     * active points) have changed since then. Only the rows and columns
+     * of the moved points are recalculated, with the same result as a
+     * full rebuild. If the size of Dist2 or Moved is not active_len(),
+     * then the whole matrix is rebuilt. Returns calling object.
+     */
+    const Coords_& dist_mat2(Trimat_& Dist2, const Bits_& Moved) const;
+
+    /* dist2(): the squared distance between the i-th and j-th active point. */
+    double dist2(unsigned int i, unsigned int j) const
+    {
+	register unsigned int k, Ai=Act[i], Aj=Act[j];
+	register const double *Xk=X;
+	register double L=0.0, D;
+	for (k=0; k<Dim; k++, Xk+=Stride)
+	{
+	    D=Xk[Ai]-Xk[Aj]; L+=D*D;
+	}
+	return(L);
+    }
+
+    // private methods
+    private:
+
+    void alloc(unsigned int N, unsigned int D);
+    void update_idx();
+    void dist_rows(Trimat_& Dist, bool Root) const;
+};
+// END OF CLASS Coords_
+
+// ==== END OF HEADER Coords.h ====
+
+#endif	/* COORDS_CLASS */
@@ -0,0 +1,66 @@
+#ifndef DISTCACHE_CLASS
+#define DISTCACHE_CLASS
+
+// ==== HEADER Distcache.h ====
+
+/* Incremental maintenance of the squared interpoint distance
+ * matrix of a Points_ object which changes only partially
+ * between refreshes.
+ */
+
+// ---- STANDARD HEADERS ----
+
+#include <stdlib.h>
+
+// ---- INCLUDE FILES ----
+
+#include "Bits.h"
+#include "Trimat.h"
+#include "Points.h"
+#include "Coords.h"
+
+// ==== CLASSES ====
+
+/* Class Distcache_ : remembers the points from which a squared
+ * distance matrix was made. On the next refresh the points are
+ * compared to the remembered ones and only the rows and columns
+ * of the points that moved are recalculated, unless too many of
+ * them moved, in which case the whole matrix is rebuilt. The
+ * results are the same as with Points_::dist_mat2().
+ * The distance matrix must not be modified between refreshes
+ * other than through the calling object: call forget() if it was.
+ */
+class Distcache_
+{
+    // data
+    private:
+
+    Coords_ Last, Cur;	// the points at the last refresh and now
+    Bits_ Lastmask, Moved;  // activation mask at the last refresh, moved points
+    bool Valid;	    // false if there was no refresh or forget() was called
+
+    // methods
+    public:
+
+	// constructor
+    Distcache_(): Last(0), Cur(0), Valid(false) {}
+
+	// refresh
+    /* dist_mat2(): makes Dist2 the squared distance matrix of the active
+     * points in Points (cf. Points_::dist_mat2()). If Dist2 was made by the
+     * previous call for the same points, then only the entries of the
+     * points that moved since then are recalculated.
+     * Returns the number of points whose rows were recalculated.
+     */
+    unsigned int dist_mat2(const Points_& Points, Trimat_& Dist2);
+
+    /* forget(): the next dist_mat2() call will rebuild the whole matrix.
+     * Call this if the matrix was modified elsewhere.
+     */
+    void forget() { Valid=false; }
+};
+// END OF CLASS Distcache_
+
+// ==== END OF HEADER Distcache.h ====
+
+#endif	/* DISTCACHE_CLASS */
@@ -71,6 +71,12 @@ class Hirot_
     int best_rot(const Points_& X, const Points_& Y, const Vector_& W);
     int best_rot(const Points_& X, const Points_& Y);
     
+    /* The same for the points in the views X and Y (the i-th point
+     * in X corresponds to the i-th point in Y).
+     */
+    int best_rot(const Ptview_& X, const Ptview_& Y, const Vector_& W);
+    int best_rot(const Ptview_& X, const Ptview_& Y);
+    
     /* best_rotflip(): the same as hi_rot() but there's no check for
      * the det sign. This routine constructs a unitary transform matrix that
      * flips the conformations if necessary to achieve optimal superposition.
@@ -102,11 +108,12 @@ class Hirot_
     int get_rot(unsigned int Dim);
     void get_rotflip(unsigned int Dim);
     
-    static int check_data(const Points_& X, const Points_& Y);
-    static int check_data(const Points_& X, const Points_& Y, const Vector_& W);
+    /* P_ is Points_ or Ptview_ */
+    template <class P_> static int check_data(const P_& X, const P_& Y);
+    template <class P_> static int check_data(const P_& X, const P_& Y, const Vector_& W);
     
-    void make_mixtensor(const Points_& X, const Points_& Y);
-    void make_mixtensor(const Points_& X, const Points_& Y, const Vector_& W);
+    template <class P_> void make_mixtensor(const P_& X, const P_& Y);
+    template <class P_> void make_mixtensor(const P_& X, const P_& Y, const Vector_& W);
     
 };
 // END OF CLASS Hirot_
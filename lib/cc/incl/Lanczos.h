@@ -0,0 +1,104 @@
+#ifndef LANCZOS_CLASS
+#define LANCZOS_CLASS
+
+// ==== PROJECT DRAGON: HEADER Lanczos.h ====
+
+/* Partial diagonalisation of real symmetric matrices:
+ * the largest eigenvalues and the corresponding eigenvectors
+ * are obtained by the Lanczos method.
+ */
+
+// ---- STANDARD HEADERS ----
+
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <iostream.h>
+
+// ---- MODULES ----
+
+#include "Trimat.h"
+#include "Sqmat.h"
+#include "Matrix.h"
+#include "Vector.h"
+
+// ==== CLASSES ====
+
+/* Lanczos_: finds the Evno largest eigenvalues and the corresponding
+ * eigenvectors of a symmetric matrix stored as a Trimat_. A Krylov
+ * subspace is built from a fixed block of starting vectors by
+ * band (block) Lanczos steps with full reorthogonalisation, until the
+ * residuals of the Evno leading Ritz pairs drop below a tolerance.
+ * A single starting vector would find only one eigenvector of a
+ * multiple eigenvalue: a block of Blk vectors finds up to Blk of them.
+ * If the leading Ritz values contain a cluster of at least Blk
+ * (nearly) equal values, then some eigenvectors may be missing,
+ * and an error is returned as well. The cost is O(N^2) per step,
+ * so this is much faster than a full diagonalisation if Evno<<N.
+ * If the iteration does not converge within the maximal subspace
+ * size, then an error is returned and the caller should fall back
+ * to one of the full methods (cf. Ql.h, Rsmdiag.h).
+ * The workspaces are kept between calls. When a series of slightly
+ * changing matrices is diagonalised, the eigenvectors of the
+ * previous call can be used to warm-start the next one.
+ */
+class Lanczos_
+{
+    // data
+    private:
+
+    Matrix_ Basis;	// the Lanczos vectors in the rows
+    Trimat_ Band;	// the coefficients of the projection (banded)
+    Vector_ W;		// the next Lanczos vector
+    Trimat_ Tri;	// the projected matrix...
+    Vector_ Theta;	// ...its eigenvalues (Ritz values)...
+    Sqmat_ S;		// ...and eigenvectors
+    Matrix_ Prev;	// saved eigenvectors in the rows for warm starts...
+    unsigned int Prevno;    // ...and their number (0 if none)
+
+    // methods
+    public:
+
+	// ctor
+    Lanczos_(): Basis(1, 1), Band(1), W(1),
+	Tri(1), Theta(1), S(1), Prev(1, 1), Prevno(0) {}
+
+	// diagonalisation
+    /* top_eigen(): obtains the Evno largest eigenvalues of the symmetric
+     * matrix Mat in decreasing order and puts them into the first Evno
+     * elements of Eval. The corresponding eigenvectors are placed into the
+     * first Evno columns of Evec. The sizes of Eval and Evec are set to
+     * the size of Mat silently, the other elements are undefined.
+     * If Warm is true (default false), then the iteration is started from
+     * the eigenvectors saved by the previous warm call if the size of Mat
+     * did not change, and the new eigenvectors are saved for the next call.
+     * If the warm start does not converge, then a cold start is tried.
+     * Return value: 0 if OK, 1 if the iteration did not converge
+     * or the eigenvectors of a multiple eigenvalue may be incomplete.
+     */
+    int top_eigen(const Trimat_& Mat, unsigned int Evno,
+	Vector_& Eval, Sqmat_& Evec, bool Warm=false);
+    
+    /* forget(): discards the saved eigenvectors so that the next
+     * warm call will start from scratch.
+     */
+    void forget() { Prevno=0; }
+
+    // hidden methods
+    private:
+
+    int krylov(const Trimat_& Mat, unsigned int Evno,
+	bool Warm, unsigned int& m);
+    int start_vec(unsigned int Vidx, unsigned int Blk, bool Warm);
+    double orthog(double *X, unsigned int Vno, int Col);
+    unsigned int ritz_conv(unsigned int m, unsigned int Vecno,
+	unsigned int Evno, double Tol);
+    static bool multi_eval(const Vector_& Theta, unsigned int m,
+	unsigned int Blk, unsigned int Evno);
+    static void tri_mult(const Trimat_& Mat, const double *X, double *Y);
+};
+// END OF CLASS Lanczos_
+
+// ==== END OF HEADER Lanczos.h ====
+
+#endif	/* LANCZOS_CLASS */
@@ -182,6 +182,7 @@ class Matbase_
     double** alloc_rows(unsigned int Rowno);
     double* alloc_elems(unsigned int Elemno);
     virtual void init_rowptrs(unsigned int Colno) =0;
+    void swap_base(Matbase_& Mb);
     
         // error messages
     enum Errtype_ { NO_MEM, DIV_BY_ZERO, BAD_ROWRANGE, BAD_COLRANGE, DIM_MISMATCH };
@@ -64,6 +64,11 @@ class Matrix_ : public Rectbase_
     /* Assignment */
     Matrix_& operator=(const Matrix_& Mat);
     
+    /* swap(): exchanges the contents of the calling object and Mat.
+     * Only the storage addresses are swapped, the elements are not copied.
+     */
+    void swap(Matrix_& Mat);
+    
 	// size
     /* set_size(): resets the size to Rno x Cno. The upper left
      * corner overlap is preserved, if the new row/col number is
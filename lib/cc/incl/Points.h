@@ -27,6 +27,8 @@
 
 // ==== CLASSES ====
 
+class Coords_;	    // column-wise coordinates (cf. Coords.h)
+
 /* Class Points_ : derived from the maskable array template class
  * Maskarr_, this class stores Vector_ objects (double-precision
  * vectors) in a maskable array. Items can be activated and
@@ -121,9 +123,14 @@ class Points_: public Maskarr_<Vector_>
      * and squared distance matrices using the active points only. The matrices
      * will not be touched if there are no active points or if the active
      * point dimensions don't match. The matrix size will be adjusted
-     * silently if necessary. Return calling object.
+     * silently if necessary. The coordinates are copied into the
+     * column-wise Work object first: callers who make distance matrices
+     * repeatedly should keep one, the versions without Work
+     * use a temporary. Return calling object.
      */
+    const Points_& dist_mat(Trimat_& Dist, Coords_& Work) const;
     const Points_& dist_mat(Trimat_& Dist) const;
+    const Points_& dist_mat2(Trimat_& Dist2, Coords_& Work) const;
     const Points_& dist_mat2(Trimat_& Dist2) const;
     
     // output
@@ -137,6 +144,48 @@ class Points_: public Maskarr_<Vector_>
 };
 // END OF CLASS Points_
 
+/* Class Ptview_ : a masked view (see Maskview_) of a Points_ object,
+ * typically of one cluster, which can be used instead of masking
+ * the whole object. Provides the "overall" operations of Points_
+ * which work on the points in the view only. The results are
+ * the same as those of the Points_ methods when the points in
+ * the view are the active ones.
+ */
+class Ptview_: public Maskview_<Vector_>
+{
+    // methods
+    public:
+    
+	// constructors
+    /* Inits to an empty view. */
+    Ptview_() {}
+    
+    /* Inits to view the points of Points the storage indices of which
+     * are in Idx[0..N-1]. The activation mask of Points is ignored.
+     */
+    Ptview_(Points_& Points, const unsigned int *Idx, unsigned int N):
+	Maskview_<Vector_>(Points, Idx, N) {}
+    
+	// dimension
+    /* dim_high(): returns the highest dimension of the points in the view
+     * or 0 if the view is empty.
+     * dim(): returns the dimension of the points in the view if they
+     * have the same dimension or 0 if the dimensions are different
+     * or the view is empty.
+     */
+    unsigned int dim_high() const;
+    unsigned int dim() const;
+    
+	// arithmetics
+    /* The same as the corresponding Points_ methods. */
+    Ptview_& operator*=(const Sqmat_& Matrix);
+    Ptview_& operator+=(const Vector_& Vector);
+    Ptview_& operator-=(const Vector_& Vector);
+    Vector_ centroid(const Vector_& W) const;
+    Vector_ centroid() const;
+};
+// END OF CLASS Ptview_
+
 // ---- PROTOTYPES ----
 
 ostream& operator<<(ostream& Out, const Points_& Points);
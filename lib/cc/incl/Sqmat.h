@@ -63,6 +63,11 @@ class Sqmat_ : public Rectbase_, public Sqbase_
 	// assignment
     Sqmat_& operator=(const Sqmat_& Sq);
     
+    /* swap(): exchanges the contents of the calling object and Sq.
+     * Only the storage addresses are swapped, the elements are not copied.
+     */
+    void swap(Sqmat_& Sq) { if (this!=&Sq) swap_base(Sq); }
+    
 	// size
     /* set_size(): resets the size to Size x Size. The upper left
      * corner overlap is preserved, if the new size is
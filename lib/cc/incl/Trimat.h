@@ -32,6 +32,9 @@
  */
 class Trimat_ : public Sqbase_
 {
+    /* data */
+    unsigned int Cap;	// the storage can hold a Cap x Cap matrix
+    
     /* public methods interface */
     public:
     
@@ -58,8 +61,16 @@ class Trimat_ : public Sqbase_
     virtual ~Trimat_() { delete [] Rows[0]; }
     
 	// assignment
+    /* The storage of the calling object is reused if Tri
+     * is not larger than its capacity (cf. set_size()).
+     */
     Trimat_& operator=(const Trimat_& Tri);
     
+    /* swap(): exchanges the contents of the calling object and Tri.
+     * Only the storage addresses are swapped, the elements are not copied.
+     */
+    void swap(Trimat_& Tri);
+    
 	// Conversion
     /* Converts a Trimat_ object into a Sqmat_ object, i.e.
      * makes a full symmetric matrix out of the sparse representation.
@@ -79,6 +90,8 @@ class Trimat_ : public Sqbase_
      * larger than the old then the new rows will be set to 0.0, 
      * if less then the upper triangle will be preserved and the extra
      * rows will be lost. Zero size not allowed (no action).
+     * The storage is kept when shrinking and is reallocated only if
+     * Size exceeds the largest size the object has held so far.
      */
     void set_size(unsigned int Size);
     
@@ -0,0 +1,289 @@
+#ifndef VEC3_CLASS
+#define VEC3_CLASS
+
+// ==== HEADER Vec3.h ====
+
+/* Fixed-size 3D vectors and 3x3 matrices for the 3D-only code.
+ * Complements the Vector_ and Sqmat_ classes.
+ */
+
+// ---- STANDARD HEADERS ----
+
+#include <math.h>
+#include <float.h>
+
+// ---- INCLUDE FILES ----
+
+#include "Vector.h"	// conversions
+#include "Rectbase.h"	// the Sqmat_ and Matrix_ base class
+
+// ==== CLASSES ====
+
+/* Class Vec3_ : 3D double-precision vectors. The coordinates are
+ * kept in the object itself, so no heap allocation takes place
+ * and temporaries cost only a few words on the stack. All methods
+ * are inline. The arithmetics is done in the same order as
+ * in Vector_, so that the results are the same for 3D vectors.
+ * Conversions from and to Vector_ (and thus to the points of
+ * a Points_ object) are provided.
+ */
+class Vec3_
+{
+    // data
+    double X[3];
+
+    // methods
+    public:
+
+	// constructors
+    /* Inits to the null-vector. */
+    Vec3_() { X[0]=X[1]=X[2]=0.0; }
+
+    /* Inits to (X0, X1, X2). */
+    Vec3_(double X0, double X1, double X2) { X[0]=X0; X[1]=X1; X[2]=X2; }
+
+    /* Inits with the first 3 coordinates of Vec (cf. get()). */
+    explicit Vec3_(const Vector_& Vec) { get(Vec); }
+
+	// access
+    /* [] is unchecked. */
+    double& operator[](unsigned int Idx) { return(X[Idx]); }
+    double operator[](unsigned int Idx) const { return(X[Idx]); }
+
+    /* set_values(): sets all coordinates to Val (default=0.0) */
+    Vec3_& set_values(double Val=0.0) { X[0]=X[1]=X[2]=Val; return(*this); }
+
+	// conversions
+    /* get(): copies the first 3 coordinates of Vec into the calling
+     * object. Lower-dimensional vectors are padded with 0.0-s.
+     * Returns the calling object.
+     */
+    Vec3_& get(const Vector_& Vec)
+    {
+	register unsigned int i, D=(Vec.dim()<3)? Vec.dim(): 3;
+	for (i=0; i<D; i++) X[i]=Vec[i];
+	for (; i<3; i++) X[i]=0.0;
+	return(*this);
+    }
+
+    /* put(): copies the coordinates into Vec the dimension of which
+     * is set to 3 if necessary. Returns Vec.
+     */
+    Vector_& put(Vector_& Vec) const
+    {
+	if (Vec.dim()!=3) Vec.dim(3);
+	Vec[0]=X[0]; Vec[1]=X[1]; Vec[2]=X[2];
+	return(Vec);
+    }
+
+	// arithmetics
+    Vec3_& operator+=(const Vec3_& V)
+	{ X[0]+=V.X[0]; X[1]+=V.X[1]; X[2]+=V.X[2]; return(*this); }
+    Vec3_& operator-=(const Vec3_& V)
+	{ X[0]-=V.X[0]; X[1]-=V.X[1]; X[2]-=V.X[2]; return(*this); }
+    Vec3_& operator*=(double Scal)
+	{ X[0]*=Scal; X[1]*=Scal; X[2]*=Scal; return(*this); }
+    Vec3_ operator+(const Vec3_& V) const { Vec3_ T(*this); return(T+=V); }
+    Vec3_ operator-(const Vec3_& V) const { Vec3_ T(*this); return(T-=V); }
+    Vec3_ operator*(double Scal) const { Vec3_ T(*this); return(T*=Scal); }
+    friend Vec3_ operator*(double Scal, const Vec3_& V) { Vec3_ T(V); return(T*=Scal); }
+
+    /* Division by scalars smaller than DBL_EPSILON is silently
+     * ignored (Vector_ prints a warning).
+     */
+    Vec3_& operator/=(double Scal)
+    {
+	if (fabs(Scal)>=DBL_EPSILON) (*this)*=1.0/Scal;
+	return(*this);
+    }
+    Vec3_ operator/(double Scal) const { Vec3_ T(*this); return(T/=Scal); }
+
+	// vectorial products
+    /* the scalar product */
+    double operator*(const Vec3_& V) const
+    {
+	register double Prd=0.0;
+	Prd+=X[0]*V.X[0]; Prd+=X[1]*V.X[1]; Prd+=X[2]*V.X[2];
+	return(Prd);
+    }
+
+    /* cross_prod(): the cross-product of V1 and V2. */
+    friend Vec3_ cross_prod(const Vec3_& V1, const Vec3_& V2)
+    {
+	return(Vec3_(V1.X[1]*V2.X[2]-V1.X[2]*V2.X[1],
+	    V1.X[2]*V2.X[0]-V1.X[0]*V2.X[2],
+	    V1.X[0]*V2.X[1]-V1.X[1]*V2.X[0]));
+    }
+
+	// modulus
+    /* vec_len(), vec_len2(): the Euclidean norm and its square. */
+    double vec_len() const { return(sqrt(vec_len2())); }
+    double vec_len2() const { return((*this)*(*this)); }
+
+    /* vec_norm(): normalises the calling object to a unit vector.
+     * Returns the original length. If the length<DBL_EPSILON
+     * then the calling object will be set to an exact null-vector
+     * and 0.0 will be returned.
+     */
+    double vec_norm()
+    {
+	register double L=vec_len();
+	if (L<DBL_EPSILON) { L=0.0; set_values(); }
+	else (*this)*=1.0/L;
+	return(L);
+    }
+
+    /* diff_len2(): the squared length of V1-V2. */
+    friend double diff_len2(const Vec3_& V1, const Vec3_& V2)
+    {
+	register unsigned int i;
+	register double D, L=0.0;
+	for (i=0; i<3; i++)
+	{
+	    D=V1.X[i]-V2.X[i]; L+=D*D;
+	}
+	return(L);
+    }
+};
+// END OF CLASS Vec3_
+
+/* Class Mat3_ : 3x3 double-precision matrices stored in the object.
+ * All methods are inline. Products are summed in the same order
+ * as in Sqmat_ and Matrix_. Conversions from and to the
+ * rectangular matrix classes are provided.
+ */
+class Mat3_
+{
+    // data
+    double X[3][3];
+
+    // methods
+    public:
+
+	// constructors
+    /* Inits to the null matrix. */
+    Mat3_() { set_values(); }
+
+    /* Inits with the upper left 3x3 corner of Mat (cf. get()). */
+    explicit Mat3_(const Rectbase_& Mat) { get(Mat); }
+
+	// access
+    /* [i] returns the address of the i-th row, no range checks. */
+    double *operator[](unsigned int Idx) { return(X[Idx]); }
+    const double *operator[](unsigned int Idx) const { return(X[Idx]); }
+
+    /* row(), col(): the Idx-th row and column as vectors */
+    Vec3_ row(unsigned int Idx) const
+	{ return(Vec3_(X[Idx][0], X[Idx][1], X[Idx][2])); }
+    Vec3_ col(unsigned int Idx) const
+	{ return(Vec3_(X[0][Idx], X[1][Idx], X[2][Idx])); }
+
+    /* set_values(): sets all elements to Val (default 0.0). */
+    Mat3_& set_values(double Val=0.0)
+    {
+	register unsigned int i, j;
+	for (i=0; i<3; i++)
+	    for (j=0; j<3; j++) X[i][j]=Val;
+	return(*this);
+    }
+
+    /* diag_matrix(): sets the diagonal to Dval, the other elements
+     * to 0.0. Without a parameter it produces the unit matrix.
+     */
+    Mat3_& diag_matrix(double Dval=1.0)
+    {
+	set_values(); X[0][0]=X[1][1]=X[2][2]=Dval;
+	return(*this);
+    }
+
+	// conversions
+    /* get(): copies the upper left 3x3 corner of Mat into the
+     * calling object. Missing rows and columns are padded with 0.0-s.
+     * Returns the calling object.
+     */
+    Mat3_& get(const Rectbase_& Mat)
+    {
+	register unsigned int i, j,
+	    R=(Mat.rno()<3)? Mat.rno(): 3, C=(Mat.cno()<3)? Mat.cno(): 3;
+	set_values();
+	for (i=0; i<R; i++)
+	    for (j=0; j<C; j++) X[i][j]=Mat[i][j];
+	return(*this);
+    }
+
+    /* put(): copies the elements into the upper left 3x3 corner of Mat
+     * which must be at least 3x3. Returns Mat.
+     */
+    Rectbase_& put(Rectbase_& Mat) const
+    {
+	register unsigned int i, j;
+	for (i=0; i<3; i++)
+	    for (j=0; j<3; j++) Mat[i][j]=X[i][j];
+	return(Mat);
+    }
+
+	// arithmetics
+    /* Mat*=Scal: multiplies all elements by Scal. */
+    Mat3_& operator*=(double Scal)
+    {
+	register unsigned int i, j;
+	for (i=0; i<3; i++)
+	    for (j=0; j<3; j++) X[i][j]*=Scal;
+	return(*this);
+    }
+
+	// linear algebra
+    /* Matrix*vector product. */
+    Vec3_ operator*(const Vec3_& V) const
+    {
+	Vec3_ Prod;
+	register unsigned int i, j;
+	register double Temp;
+	for (i=0; i<3; i++)
+	{
+	    Temp=0.0;
+	    for (j=0; j<3; j++) Temp+=X[i][j]*V[j];
+	    Prod[i]=Temp;
+	}
+	return(Prod);
+    }
+
+    /* Matrix product. */
+    Mat3_ operator*(const Mat3_& M) const
+    {
+	Mat3_ Prod;
+	register unsigned int i, j, k;
+	register double Temp;
+	for (i=0; i<3; i++)
+	    for (j=0; j<3; j++)
+	    {
+		Temp=0.0;
+		for (k=0; k<3; k++) Temp+=X[i][k]*M.X[k][j];
+		Prod.X[i][j]=Temp;
+	    }
+	return(Prod);
+    }
+
+    /* get_transpose(): returns the transposed calling object. */
+    Mat3_ get_transpose() const
+    {
+	Mat3_ T;
+	register unsigned int i, j;
+	for (i=0; i<3; i++)
+	    for (j=0; j<3; j++) T.X[i][j]=X[j][i];
+	return(T);
+    }
+
+    /* det(): the determinant. */
+    double det() const
+    {
+	return(X[0][0]*(X[1][1]*X[2][2]-X[1][2]*X[2][1])-
+	    X[0][1]*(X[1][0]*X[2][2]-X[1][2]*X[2][0])+
+	    X[0][2]*(X[1][0]*X[2][1]-X[1][1]*X[2][0]));
+    }
+};
+// END OF CLASS Mat3_
+
+// ==== END OF HEADER Vec3.h ====
+
+#endif	/* VEC3_CLASS */
@@ -71,6 +71,11 @@ class Vector_
     /* set_values(): sets all coordinates to Val (default=0.0) */
     Vector_& set_values(double Val=0.0);
     
+    /* swap(): exchanges the coordinates (and dimensions) of the calling
+     * object and Vec without copying them.
+     */
+    void swap(Vector_& Vec);
+
         // dimension access
     /* dim(): with no parameters, returns the current dimension.
      * With the parameter N, sets the dimension to N. If N==Dim or there is
@@ -85,7 +90,8 @@ class Vector_
     /* Assignment, vector addition and subtraction, postfix
      * multiplication and division by scalar. All operations
      * are available in in-place versions as well. The assignment
-     * is destructive, it resets the dimension of the target.
+     * is destructive, it resets the dimension of the target
+     * (the storage is reused if the dimensions are the same).
      * In case of a dim mismatch, the += and -= operators 
      * do not modify the target, the + and - operators return
      * the left operand.
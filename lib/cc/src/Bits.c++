@@ -125,6 +125,19 @@ Bits_& Bits_::operator=(const Bits_& Other)
 }
 // END of =
 
+/* swap(): exchanges the contents of the calling object and Other
+ * without copying the bits.
+ */
+void Bits_::swap(Bits_& Other)
+{
+    if (this==&Other) return;
+    
+    unsigned int *Tb=B; B=Other.B; Other.B=Tb;
+    unsigned int Tu=Cs; Cs=Other.Cs; Other.Cs=Tu;
+    Tu=Bs; Bs=Other.Bs; Other.Bs=Tu;
+}
+// END of swap()
+
 // ---- Equality ----
 
 /* ==,!=: return an appropriate Boolean value. Two Bits_ arrays are
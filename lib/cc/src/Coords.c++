@@ -0,0 +1,495 @@
+// ==== MEMBER FUNCTIONS Coords.c++ ====
+
+/* Point coordinates stored column-wise ("structure of arrays")
+ * for the time-critical loops. Complements the Points_ class.
+ */
+
+// ---- CLASS HEADER ----
+
+#include "Coords.h"
+
+// ---- DEFINITIONS ----
+
+#define COORDS_ALIGN 4	// columns start at multiples of this many doubles
+
+/* Vectorised distance kernels for x86-64 with runtime dispatch.
+ * Needs GCC 4.9 or later for the target attributes and
+ * __builtin_cpu_supports(). Define NO_SIMD to use the portable code only.
+ */
+#if !defined(NO_SIMD) && defined(__GNUC__) && defined(__x86_64__) && \
+    (__GNUC__>4 || __GNUC__==4 && __GNUC_MINOR__>=9)
+#define COORDS_SIMD
+#include <immintrin.h>
+#endif
+
+// ==== STATIC FUNCTIONS ====
+
+#ifdef COORDS_SIMD
+
+/* A distance kernel fills the first i elements of Row with the squared
+ * (Root==false) or plain (Root==true) distances between point i and the
+ * points 0..i-1. X points to Dim columns Stride apart. The squares
+ * of the coordinate differences are summed for k=0..Dim-1 in this order
+ * and no fused multiply-adds are allowed, so the results are bitwise
+ * identical to diff_len2() and sqrt() (which is exactly rounded).
+ */
+typedef void (*Distkern_)(const double *X, unsigned int Stride,
+	unsigned int Dim, unsigned int i, double *Row, bool Root);
+
+/* row_tail(): the scalar part of the kernels for points j=From..i-1. */
+static inline void row_tail(const double *X, unsigned int Stride,
+	unsigned int Dim, unsigned int i, unsigned int From, double *Row, bool Root)
+{
+    register unsigned int j, k;
+    register const double *Xk;
+    register double L, D;
+
+    for (j=From; j<i; j++)
+    {
+	L=0.0;
+	for (k=0, Xk=X; k<Dim; k++, Xk+=Stride)
+	{
+	    D=Xk[i]-Xk[j]; L+=D*D;
+	}
+	Row[j]=Root? sqrt(L): L;
+    }
+}
+
+/* row_avx2(): 4 distances at a time. AVX2 has no FMA by itself. */
+__attribute__((target("avx2")))
+static void row_avx2(const double *X, unsigned int Stride,
+	unsigned int Dim, unsigned int i, double *Row, bool Root)
+{
+    register unsigned int j, k;
+    register const double *Xk;
+    __m256d L, D;
+
+    for (j=0; j+4<=i; j+=4)
+    {
+	L=_mm256_setzero_pd();
+	for (k=0, Xk=X; k<Dim; k++, Xk+=Stride)
+	{
+	    D=_mm256_sub_pd(_mm256_set1_pd(Xk[i]), _mm256_load_pd(Xk+j));
+	    L=_mm256_add_pd(L, _mm256_mul_pd(D, D));
+	}
+	if (Root) L=_mm256_sqrt_pd(L);
+	_mm256_storeu_pd(Row+j, L);
+    }
+    row_tail(X, Stride, Dim, i, j, Row, Root);
+}
+
+/* row_avx512(): 8 distances at a time. AVX-512F implies FMA,
+ * contraction must be switched off explicitly.
+ */
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static void row_avx512(const double *X, unsigned int Stride,
+	unsigned int Dim, unsigned int i, double *Row, bool Root)
+{
+    register unsigned int j, k;
+    register const double *Xk;
+    __m512d L, D;
+
+    for (j=0; j+8<=i; j+=8)
+    {
+	L=_mm512_setzero_pd();
+	for (k=0, Xk=X; k<Dim; k++, Xk+=Stride)
+	{
+	    D=_mm512_sub_pd(_mm512_set1_pd(Xk[i]), _mm512_loadu_pd(Xk+j));
+	    L=_mm512_add_pd(L, _mm512_mul_pd(D, D));
+	}
+	if (Root) L=_mm512_sqrt_pd(L);
+	_mm512_storeu_pd(Row+j, L);
+    }
+    row_tail(X, Stride, Dim, i, j, Row, Root);
+}
+
+/* dist_kernel(): returns the best kernel for the processor
+ * or NULL if neither AVX2 nor AVX-512F are available.
+ * Called only once to initialise Distkern below.
+ */
+static Distkern_ dist_kernel()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return(row_avx512);
+    if (__builtin_cpu_supports("avx2")) return(row_avx2);
+    return(NULL);
+}
+
+/* The kernel is chosen during static initialisation, i.e. before
+ * main() and any threads are started, so that it can be read
+ * by all threads without locking. (Until then it is NULL and
+ * the portable code is used which gives the same results.)
+ */
+static const Distkern_ Distkern=dist_kernel();
+
+#endif	/* COORDS_SIMD */
+
+// ==== Coords_ MEMBER FUNCTIONS ====
+
+// ---- Constructors ----
+
+/* Initialises to hold N (default=1) points, each D-dimensional
+ * (default=3). All points will be active, the coordinates are 0.0.
+ */
+Coords_::Coords_(unsigned int N, unsigned int D):
+	Block(NULL), X(NULL), Len(0), Dim(0), Stride(0),
+	Cap(0), Maxlen(0), Act(NULL), Actno(0)
+{
+    len_dim(N, D);
+}
+
+/* Initialises with the active points of Points (cf. get()). */
+Coords_::Coords_(const Points_& Points):
+	Block(NULL), X(NULL), Len(0), Dim(0), Stride(0),
+	Cap(0), Maxlen(0), Act(NULL), Actno(0)
+{
+    get(Points);
+}
+
+Coords_::Coords_(const Coords_& Coords):
+	Block(NULL), X(NULL), Len(0), Dim(0), Stride(0),
+	Cap(0), Maxlen(0), Act(NULL), Actno(0)
+{
+    *this=Coords;
+}
+
+Coords_& Coords_::operator=(const Coords_& Coords)
+{
+    if (this==&Coords) return(*this);
+    if (Len!=Coords.Len || Dim!=Coords.Dim)
+	len_dim(Coords.Len, Coords.Dim);
+    if (Dim && Stride)
+	memcpy(X, Coords.X, Dim*Stride*sizeof(double));	// same Stride
+    mask(Coords.Mask);
+    return(*this);
+}
+
+/* swap(): exchanges the contents of the calling object and Coords.
+ * Only the storage addresses are swapped, the coordinates are not copied.
+ */
+void Coords_::swap(Coords_& Coords)
+{
+    if (this==&Coords) return;
+
+    double *Tb=Block; Block=Coords.Block; Coords.Block=Tb;
+    Tb=X; X=Coords.X; Coords.X=Tb;
+
+    unsigned int Tu=Len; Len=Coords.Len; Coords.Len=Tu;
+    Tu=Dim; Dim=Coords.Dim; Coords.Dim=Tu;
+    Tu=Stride; Stride=Coords.Stride; Coords.Stride=Tu;
+    Tu=Cap; Cap=Coords.Cap; Coords.Cap=Tu;
+    Tu=Maxlen; Maxlen=Coords.Maxlen; Coords.Maxlen=Tu;
+    Tu=Actno; Actno=Coords.Actno; Coords.Actno=Tu;
+
+    unsigned int *Ta=Act; Act=Coords.Act; Coords.Act=Ta;
+
+    Mask.swap(Coords.Mask);
+}
+// END of swap()
+
+// ---- Size ----
+
+/* len_dim(): adjusts the size to N points in D dimensions (default 3)
+ * and switches on all points. Reallocates only if the new size
+ * does not fit into the old storage. The coordinates will be 0.0.
+ */
+void Coords_::len_dim(unsigned int N, unsigned int D)
+{
+    unsigned int Newstride=(N+COORDS_ALIGN-1)/COORDS_ALIGN*COORDS_ALIGN;
+
+    if (Block==NULL || N>Maxlen || D*Newstride>Cap)
+	alloc(N, D);
+    Len=N; Dim=D; Stride=Newstride;
+    if (Dim && Stride) memset(X, 0, Dim*Stride*sizeof(double));
+    Mask.len(Len); Mask.set_values(true);
+    update_idx();
+}
+// END of len_dim()
+
+// ---- Activation ----
+
+/* mask(Newmask): sets the activation mask to Newmask which must
+ * be len() long, otherwise nothing happens (with a warning).
+ * mask(Value): sets all activation bits to Value.
+ * Both versions return the old mask.
+ */
+Bits_ Coords_::mask(const Bits_& Newmask)
+{
+    Bits_ Oldmask(Mask);
+    if (Newmask.len()!=Len)
+    {
+	cerr<<"? Coords_::mask(): Mask length "<<Newmask.len()
+	    <<" != "<<Len<<", ignored\n";
+	return(Oldmask);
+    }
+    Mask=Newmask; update_idx();
+    return(Oldmask);
+}
+
+Bits_ Coords_::mask(bool Value)
+{
+    Bits_ Oldmask(Mask);
+    Mask.set_values(Value); update_idx();
+    return(Oldmask);
+}
+// END of mask()
+
+// ---- Conversions ----
+
+/* get(): sets the calling object to hold the active points of Points
+ * (all of which will be active). The dimension is the highest
+ * dimension in Points, lower-dimensional vectors are padded with 0.0-s.
+ * Returns the calling object.
+ */
+Coords_& Coords_::get(const Points_& Points)
+{
+    register unsigned int i, d, D, N=Points.active_len();
+
+    len_dim(N, Points.dim_high());
+    for (i=0; i<N; i++)
+    {
+	const Vector_& Vec=Points[i];
+	D=Vec.dim();
+	for (d=0; d<D; d++) X[d*Stride+i]=Vec[d];
+    }
+    return(*this);
+}
+// END of get()
+
+/* put(): copies the active points into the active points of Points
+ * in the same order. The dimension of the vectors in Points is
+ * set to dim(). Return value: 1 if OK, 0 if the active point numbers
+ * differ (Points is not modified then).
+ */
+int Coords_::put(Points_& Points) const
+{
+    if (Points.active_len()!=Actno)
+    {
+	cerr<<"? Coords_::put(): Active point number mismatch ("
+	    <<Points.active_len()<<"!="<<Actno<<")\n";
+	return(0);
+    }
+
+    register unsigned int i, d, k;
+    for (i=0; i<Actno; i++)
+    {
+	Vector_& Vec=Points[i];
+	Vec.dim(Dim); k=Act[i];
+	for (d=0; d<Dim; d++) Vec[d]=X[d*Stride+k];
+    }
+    return(1);
+}
+// END of put()
+
+// ---- Arithmetics ----
+
+/* Coords+=Vector, Coords-=Vector: adds/subtracts Vector to all active
+ * points. If the dimensions don't match, then nothing happens (a
+ * warning is printed). Returns calling object.
+ */
+Coords_& Coords_::operator+=(const Vector_& Vector)
+{
+    if (Vector.dim()!=Dim)
+    {
+	cerr<<"? Coords_::operator+=(): Dim mismatch ("<<Vector.dim()<<"!="<<Dim<<")\n";
+	return(*this);
+    }
+
+    register unsigned int i, d;
+    register double *Col, V;
+    for (d=0; d<Dim; d++)
+    {
+	Col=col(d); V=Vector[d];
+	for (i=0; i<Actno; i++) Col[Act[i]]+=V;
+    }
+    return(*this);
+}
+
+Coords_& Coords_::operator-=(const Vector_& Vector)
+{
+    if (Vector.dim()!=Dim)
+    {
+	cerr<<"? Coords_::operator-=(): Dim mismatch ("<<Vector.dim()<<"!="<<Dim<<")\n";
+	return(*this);
+    }
+
+    register unsigned int i, d;
+    register double *Col, V;
+    for (d=0; d<Dim; d++)
+    {
+	Col=col(d); V=Vector[d];
+	for (i=0; i<Actno; i++) Col[Act[i]]-=V;
+    }
+    return(*this);
+}
+// END of +=, -=
+
+/* centroid(): returns the centroid of the active points or
+ * a 3D null-vector (with a warning) if there are no active points.
+ */
+Vector_ Coords_::centroid() const
+{
+    if (!Actno || !Dim)
+    {
+	cerr<<"? Coords_::centroid(): No active points, default null-vector returned\n";
+	return(Vector_(3));
+    }
+
+    Vector_ Sum(Dim);
+    register unsigned int i, d;
+    register const double *Col;
+    register double S;
+    for (d=0; d<Dim; d++)
+    {
+	Col=col(d); S=0.0;
+	for (i=0; i<Actno; i++) S+=Col[Act[i]];
+	Sum[d]=S;
+    }
+    Sum/=Actno;
+    return(Sum);
+}
+// END of centroid()
+
+// ---- Distance matrices ----
+
+/* dist_mat(Dist), dist_mat2(Dist2): construct the interpoint distance
+ * and squared distance matrices using the active points only.
+ * The matrix size will be adjusted silently if necessary.
+ * Return calling object.
+ */
+const Coords_& Coords_::dist_mat(Trimat_& Dist) const
+{
+    dist_rows(Dist, true);
+    return(*this);
+}
+// END of dist_mat()
+
+const Coords_& Coords_::dist_mat2(Trimat_& Dist2) const
+{
+    dist_rows(Dist2, false);
+    return(*this);
+}
+
+/* dist_mat2(Dist2, Moved): updates the squared distance matrix Dist2
+ * which was built from the active points by dist_mat2() earlier,
+ * assuming that only the points marked in Moved (indexed over the
+ * active points) have changed since then. Only the rows and columns
+ * of the moved points are recalculated, with the same result as a
+ * full rebuild. If the size of Dist2 or Moved is not active_len(),
+ * then the whole matrix is rebuilt. Returns calling object.
+ */
+const Coords_& Coords_::dist_mat2(Trimat_& Dist2, const Bits_& Moved) const
+{
+    if (Dist2.rno()!=Actno || Moved.len()!=Actno)
+    {
+	dist_rows(Dist2, false);
+	return(*this);
+    }
+
+    register unsigned int i, j, m, Mno=0;
+    register double *Row;
+    unsigned int *Mv=new unsigned int [Actno? Actno: 1];	// the moved points so far
+
+#ifdef COORDS_SIMD
+    Distkern_ Kern=(Actno==Len)? Distkern: NULL;
+#endif
+
+    for (i=0; i<Actno; i++)
+    {
+	Row=Dist2[i];
+	if (Moved.get_bit(i))	// the whole row
+	{
+#ifdef COORDS_SIMD
+	    if (Kern!=NULL) Kern(X, Stride, Dim, i, Row, false);
+	    else
+#endif
+	    for (j=0; j<i; j++) Row[j]=dist2(i, j);
+	    Mv[Mno++]=i;
+	}
+	else	// the columns of the moved points before i
+	    for (m=0; m<Mno; m++) Row[Mv[m]]=dist2(i, Mv[m]);
+    }
+    delete [] Mv;
+    return(*this);
+}
+// END of dist_mat2()
+
+// ==== PRIVATE METHODS ====
+
+/* alloc(): makes room for N points in D dimensions. Old contents are lost. */
+void Coords_::alloc(unsigned int N, unsigned int D)
+{
+    unsigned int Newstride=(N+COORDS_ALIGN-1)/COORDS_ALIGN*COORDS_ALIGN;
+
+    delete [] Block; delete [] Act;
+    Block=new double [D*Newstride+COORDS_ALIGN];
+    X=Block;
+    while ((unsigned long)X%(COORDS_ALIGN*sizeof(double))) X++;
+    Cap=D*Newstride; Maxlen=N;
+    Act=new unsigned int [N? N: 1];
+}
+// END of alloc()
+
+/* update_idx(): rebuilds the list of active point indices from Mask. */
+void Coords_::update_idx()
+{
+    register unsigned int i;
+    for (i=Actno=0; i<Len; i++)
+	if (Mask.get_bit(i)) Act[Actno++]=i;
+}
+// END of update_idx()
+
+/* dist_rows(): puts the squared (Root==false) or plain (Root==true)
+ * interpoint distances of the active points into Dist. If all points
+ * are active, then a vectorised kernel is used if available.
+ * Otherwise each row is built column by column (k=0..Dim-1)
+ * so that the inner loop runs over contiguous coordinates; the sum is
+ * accumulated in the same order as in diff_len2().
+ */
+void Coords_::dist_rows(Trimat_& Dist, bool Root) const
+{
+    register unsigned int i, j, k, Ai;
+    register double *Row, Xi, D;
+    register const double *Xk;
+
+    Dist.set_size(Actno);
+
+#ifdef COORDS_SIMD
+    Distkern_ Kern=Distkern;
+    if (Kern!=NULL && Actno==Len)
+    {
+	for (i=0; i<Actno; i++)
+	{
+	    Row=Dist[i];
+	    Kern(X, Stride, Dim, i, Row, Root);
+	    Row[i]=0.0;
+	}
+	return;
+    }
+#endif
+
+    for (i=0; i<Actno; i++)
+    {
+	Row=Dist[i]; Ai=Act[i];
+	for (j=0; j<=i; j++) Row[j]=0.0;
+	for (k=0; k<Dim; k++)
+	{
+	    Xk=col(k); Xi=Xk[Ai];
+	    if (Actno==Len)	// all points active, no indirection
+		for (j=0; j<i; j++)
+		{
+		    D=Xi-Xk[j]; Row[j]+=D*D;
+		}
+	    else
+		for (j=0; j<i; j++)
+		{
+		    D=Xi-Xk[Act[j]]; Row[j]+=D*D;
+		}
+	}
+	if (Root)
+	    for (j=0; j<i; j++) Row[j]=sqrt(Row[j]);
+    }
+}
+// END of dist_rows()
+
+// ==== END OF MEMBER FUNCTIONS Coords.c++ ====
@@ -0,0 +1,69 @@
+// ==== MEMBER FUNCTIONS Distcache.c++ ====
+
+/* Incremental maintenance of the squared interpoint distance
+ * matrix of a Points_ object which changes only partially
+ * between refreshes.
+ */
+
+// ---- CLASS HEADER ----
+
+#include "Distcache.h"
+
+// ---- DEFINITIONS ----
+
+/* If more than 1/DISTCACHE_MAXFRACT of the points moved, then
+ * a full (vectorised) rebuild is faster than the update.
+ */
+#define DISTCACHE_MAXFRACT 4
+
+// ==== Distcache_ MEMBER FUNCTIONS ====
+
+/* dist_mat2(): makes Dist2 the squared distance matrix of the active
+ * points in Points (cf. Points_::dist_mat2()). If Dist2 was made by the
+ * previous call for the same points, then only the entries of the
+ * points that moved since then are recalculated.
+ * Returns the number of points whose rows were recalculated.
+ */
+unsigned int Distcache_::dist_mat2(const Points_& Points, Trimat_& Dist2)
+{
+    if (!Points.dim())
+    {
+	cerr<<"? Distcache_::dist_mat2(): No active points or dim mismatch within object\n";
+	return(0);
+    }
+
+    register unsigned int i, d, N, Mno;
+
+    Cur.get(Points); N=Cur.len();
+    if (Valid && N==Last.len() && Cur.dim()==Last.dim()
+	&& Dist2.rno()==N && Points.mask()==Lastmask)
+    {
+	// find the points that moved
+	register const double *Ccol, *Lcol;
+	Moved.len(N); Moved.set_values(false);
+	for (d=0; d<Cur.dim(); d++)
+	{
+	    Ccol=Cur.col(d); Lcol=Last.col(d);
+	    for (i=0; i<N; i++)
+		if (Ccol[i]!=Lcol[i]) Moved.set_bit(i);
+	}
+	Mno=Moved.on_no();
+	if (DISTCACHE_MAXFRACT*Mno<=N)
+	{
+	    if (Mno) Cur.dist_mat2(Dist2, Moved);
+	}
+	else { Cur.dist_mat2(Dist2); Mno=N; }
+    }
+    else
+    {
+	Cur.dist_mat2(Dist2); Mno=N;
+    }
+
+    // remember the points
+    Last=Cur; Lastmask=Points.mask();
+    Valid=true;
+    return(Mno);
+}
+// END of dist_mat2()
+
+// ==== END OF MEMBER FUNCTIONS Distcache.c++ ====
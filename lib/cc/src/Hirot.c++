@@ -58,6 +58,34 @@ int Hirot_::best_rot(const Points_& X, const Points_& Y)
     make_mixtensor(X, Y);
     return(get_rot(X.dim()));
 }
+
+int Hirot_::best_rot(const Ptview_& X, const Ptview_& Y, const Vector_& W)
+{
+    // checks
+    int Actno=check_data(X, Y, W);
+    if (Actno<=0)
+    {
+	cerr<<"\n? Hirot_::best_rot(X, Y, W): Inconsistent input views\n";
+	return(-1);
+    }
+    
+    make_mixtensor(X, Y, W);
+    return(get_rot(X.dim()));
+}
+
+int Hirot_::best_rot(const Ptview_& X, const Ptview_& Y)
+{
+    // checks
+    int Actno=check_data(X, Y);
+    if (Actno<=0)
+    {
+	cerr<<"\n? Hirot_::best_rot(X, Y): Inconsistent input views\n";
+	return(-1);
+    }
+    
+    make_mixtensor(X, Y);
+    return(get_rot(X.dim()));
+}
 // END of best_rot()
 
 /* best_rotflip(): the same as hi_rot() but there's no check for
@@ -325,7 +353,8 @@ void Hirot_::get_rotflip(unsigned int Dim)
  * to the X, Y, W version).
  * Returns the no. of active points (>0) if OK. Private
  */
-int Hirot_::check_data(const Points_& X, const Points_& Y)
+template <class P_>
+int Hirot_::check_data(const P_& X, const P_& Y)
 {
     // fatal problems
     int Dim=X.dim();	// may be 0 if dims vary among actives
@@ -350,7 +379,8 @@ int Hirot_::check_data(const Points_& X, const Points_& Y)
     return(Actno);
 }
 
-int Hirot_::check_data(const Points_& X, const Points_& Y, const Vector_& W)
+template <class P_>
+int Hirot_::check_data(const P_& X, const P_& Y, const Vector_& W)
 {
     int Actno=check_data(X, Y);
     if (Actno<=0) return(Actno);
@@ -369,7 +399,8 @@ int Hirot_::check_data(const Points_& X, const Points_& Y, const Vector_& W)
  * which is at the heart of the method and hasn't got a name.
  * No dim checks are done. Private
  */
-void Hirot_::make_mixtensor(const Points_& X, const Points_& Y, const Vector_& W)
+template <class P_>
+void Hirot_::make_mixtensor(const P_& X, const P_& Y, const Vector_& W)
 {
     register unsigned int i, j, k, Dim=X.dim(), Actno=X.active_len();
     
@@ -382,7 +413,8 @@ void Hirot_::make_mixtensor(const Points_& X, const Points_& Y, const Vector_& W
     }
 }
 
-void Hirot_::make_mixtensor(const Points_& X, const Points_& Y)
+template <class P_>
+void Hirot_::make_mixtensor(const P_& X, const P_& Y)
 {
     register unsigned int i, j, k, Dim=X.dim(), Actno=X.active_len();
     
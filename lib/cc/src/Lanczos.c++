@@ -0,0 +1,337 @@
+// ==== PROJECT DRAGON: METHODS Lanczos.c++ ====
+
+/* Partial diagonalisation of real symmetric matrices:
+ * the largest eigenvalues and the corresponding eigenvectors
+ * are obtained by the Lanczos method.
+ */
+
+// ---- MODULES ----
+
+#include "Lanczos.h"
+#include "Ql.h"
+
+// ---- DEFINITIONS ----
+
+#define LANCZOS_TOL 1.0e-8	// relative residual tolerance of the Ritz pairs
+#define LANCZOS_MINEXTRA 40	// Krylov subspace size limit is...
+#define LANCZOS_MAXFACT 8	// ...LANCZOS_MAXFACT*Evno+LANCZOS_MINEXTRA
+#define LANCZOS_CHKSTEP 5	// check convergence after every this many steps
+#define LANCZOS_WARMMIX 0.1	// weight of the cold starting vector in a warm start
+#define LANCZOS_BLOCK 4	// max. no. of starting vectors (block size)
+#define LANCZOS_GAPTOL 1.0e-6	// rel. tolerance for equal Ritz values
+
+// ==== METHODS ====
+
+// ---- Diagonalisation ----
+
+/* top_eigen(): obtains the Evno largest eigenvalues of the symmetric
+ * matrix Mat in decreasing order and puts them into the first Evno
+ * elements of Eval. The corresponding eigenvectors are placed into the
+ * first Evno columns of Evec. The sizes of Eval and Evec are set to
+ * the size of Mat silently, the other elements are undefined.
+ * If Warm is true (default false), then the iteration is started from
+ * the eigenvectors saved by the previous warm call if the size of Mat
+ * did not change, and the new eigenvectors are saved for the next call.
+ * If the warm start does not converge, then a cold start is tried.
+ * Return value: 0 if OK, 1 if the iteration did not converge.
+ */
+int Lanczos_::top_eigen(const Trimat_& Mat, unsigned int Evno,
+	Vector_& Eval, Sqmat_& Evec, bool Warm)
+{
+    register unsigned int Size=Mat.rno(), i, k, r;
+    register double Dot;
+    unsigned int m;	// the final subspace size, set by krylov()
+
+    if (!Evno) return(0);
+    if (Evno>Size) Evno=Size;
+
+    int Err=1;
+    if (Warm && Prevno && Prev.cno()==Size)
+	Err=krylov(Mat, Evno, true, m);
+    if (Err) Err=krylov(Mat, Evno, false, m);
+    if (Err)
+    {
+	Prevno=0;   // forget the saved vectors, they did not help
+	return(1);
+    }
+
+    // Ritz values and vectors (m is the final subspace size)
+    Eval.dim(Size); Evec.set_size(Size);
+    for (i=0; i<Evno; i++)
+    {
+	Eval[i]=Theta[i];
+	for (r=0; r<Size; r++)
+	{
+	    for (Dot=0.0, k=0; k<m; k++)
+		Dot+=Basis[k][r]*S[k][i];
+	    Evec[r][i]=Dot;
+	}
+    }
+
+    // save the eigenvectors for the next warm start
+    if (Warm)
+    {
+	Prev.set_size(Evno, Size);
+	for (i=0; i<Evno; i++)
+	    for (r=0; r<Size; r++) Prev[i][r]=Evec[r][i];
+	Prevno=Evno;
+    }
+    return(0);
+}
+// END of top_eigen()
+
+// ---- Iteration ----
+
+/* krylov(): performs band Lanczos steps on Mat until the Evno leading
+ * Ritz pairs converge. The Krylov subspace is built from a block of
+ * Blk=min(Evno, LANCZOS_BLOCK) starting vectors (see start_vec()),
+ * so that up to Blk eigenvectors of a multiple eigenvalue can be found.
+ * The vectors are added one by one: the k-th column of the projection
+ * is Mat*q[k] which is orthogonalised against all the vectors so far,
+ * and the remainder becomes the (k+Blk)-th vector. If the remainder
+ * vanishes, then a new starting vector is taken instead.
+ * On return, the Ritz values are in Theta, the eigenvectors of the
+ * projected matrix are in S and the subspace size is in m.
+ * Return value: 0 if OK, 1 if the iteration did not converge
+ * or if a multiple eigenvalue may have lost some eigenvectors
+ * (cf. multi_eval()). Private
+ */
+int Lanczos_::krylov(const Trimat_& Mat, unsigned int Evno,
+	bool Warm, unsigned int& m)
+{
+    register unsigned int Size=Mat.rno(), Maxdim, Vecmax, Blk, Vecno, r;
+    register double *Q, *Wp, Len, Anorm=0.0;
+
+    Blk=(Evno<LANCZOS_BLOCK)? Evno: LANCZOS_BLOCK;
+    Maxdim=LANCZOS_MAXFACT*Evno+LANCZOS_MINEXTRA;
+    if (Maxdim>Size) Maxdim=Size;
+    
+    // the Ritz pairs come from Maxdim vectors, Blk more hold the residuals
+    Vecmax=Maxdim+Blk;
+    if (Vecmax>Size) Vecmax=Size;
+
+    Basis.set_size(Vecmax, Size);   // no action if same size
+    Band.set_size(Vecmax); Band.set_values();
+    W.dim(Size); Wp=&W[0];
+
+    // the starting block
+    for (Vecno=0; Vecno<Blk; Vecno++)
+	if (start_vec(Vecno, Blk, Warm))
+	    return(1);	// degenerate warm start or pathological matrix
+    
+    // Lanczos steps
+    unsigned int Conv=0;
+    for (m=0; m<Maxdim && m<Vecno; )
+    {
+	tri_mult(Mat, Basis[m], Wp);
+	Len=W.vec_len();
+	if (Len>Anorm) Anorm=Len;   // norm estimate for the breakdown test
+	Len=orthog(Wp, Vecno, m);
+	m++;
+
+	// the next Lanczos vector
+	if (Vecno<Vecmax)
+	{
+	    if (Len>1000.0*DBL_EPSILON*Anorm)
+	    {
+		Band[Vecno][m-1]=Len;
+		Q=Basis[Vecno];
+		for (r=0; r<Size; r++) Q[r]=Wp[r]/Len;
+		Vecno++;
+	    }
+	    else if (!start_vec(Vecno, Blk, false))
+		Vecno++;    // invariant subspace found, start a new one
+	}
+
+	// see if the Evno leading Ritz pairs have converged
+	if (m>=Evno && (m==Maxdim || m==Vecno || !((m-Evno)%LANCZOS_CHKSTEP)))
+	{
+	    Conv=ritz_conv(m, Vecno, Evno, LANCZOS_TOL);
+	    if (Conv>=Evno) break;
+	}
+    }
+    if (Conv<Evno)
+	return(1);  // not converged within Maxdim steps
+    if (m<Size && multi_eval(Theta, m, Blk, Evno))
+	return(1);  // might have missed a copy of a multiple eigenvalue
+    return(0);
+}
+// END of krylov()
+
+/* start_vec(): puts the Vidx-th starting vector into Basis[Vidx].
+ * The "cold" starting vectors are deterministic so that the results
+ * can be reproduced, and "irregular" enough not to be orthogonal
+ * to the wanted eigenvectors (e.g. metric matrices have
+ * the all-ones vector in their null space).
+ * If Warm is true and Vidx<Blk, then the saved eigenvectors in Prev
+ * are dealt out among the Blk vectors of the starting block
+ * with some of the cold vector mixed in:
+ * if the matrix changed only a little, then the saved eigenvectors
+ * almost span the wanted invariant subspace and the iteration
+ * stops after a few steps. The cold part is kept in case
+ * a new eigenvector has risen to the top.
+ * The vector is orthonormalised against the previous ones.
+ * Return value: 0 if OK, 1 if it was linearly dependent on them. Private
+ */
+int Lanczos_::start_vec(unsigned int Vidx, unsigned int Blk, bool Warm)
+{
+    register unsigned int Size=Basis.cno(), i, r, Vno;
+    register double *Q=Basis[Vidx], *Qi, Dot, Len;
+
+    for (Len=0.0, r=0; r<Size; r++)
+    {
+	Dot=(r+1)*(Vidx+1)*0.6180339887498949;	// golden ratio sequences
+	Q[r]=Dot-floor(Dot)-0.5;
+	Len+=Q[r]*Q[r];
+    }
+    Len=sqrt(Len);
+    for (r=0; r<Size; r++) Q[r]/=Len;
+
+    if (Warm && Vidx<Blk)
+    {
+	for (Vno=0, i=Vidx; i<Prevno; i+=Blk) Vno++;
+	for (r=0; r<Size; r++) Q[r]*=LANCZOS_WARMMIX;
+	for (i=Vidx; i<Prevno; i+=Blk)
+	{
+	    Qi=Prev[i];
+	    for (r=0; r<Size; r++) Q[r]+=Qi[r]/sqrt(double(Vno));
+	}
+	for (Len=0.0, r=0; r<Size; r++) Len+=Q[r]*Q[r];
+	Len=sqrt(Len);
+	if (Len<DBL_EPSILON) return(1);
+    }
+    else Len=1.0;
+    
+    Dot=orthog(Q, Vidx, -1);
+    if (Dot<=1000.0*DBL_EPSILON*Len) return(1);
+    for (r=0; r<Size; r++) Q[r]/=Dot;
+    return(0);
+}
+// END of start_vec()
+
+/* orthog(): orthogonalises the Size-long array X against the
+ * first Vno Lanczos vectors in Basis. This is done twice
+ * ("twice is enough", Parlett), so that the basis stays orthogonal
+ * to working precision. If Col>=0, then the coefficients are
+ * accumulated in the Col-th column of the lower triangle of Band
+ * (i.e. the projection of Mat*q[Col] if X was that).
+ * Return value: the length of X after orthogonalisation. Private
+ */
+double Lanczos_::orthog(double *X, unsigned int Vno, int Col)
+{
+    register unsigned int Size=Basis.cno(), i, r;
+    register double *Qi, Dot;
+
+    for (int Pass=0; Pass<2; Pass++)
+	for (i=0; i<Vno; i++)
+	{
+	    Qi=Basis[i];
+	    for (Dot=0.0, r=0; r<Size; r++) Dot+=Qi[r]*X[r];
+	    for (r=0; r<Size; r++) X[r]-=Dot*Qi[r];
+	    if (Col>=0 && i>=(unsigned int)Col) Band[i][Col]+=Dot;
+	}
+    for (Dot=0.0, r=0; r<Size; r++) Dot+=X[r]*X[r];
+    return(sqrt(Dot));
+}
+// END of orthog()
+
+// ---- Auxiliaries ----
+
+/* ritz_conv(): diagonalises the m x m projected matrix made from the
+ * first m rows and columns of Band, and puts the Ritz values into Theta
+ * in decreasing order and the eigenvectors into the columns of S.
+ * Vecno is the number of Lanczos vectors made so far.
+ * Return value: the number of leading Ritz pairs [0..Evno]
+ * whose residual is below Tol times the largest Ritz value. Private
+ */
+unsigned int Lanczos_::ritz_conv(unsigned int m, unsigned int Vecno,
+	unsigned int Evno, double Tol)
+{
+    register unsigned int i, j, k;
+    register double Dot, Res;
+
+    Tri.set_size(m);
+    for (i=0; i<m; i++)
+	for (j=0; j<=i; j++) Tri[i][j]=Band[i][j];
+    eigen_ql(Tri, Theta, S);
+
+    double Thmax=fabs(Theta[0]);
+    if (fabs(Theta[m-1])>Thmax) Thmax=fabs(Theta[m-1]);
+    if (Thmax<DBL_EPSILON) Thmax=DBL_EPSILON;
+
+    /* the residual of the i-th Ritz pair is made up of the
+     * components of Mat*q[k] (k<m) along the vectors q[m..Vecno-1]
+     */
+    for (i=0; i<Evno; i++)
+    {
+	for (Res=0.0, j=m; j<Vecno; j++)
+	{
+	    for (Dot=0.0, k=0; k<m; k++) Dot+=Band[j][k]*S[k][i];
+	    Res+=Dot*Dot;
+	}
+	if (sqrt(Res)>Tol*Thmax) break;
+    }
+    return(i);
+}
+// END of ritz_conv()
+
+/* multi_eval(): checks the first m Ritz values in Theta (decreasing order)
+ * for "clusters" of values which are equal within a relative tolerance.
+ * The block iteration finds at most Blk eigenvectors of a multiple
+ * eigenvalue. Therefore if a cluster has Blk or more members,
+ * then a further member may be missing, and if it would be among
+ * the Evno largest eigenvalues, then the results cannot be trusted.
+ * Return value: true if this is the case. Static private
+ */
+bool Lanczos_::multi_eval(const Vector_& Theta, unsigned int m,
+	unsigned int Blk, unsigned int Evno)
+{
+    register unsigned int i, j;
+    double Gap=fabs(Theta[0]);
+
+    if (fabs(Theta[m-1])>Gap) Gap=fabs(Theta[m-1]);
+    Gap*=LANCZOS_GAPTOL;
+    for (i=0; i<Evno && i<m; i=j)
+    {
+	for (j=i+1; j<m && Theta[i]-Theta[j]<=Gap; j++);
+	if (j-i>=Blk && j<Evno) return(true);
+    }
+    return(false);
+}
+// END of multi_eval()
+
+/* tri_mult(): calculates Y=Mat*X where Mat is a symmetric matrix
+ * stored in triangular form, X and Y are conventional arrays
+ * of Mat.rno() length. Static private
+ */
+void Lanczos_::tri_mult(const Trimat_& Mat, const double *X, double *Y)
+{
+    register unsigned int i, j, Size=Mat.rno();
+    register const double *Row;
+    register double Sum, Xi;
+
+    /* Y[i] is first set in the i-th cycle, and then updated
+     * by the (upper triangle) contributions of the later rows
+     */
+    for (i=0; i<Size; i++)
+    {
+	Row=Mat[i]; Xi=X[i];
+	for (Sum=0.0, j=0; j<i; j++)
+	{
+	    Sum+=Row[j]*X[j];
+	    Y[j]+=Row[j]*Xi;
+	}
+	Y[i]=Sum+Row[i]*Xi;
+    }
+}
+// END of tri_mult()
+
+#undef LANCZOS_TOL
+#undef LANCZOS_MINEXTRA
+#undef LANCZOS_MAXFACT
+#undef LANCZOS_CHKSTEP
+#undef LANCZOS_WARMMIX
+#undef LANCZOS_BLOCK
+#undef LANCZOS_GAPTOL
+
+// ==== END OF METHODS Lanczos.c++ ====
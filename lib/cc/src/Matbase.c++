@@ -157,6 +157,18 @@ double* Matbase_::alloc_elems(unsigned int Elemno)
 }
 // END of alloc_elems()
 
+/* swap_base(): exchanges the row pointer arrays (and thus the
+ * element arrays), row and element numbers of the calling object
+ * and Mb. The derived classes swap their own data as well.
+ */
+void Matbase_::swap_base(Matbase_& Mb)
+{
+    double **Tr=Rows; Rows=Mb.Rows; Mb.Rows=Tr;
+    unsigned int Tu=R; R=Mb.R; Mb.R=Tu;
+    Tu=Eno; Eno=Mb.Eno; Mb.Eno=Tu;
+}
+// END of swap_base()
+
 // ---- Printing ----
 
 /* list_matrix: lists calling object to stdout with entries occupying Width chars,
@@ -40,6 +40,17 @@ Matrix_& Matrix_::operator=(const Matrix_& Mat)
 }
 // END of operator= 
 
+/* swap(): exchanges the contents of the calling object and Mat.
+ * Only the storage addresses are swapped, the elements are not copied.
+ */
+void Matrix_::swap(Matrix_& Mat)
+{
+    if (this==&Mat) return;
+    swap_base(Mat);
+    unsigned int Tc=C; C=Mat.C; Mat.C=Tc;
+}
+// END of swap()
+
 // ---- Size ----
 
 /* set_size(): resets the size to Rno x Cno. The upper left
@@ -11,6 +11,11 @@
 
 #include "Points.h"
 
+// ---- INCLUDE FILES ----
+
+#include "Coords.h"	// column-wise copy for the distance matrices
+#include "Vec3.h"	// 3D rotations without temporaries
+
 // ==== Points_ MEMBER FUNCTIONS ====
 
 // ---- Constructors ----
@@ -126,6 +131,19 @@ Points_& Points_::operator*=(double Scalar)
  */
 Points_& Points_::operator*=(const Sqmat_& Matrix)
 {
+    if (Matrix.rno()==3)    // 3D vectors are done in place
+    {
+	Mat3_ M3(Matrix);
+	Vector_ *Vec;
+	for (unsigned int i=0; i<active_len(); i++)
+	{
+	    Vec=Idx[i];
+	    if (Vec->dim()==3) (M3*Vec3_(*Vec)).put(*Vec);
+	    else *Vec=Matrix*(*Vec);	// mismatch warning
+	}
+	return(*this);
+    }
+    
     for (unsigned int i=0; i<active_len(); i++)
 	*(Idx[i])=Matrix*(*(Idx[i]));
     return(*this);
@@ -232,9 +250,11 @@ Vector_ Points_::centroid() const
  * and squared distance matrices using the active points only. The matrices
  * will not be touched if there are no active points or if the active
  * point dimensions don't match. The matrix size will be adjusted
- * silently if necessary. Return calling object.
+ * silently if necessary. The coordinates are copied into the
+ * contiguous columns of Work first, the versions without Work
+ * use a temporary. Return calling object.
  */
-const Points_& Points_::dist_mat(Trimat_& Dist) const
+const Points_& Points_::dist_mat(Trimat_& Dist, Coords_& Work) const
 {
     if (!dim())
     {
@@ -242,21 +262,38 @@ const Points_& Points_::dist_mat(Trimat_& Dist) const
 	return(*this);
     }
     
-    unsigned int i, j, N=active_len();
-    Vector_ *Vecp;
-    
-    Dist.set_size(N);
-    for (i=0; i<N; i++)
+    Work.get(*this);
+    Work.dist_mat(Dist);
+    return(*this);
+}
+
+const Points_& Points_::dist_mat(Trimat_& Dist) const
+{
+    if (!dim())
     {
-	Vecp=Idx[i];
-	Dist[i][i]=0.0;
-	for (j=0; j<i; j++)
-	    Dist[i][j]=diff_len(*Vecp, *(Idx[j]));
+	cerr<<"? Points_::dist_mat(): No active points or dim mismatch within object\n";
+	return(*this);
     }
+    
+    Coords_ Work(*this);
+    Work.dist_mat(Dist);
     return(*this);
 }
 // END of dist_mat()
 
+const Points_& Points_::dist_mat2(Trimat_& Dist2, Coords_& Work) const
+{
+    if (!dim())
+    {
+	cerr<<"? Points_::dist_mat2(): No active points or dim mismatch within object\n";
+	return(*this);
+    }
+    
+    Work.get(*this);
+    Work.dist_mat2(Dist2);
+    return(*this);
+}
+
 const Points_& Points_::dist_mat2(Trimat_& Dist2) const
 {
     if (!dim())
@@ -265,20 +302,160 @@ const Points_& Points_::dist_mat2(Trimat_& Dist2) const
 	return(*this);
     }
     
-    unsigned int i, j, N=active_len();
-    Vector_ *Vecp;
+    Coords_ Work(*this);
+    Work.dist_mat2(Dist2);
+    return(*this);
+}
+// END of dist_mat2()
+
+// ==== Ptview_ MEMBER FUNCTIONS ====
+
+// ---- Dimension ----
+
+/* dim_high(): returns the highest dimension of the points in the view
+ * or 0 if the view is empty.
+ * dim(): returns the dimension of the points in the view if they
+ * have the same dimension or 0 if the dimensions are different
+ * or the view is empty.
+ */
+unsigned int Ptview_::dim_high() const
+{
+    unsigned int i, D, High=0;
+    for (i=0; i<Idxno; i++)
+    {
+	D=Data[Ix[i]].dim();
+	if (D>High) High=D;
+    }
+    return(High);
+}
+
+unsigned int Ptview_::dim() const
+{
+    if (!Idxno) return(0);
+    
+    unsigned int i, D=Data[Ix[0]].dim();
+    for (i=1; i<Idxno; i++)
+	if (Data[Ix[i]].dim()!=D) return(0);
+    return(D);
+}
+// END of dim()
+
+// ---- Arithmetics ----
+
+/* View*=Matrix: premultiplies the points in the view by Matrix
+ * in the same way as Points*=Matrix.
+ */
+Ptview_& Ptview_::operator*=(const Sqmat_& Matrix)
+{
+    unsigned int i;
+    Vector_ *Vec;
     
-    Dist2.set_size(N);
-    for (i=0; i<N; i++)
+    if (Matrix.rno()==3)    // 3D vectors are done in place
+    {
+	Mat3_ M3(Matrix);
+	for (i=0; i<Idxno; i++)
+	{
+	    Vec=Data+Ix[i];
+	    if (Vec->dim()==3) (M3*Vec3_(*Vec)).put(*Vec);
+	    else *Vec=Matrix*(*Vec);	// mismatch warning
+	}
+	return(*this);
+    }
+    
+    for (i=0; i<Idxno; i++)
     {
-	Vecp=Idx[i];
-	Dist2[i][i]=0.0;
-	for (j=0; j<i; j++)
-	    Dist2[i][j]=diff_len2(*Vecp, *(Idx[j]));
+	Vec=Data+Ix[i];
+	*Vec=Matrix*(*Vec);
     }
     return(*this);
 }
-// END of dist_mat2()
+// END of operator *=(Matrix)
+
+/* View+=Vector, View-=Vector: adds/subtracts Vector to the points
+ * in the view.
+ */
+Ptview_& Ptview_::operator+=(const Vector_& Vector)
+{
+    for (unsigned int i=0; i<Idxno; i++)
+	Data[Ix[i]]+=Vector;
+    return(*this);
+}
+
+Ptview_& Ptview_::operator-=(const Vector_& Vector)
+{
+    for (unsigned int i=0; i<Idxno; i++)
+	Data[Ix[i]]-=Vector;
+    return(*this);
+}
+// END of operator +=,-= (Vector)
+
+/* centroid(W), centroid(): the (weighted) centroid of the points
+ * in the view, calculated in the same way as by Points_::centroid().
+ */
+Vector_ Ptview_::centroid(const Vector_& W) const
+{
+    unsigned int Maxdim=dim_high();
+    if (!Maxdim)
+    {
+	cerr<<"? Ptview_::centroid(W): Empty view, default null-vector returned\n";
+	return(Vector_(3));
+    }
+    
+    unsigned int N=Idxno;
+    if (N>W.dim())
+    {
+	cerr<<"\n? Ptview_::centroid(W): Weight vector has too few elements ("
+		<<W.dim()<<"<"<<N<<")\n";
+	return(Vector_(3));
+    }
+    
+    double Wsum=0.0;
+    unsigned int i;
+    for (i=0; i<N; i++)
+    {
+	if (W[i]<0.0)
+	{
+	    cerr<<"\n? Ptview_::centroid(W): W["<<i<<"]="<<W[i]<<", not allowed\n";
+	    return(Vector_(3));
+	}
+	else Wsum+=W[i];
+    }
+
+    Vector_ Sum(Maxdim);
+    const Vector_ *Vec;
+    unsigned int j, D;
+    
+    for (i=0; i<N; i++)
+    {
+	Vec=Data+Ix[i]; D=Vec->dim();   // D<=Maxdim
+	for (j=0; j<D; j++) Sum[j]+=W[i]*(*Vec)[j];
+    }
+    Sum/=Wsum;
+    return(Sum);
+}
+
+Vector_ Ptview_::centroid() const
+{
+    unsigned int Maxdim=dim_high();
+    if (!Maxdim)
+    {
+	cerr<<"? Ptview_::centroid(): Empty view, default null-vector returned\n";
+	return(Vector_(3));
+    }
+    
+    Vector_ Sum(Maxdim);
+    const Vector_ *Vec;
+    unsigned int i, j, D, N=Idxno;
+    
+    for (i=0; i<N; i++)
+    {
+	Vec=Data+Ix[i]; D=Vec->dim();   // D<=Maxdim
+	for (j=0; j<D; j++) Sum[j]+=(*Vec)[j];
+    }
+    Sum/=N;
+    return(Sum);
+}
+// END of centroid()
 
 // ==== END OF MEMBER FUNCTIONS ====
 
@@ -19,6 +19,7 @@
 Trimat_::Trimat_(unsigned int Size) : Matbase_(Size)
 {
     if (!Size) Size=3;
+    Cap=Size;
     Eno=(Size*(Size+1))/2;
     
     // make element array: Rows[] were made by the Matbase_ ctor
@@ -37,9 +38,10 @@ Trimat_::Trimat_(unsigned int Size) : Matbase_(Size)
  * there's no way of checking it. 
  * If Arr==NULL then the matrix elements will be set to 0.0
  */
-Trimat_::Trimat_(const double **Arr, unsigned int Row)
+Trimat_::Trimat_(const double **Arr, unsigned int Row) : Matbase_(Row)
 {
     if (!Row) Row=3;	// zero rows/cols not accepted
+    Cap=Row;
     
     Eno=(Row*(Row+1))/2;  // store matrix dimensions and no. of elements
     
@@ -61,6 +63,7 @@ Trimat_::Trimat_(const double **Arr, unsigned int Row)
 /* The copy constructor */
 Trimat_::Trimat_(const Trimat_& Tri) : Matbase_(Tri.rno()) // 5-Jul-1997. g++
 {
+    Cap=R;
     Eno=(R*(R+1))/2;
     
     // make element array: Rows[] were made by the Matbase_ ctor
@@ -74,6 +77,7 @@ Trimat_::Trimat_(const Trimat_& Tri) : Matbase_(Tri.rno()) // 5-Jul-1997. g++
 /* Tri<--Sq conversion constructor. Inits with Sq's lower triangle */
 Trimat_::Trimat_(const Sqmat_& Sq) : Matbase_(Sq)
 {
+    Cap=R;
     Eno=(R*(R+1))/2;
     
     // make element array: Rows[] were made by the Matbase_ ctor
@@ -90,12 +94,22 @@ Trimat_::Trimat_(const Sqmat_& Sq) : Matbase_(Sq)
 
 // ---- Assignment ----
 
+/* The storage of the calling object is reused if Tri
+ * is not larger than its capacity (cf. set_size()).
+ */
 Trimat_& Trimat_::operator=(const Trimat_& Tri)
 {
     if (this==&Tri) return(*this);  // Tri=Tri; nothing is done
     
-    // if the dimensions happen to match, then no realloc is needed
-    if (rno()!=Tri.rno())
+    // if Tri fits into the storage, then no realloc is needed
+    if (Tri.rno()<=Cap)
+    {
+	if (R!=Tri.rno())
+	{
+	    R=Tri.rno(); Eno=Tri.Eno; init_rowptrs(R);
+	}
+    }
+    else
     {
 	// tough luck! must alloc new arrays
 	double **Newrows=alloc_rows(Tri.rno());
@@ -106,7 +120,7 @@ Trimat_& Trimat_::operator=(const Trimat_& Tri)
 	// OK, we've got space, go ahead
 	delete [] Rows[0]; delete [] Rows;	// destroy original
 	Rows=Newrows;	// get new array(s)
-	R=Tri.rno(); Eno=Tri.Eno;	// adjust new dimensions
+	R=Cap=Tri.rno(); Eno=Tri.Eno;	// adjust new dimensions
 	init_rowptrs(R);	// adjust new row pointers
     }
 
@@ -116,6 +130,17 @@ Trimat_& Trimat_::operator=(const Trimat_& Tri)
 }
 // END of operator= 
 
+/* swap(): exchanges the contents of the calling object and Tri.
+ * Only the storage addresses are swapped, the elements are not copied.
+ */
+void Trimat_::swap(Trimat_& Tri)
+{
+    if (this==&Tri) return;
+    swap_base(Tri);
+    unsigned int Tc=Cap; Cap=Tri.Cap; Tri.Cap=Tc;
+}
+// END of swap()
+
 // ---- Conversion ----
 
 /* Converts a Trimat_ object into a Sqmat_ object, i.e.
@@ -169,15 +194,26 @@ double** Trimat_::get_array(unsigned int& Row, unsigned int& Col) const
  * larger than the old then the new rows will be set to 0.0, 
  * if less then the upper triangle will be preserved and the extra
  * rows will be lost. Zero size isn't allowed (no action).
+ * The storage is kept when shrinking and is reallocated only if
+ * Size exceeds the largest size the object has held so far.
  */
 void Trimat_::set_size(unsigned int Size)
 {
     if (!Size || R==Size) return;	    // no change
     
+    unsigned int Elemno=(Size*(Size+1))/2;
+    if (Size<=Cap)
+    {
+	// fits into the old storage: zero the new rows if growing
+	if (Elemno>Eno)
+	    memset(Rows[0]+Eno, '\0', (Elemno-Eno)*sizeof(double));
+	R=Size; Eno=Elemno; init_rowptrs(R);
+	return;
+    }
+    
     // alloc new storage
     double **Newrows=alloc_rows(Size);
     if (Newrows==NULL) return;	// out-of-memory
-    unsigned int Elemno=(Size*(Size+1))/2;
     register double *Elems=alloc_elems(Elemno);
     if (Elems==NULL) { delete [] Newrows; return; }
     
@@ -190,7 +226,7 @@ void Trimat_::set_size(unsigned int Size)
     // replace old with new
     delete [] Rows[0]; delete [] Rows;
     Rows=Newrows; Rows[0]=Elems;
-    R=Size; Eno=Elemno; init_rowptrs(R);
+    R=Cap=Size; Eno=Elemno; init_rowptrs(R);
 }
 // END of set_size()
 
@@ -90,6 +90,16 @@ Vector_& Vector_::set_values(double Val)
 }
 // END of set_values()
 
+/* swap(): exchanges the coordinates (and dimensions) of the calling
+ * object and Vec without copying them.
+ */
+void Vector_::swap(Vector_& Vec)
+{
+    double *Xt=X; X=Vec.X; Vec.X=Xt;
+    unsigned int Dt=Dim; Dim=Vec.Dim; Vec.Dim=Dt;
+}
+// END of swap()
+
 // ---- Dimension change ----
 
 /* dim(): with no parameters, returns the current dimension.
@@ -128,6 +138,12 @@ Vector_& Vector_::operator=(const Vector_& Vec)
 {
     if (this==&Vec) return(*this);  // x=x
     
+    if (Dim==Vec.Dim)	// no realloc is needed
+    {
+	memcpy(X, Vec.X, Dim*sizeof(double));
+	return(*this);
+    }
+    
     double *New=new double [Vec.Dim];
     if (New==NULL) { prt_err(NO_MEM, "="); return(*this); }
     Dim=Vec.Dim;
@@ -0,0 +1,158 @@
+// ==== TEST PROGRAM lanczostest.c++ ====
+
+/* Checks the Lanczos_ partial eigensolver against eigen_ql()
+ * on symmetric matrices with multiple largest eigenvalues.
+ * Exit status is 0 if all tests passed, 1 otherwise.
+ */
+
+// ---- STANDARD HEADERS ----
+
+#include <stdlib.h>
+#include <math.h>
+#include <iostream.h>
+
+// ---- MODULES ----
+
+#include "Lanczos.h"
+#include "Ql.h"
+
+// ---- DEFINITIONS ----
+
+#define TEST_SIZE 200	    // matrix size
+#define TEST_EVTOL 1.0e-8   // tolerance for the eigenvalues
+#define TEST_RESTOL 1.0e-6  // tolerance for the eigenvector residuals
+
+// ---- PROTOTYPES ----
+
+static void make_matrix(unsigned int Mult, double Top, Trimat_& Mat);
+static int check_top(const Trimat_& Mat, unsigned int Mult, unsigned int Evno,
+	bool Warm, Lanczos_& Lanczos);
+
+// ==== MAIN ====
+
+int main()
+{
+    static const unsigned int MULTS[]={1, 2, 3, 4, 6}, EVNOS[]={1, 3, 5, 8};
+    unsigned int m, e, Failno=0;
+    Trimat_ Mat(TEST_SIZE);
+    Lanczos_ Lanczos;
+
+    srand(1);
+    for (m=0; m<sizeof(MULTS)/sizeof(unsigned int); m++)
+    {
+	make_matrix(MULTS[m], 20.0, Mat);
+	for (e=0; e<sizeof(EVNOS)/sizeof(unsigned int); e++)
+	{
+	    Lanczos.forget();
+	    Failno+=check_top(Mat, MULTS[m], EVNOS[e], false, Lanczos);
+
+	    // warm restart on a slightly shifted matrix
+	    for (register unsigned int i=0; i<TEST_SIZE; i++)
+		Mat[i][i]+=1.0e-3;
+	    Failno+=check_top(Mat, MULTS[m], EVNOS[e], true, Lanczos);
+	    Failno+=check_top(Mat, MULTS[m], EVNOS[e], true, Lanczos);
+	    for (register unsigned int i=0; i<TEST_SIZE; i++)
+		Mat[i][i]-=1.0e-3;
+	}
+    }
+
+    if (Failno) cout<<"lanczostest: "<<Failno<<" test(s) FAILED\n";
+    else cout<<"lanczostest: all tests passed\n";
+    return(Failno? 1: 0);
+}
+
+// ==== FUNCTIONS ====
+
+/* make_matrix(): makes Mat=V*L*V' where V is a random orthogonal matrix
+ * and the diagonal matrix L has Mult eigenvalues equal to Top,
+ * the others decrease geometrically from Top/2.
+ */
+static void make_matrix(unsigned int Mult, double Top, Trimat_& Mat)
+{
+    register unsigned int i, j, k, Size=Mat.rno();
+    register double Dot;
+    Sqmat_ V(Size);
+    Vector_ L(Size);
+
+    // random orthonormal rows by modified Gram-Schmidt
+    for (i=0; i<Size; i++)
+    {
+	for (j=0; j<Size; j++) V[i][j]=double(rand())/RAND_MAX-0.5;
+	for (int Pass=0; Pass<2; Pass++)
+	    for (k=0; k<i; k++)
+	    {
+		for (Dot=0.0, j=0; j<Size; j++) Dot+=V[i][j]*V[k][j];
+		for (j=0; j<Size; j++) V[i][j]-=Dot*V[k][j];
+	    }
+	for (Dot=0.0, j=0; j<Size; j++) Dot+=V[i][j]*V[i][j];
+	Dot=sqrt(Dot);
+	for (j=0; j<Size; j++) V[i][j]/=Dot;
+    }
+
+    for (i=0; i<Size; i++)
+	L[i]=(i<Mult)? Top: 0.5*Top*pow(0.95, double(i-Mult));
+    for (i=0; i<Size; i++)
+	for (j=0; j<=i; j++)
+	{
+	    for (Dot=0.0, k=0; k<Size; k++) Dot+=V[k][i]*L[k]*V[k][j];
+	    Mat[i][j]=Dot;
+	}
+}
+// END of make_matrix()
+
+/* check_top(): obtains the Evno largest eigenpairs of Mat by Lanczos
+ * and compares the eigenvalues to those from eigen_ql(). The eigenvectors
+ * must satisfy Mat*v=lambda*v. Lanczos may refuse to answer
+ * only if the multiple eigenvalue has more copies than the block size
+ * and some of them are wanted. Returns 0 if OK, 1 on failure.
+ */
+static int check_top(const Trimat_& Mat, unsigned int Mult, unsigned int Evno,
+	bool Warm, Lanczos_& Lanczos)
+{
+    register unsigned int i, r, c, Size=Mat.rno();
+    register double Sum, Res=0.0, Everr=0.0;
+    Vector_ Eval, Qleval;
+    Sqmat_ Evec, Qlevec;
+
+    cout<<"Mult="<<Mult<<", Evno="<<Evno<<(Warm? ", warm: ": ", cold: ");
+    if (Lanczos.top_eigen(Mat, Evno, Eval, Evec, Warm))
+    {
+	if (Mult>=4 && Evno>4)
+	{
+	    cout<<"no convergence (expected)\n";
+	    return(0);
+	}
+	cout<<"no convergence, FAILED\n";
+	return(1);
+    }
+
+    eigen_ql(Mat, Qleval, Qlevec);
+    for (i=0; i<Evno; i++)
+    {
+	Sum=fabs(Eval[i]-Qleval[i]);
+	if (Sum>Everr) Everr=Sum;
+	for (r=0; r<Size; r++)
+	{
+	    for (Sum=0.0, c=0; c<Size; c++)
+		Sum+=((r>=c)? Mat[r][c]: Mat[c][r])*Evec[c][i];
+	    Sum=fabs(Sum-Eval[i]*Evec[r][i]);
+	    if (Sum>Res) Res=Sum;
+	}
+    }
+
+    cout<<"eigenvalue error="<<Everr<<", residual="<<Res;
+    if (Everr>TEST_EVTOL*Qleval[0] || Res>TEST_RESTOL*Qleval[0])
+    {
+	cout<<", FAILED\n";
+	return(1);
+    }
+    cout<<endl;
+    return(0);
+}
+// END of check_top()
+
+#undef TEST_SIZE
+#undef TEST_EVTOL
+#undef TEST_RESTOL
+
+// ==== END OF TEST PROGRAM lanczostest.c++ ====
@@ -99,6 +99,21 @@ Maskarr_<T_>& Maskarr_<T_>::operator=(const Maskarr_<T_>& Marr)
 }
 // END of operator =
 
+/* swap(): exchanges the contents of the calling object and Marr.
+ * Only the storage addresses are swapped, the items are not copied.
+ */
+template <class T_>
+void Maskarr_<T_>::swap(Maskarr_<T_>& Marr)
+{
+    if (this==&Marr) return;
+    
+    T_ *Td=Data; Data=Marr.Data; Marr.Data=Td;
+    T_ **Ti=Idx; Idx=Marr.Idx; Marr.Idx=Ti;
+    unsigned int Tn=Idxno; Idxno=Marr.Idxno; Marr.Idxno=Tn;
+    Mask.swap(Marr.Mask);
+}
+// END of swap()
+
 // ---- Access ----
 
 /* operator []: direct access to array items is not allowed.
@@ -259,6 +274,7 @@ unsigned int Maskarr_<T_>::data_resize(unsigned int Len, const T_* Newarr)
     if (!Len)	// make it empty
     {
 	delete [] Data; delete [] Idx;
+	Data=NULL; Idx=NULL;
 	return(0);
     }
     
@@ -285,6 +301,28 @@ unsigned int Maskarr_<T_>::data_resize(unsigned int Len, const T_* Newarr)
 }
 // END of data_resize()
 
+// ==== Maskview_ MEMBER FUNCTIONS ====
+
+/* Inits to view the items Marr.Data[Idx[0..N-1]]. If any
+ * of the indices is out of range, then an empty view is made
+ * (with a warning).
+ */
+template <class T_>
+Maskview_<T_>::Maskview_(Maskarr_<T_>& Marr, const unsigned int *Idx, unsigned int N):
+	Data(Marr.Data), Ix(Idx), Idxno(N)
+{
+    register unsigned int i, Len=Marr.len();
+    
+    for (i=0; i<N && Idx[i]<Len; i++);
+    if (i<N)
+    {
+	cerr<<"\n? Maskview_(): Index "<<Idx[i]<<" out of range (length "
+	    <<Len<<"), empty view made\n";
+	Data=NULL; Ix=NULL; Idxno=0;
+    }
+}
+// END of Maskview_()
+
 // ==== END OF TEMPLATE FUNCTIONS Maskarr.c++ ====
 
 #endif	/* MASKARR_TMPL_DEFS */
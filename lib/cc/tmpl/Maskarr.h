@@ -24,6 +24,8 @@
 
 // ==== CLASSES ==== 
 
+template <class T_> class Maskview_;	// forward declaration
+
 /* Class Maskarr_ : the masked array template class.
  * The elements of the array can be active or inactive;
  * activation status is held in a bit vector. Only active
@@ -32,6 +34,8 @@
 template <class T_>
 class Maskarr_
 {
+    friend class Maskview_<T_>;
+    
     // data
     protected:
     
@@ -74,6 +78,11 @@ class Maskarr_
      */
     Maskarr_<T_>& operator=(const Maskarr_<T_>& Marr);
     
+    /* swap(): exchanges the contents of the calling object and Marr.
+     * Only the storage addresses are swapped, the items are not copied.
+     */
+    void swap(Maskarr_<T_>& Marr);
+    
 	// access
     /* operator []: direct access to array items is not allowed.
      * [Index] will return the Index-th active item. If Index is
@@ -126,6 +135,54 @@ class Maskarr_
 };
 // END OF CLASS Maskarr_
 
+/* Class Maskview_ : a "masked view" of a Maskarr_ object. The view
+ * accesses those items of its parent the storage indices of which
+ * are listed in an index span (e.g. the members of a cluster),
+ * so that [i] is the item at the i-th listed index. The span is
+ * not copied and the mask of the parent is neither used nor
+ * changed, therefore views can be made and thrown away cheaply
+ * without allocating. The parent and the index span must outlive
+ * the view and the parent must not be resized meanwhile.
+ */
+template <class T_>
+class Maskview_
+{
+    // data
+    protected:
+    
+    T_ *Data;	// the items of the parent
+    const unsigned int *Ix;	// storage indices of the items in the view
+    unsigned int Idxno;	    // no. of items in the view
+    
+    // methods
+    public:
+    
+	// constructors
+    /* Inits to an empty view. */
+    Maskview_(): Data(NULL), Ix(NULL), Idxno(0) {}
+    
+    /* Inits to view the items Marr.Data[Idx[0..N-1]]. If any
+     * of the indices is out of range, then an empty view is made
+     * (with a warning).
+     */
+    Maskview_(Maskarr_<T_>& Marr, const unsigned int *Idx, unsigned int N);
+    
+	// access
+    /* operator []: [Index] returns the Index-th item of the view.
+     * No range checks.
+     */
+    const T_& operator[](unsigned int Index) const { return(Data[Ix[Index]]); }
+    T_& operator[](unsigned int Index) { return(Data[Ix[Index]]); }
+    
+    /* idx(): returns the storage index of the Index-th item of the view. */
+    unsigned int idx(unsigned int Index) const { return(Ix[Index]); }
+    
+	// size
+    /* active_len(): returns the number of items in the view. */
+    unsigned int active_len() const { return(Idxno); }
+};
+// END OF CLASS Maskview_
+
 #ifdef INCLUDE_TMPL_DEFS
 #include "Maskarr.c++"
 #endif
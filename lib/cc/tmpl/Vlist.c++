@@ -0,0 +1,230 @@
+#ifndef VLIST_TMPL_DEFS
+#define VLIST_TMPL_DEFS
+
+// ==== TEMPLATE DEFINITIONS Vlist.c++ ====
+
+/* Contiguous list templates with a List1_-like interface. */
+
+// ==== Vlist_ METHODS ====
+
+// ---- Constructors ----
+
+/* Copy constructor. The current position is copied as well. */
+template <class T_>
+Vlist_<T_>::Vlist_(const Vlist_<T_>& L):
+    Items(NULL), Len(L.Len), Cap(L.Len), Cur(L.Cur)
+{
+    if (!Cap) return;
+    Items=new T_ [Cap];
+    for (register unsigned int i=0; i<Len; i++) Items[i]=L.Items[i];
+}
+
+// ---- Assignment ----
+
+/* = : Creates an exact copy of the rhs in the lhs (even the position of
+ * the current pointer is preserved). The storage of the lhs
+ * is reused if it is large enough.
+ */
+template <class T_>
+Vlist_<T_>& Vlist_<T_>::operator=(const Vlist_<T_>& Rhs)
+{
+    if (this==&Rhs) return(*this);  // x=x
+
+    if (Rhs.Len>Cap)
+    {
+	delete [] Items;
+	Items=new T_ [Cap=Rhs.Len];
+    }
+    for (register unsigned int i=0; i<Rhs.Len; i++) Items[i]=Rhs.Items[i];
+    Len=Rhs.Len; Cur=Rhs.Cur;
+    return(*this);
+}
+// END of =
+
+// ---- Insertions ----
+
+/* insert(Val): inserts a new item before the current item.
+ * The current position will be the new item. If the current position
+ * is off the list, then the new item will be appended to the end.
+ * Returns the calling object.
+ */
+template <class T_>
+Vlist_<T_>& Vlist_<T_>::insert(const T_& Val)
+{
+    if (is_item(Val))	// Val may be moved, copy first
+    {
+	T_ Temp(Val);
+	return(insert(Temp));
+    }
+
+    if (!Cur) Cur=Len+1;    // append
+    *make_room(Cur-1, 1)=Val;
+    return(*this);
+}
+// END of insert(Val)
+
+/* insert(List): inserts a copy of List before the current item.
+ * The current position will be the first item of the inserted
+ * copy. If the current position is off the list, then List
+ * will be appended to the end. Returns calling object.
+ */
+template <class T_>
+Vlist_<T_>& Vlist_<T_>::insert(const Vlist_<T_>& List)
+{
+    if (!List) return(*this);	// empty List: don't bother
+    if (this==&List)	// L.insert(L)
+    {
+	Vlist_<T_> Temp(List);
+	return(insert(Temp));
+    }
+
+    if (!Cur) Cur=Len+1;
+    T_ *Dest=make_room(Cur-1, List.Len);
+    for (register unsigned int i=0; i<List.Len; i++) Dest[i]=List.Items[i];
+    return(*this);
+}
+// END of insert(List)
+
+/* List+=Val : appends a new item with the value Val at the end of the list.
+ * List+=List2: appends a copy of List2 at the end of the calling object.
+ * If the calling object was empty, then the current position
+ * will be its first item. Both return the calling object.
+ */
+template <class T_>
+Vlist_<T_>& Vlist_<T_>::operator+=(const T_& Val)
+{
+    if (Len==Cap && is_item(Val))
+    {
+	T_ Temp(Val);
+	return((*this)+=Temp);
+    }
+
+    if (!Len) Cur=1;
+    *make_room(Len, 1)=Val;
+    return(*this);
+}
+
+template <class T_>
+Vlist_<T_>& Vlist_<T_>::operator+=(const Vlist_<T_>& List)
+{
+    if (!List) return(*this);	// empty, don't bother
+
+    register unsigned int i, Llen=List.Len;
+    if (!Len) Cur=1;
+    T_ *Dest=make_room(Len, Llen);  // List may be the calling object
+    for (i=0; i<Llen; i++) Dest[i]=(this==&List)? Items[i]: List.Items[i];
+    return(*this);
+}
+// END of operator +=
+
+/* List^=Val: puts a new item with value Val before the beginning of List.
+ * List^=List2: puts a copy of List2 before the first item of List.
+ * The current item does not change (if the calling object
+ * was empty, then it will be the first item).
+ * Both return the calling object.
+ */
+template <class T_>
+Vlist_<T_>& Vlist_<T_>::operator^=(const T_& Val)
+{
+    if (is_item(Val))
+    {
+	T_ Temp(Val);
+	return((*this)^=Temp);
+    }
+
+    if (!Len) Cur=1; else if (Cur) Cur++;
+    *make_room(0, 1)=Val;
+    return(*this);
+}
+
+template <class T_>
+Vlist_<T_>& Vlist_<T_>::operator^=(const Vlist_<T_>& List)
+{
+    if (!List) return(*this);	// empty, don't bother
+    if (this==&List)
+    {
+	Vlist_<T_> Temp(List);
+	return((*this)^=Temp);
+    }
+
+    if (!Len) Cur=1; else if (Cur) Cur+=List.Len;
+    T_ *Dest=make_room(0, List.Len);
+    for (register unsigned int i=0; i<List.Len; i++) Dest[i]=List.Items[i];
+    return(*this);
+}
+// END of operator ^=
+
+// ---- Deletions ----
+
+/* del(): deletes N items (default 1) from the list, beginning with the
+ * current item. If the current position is off the list or N==0,
+ * nothing happens. If N is larger than the length of the tail of
+ * the list from the current item, then the whole tail is deleted.
+ * The new current position will be the first item after the deleted region.
+ * Return value: the number of items actually deleted.
+ */
+template <class T_>
+unsigned int Vlist_<T_>::del(unsigned int N)
+{
+    if (!N || !Cur) return(0);	// do nothing
+
+    register unsigned int i, Beg=Cur-1;
+    if (N>Len-Beg) N=Len-Beg;
+
+    // shift the tail down
+    for (i=Beg+N; i<Len; i++) Items[i-N]=Items[i];
+    Len-=N;
+    for (i=Len; i<Len+N; i++) Items[i]=T_();	// release what the items held
+    if (Cur>Len) Cur=0;
+    return(N);
+}
+// END of del()
+
+// ---- Memory management ----
+
+/* reserve(): makes sure that the list can grow to N items without
+ * reallocation. Never shrinks the storage.
+ */
+template <class T_>
+void Vlist_<T_>::reserve(unsigned int N)
+{
+    if (N<=Cap) return;
+
+    T_ *Newitems=new T_ [N];
+    for (register unsigned int i=0; i<Len; i++) Newitems[i]=Items[i];
+    delete [] Items;
+    Items=Newitems; Cap=N;
+}
+// END of reserve()
+
+/* make_room(): opens a gap of N items at position Pos (0<=Pos<=Len)
+ * by moving the items from Pos on upwards, growing the storage
+ * geometrically if necessary. The length is increased by N.
+ * Returns the address of the gap. Protected
+ */
+template <class T_>
+T_ *Vlist_<T_>::make_room(unsigned int Pos, unsigned int N)
+{
+    register unsigned int i;
+
+    if (Len+N>Cap)
+    {
+	// grow: copy the items around the gap into the new storage
+	unsigned int Newcap=(2*Cap<Len+N)? Len+N: 2*Cap;
+	if (Newcap<4) Newcap=4;
+	T_ *Newitems=new T_ [Newcap];
+	for (i=0; i<Pos; i++) Newitems[i]=Items[i];
+	for (i=Pos; i<Len; i++) Newitems[i+N]=Items[i];
+	delete [] Items;
+	Items=Newitems; Cap=Newcap;
+    }
+    else
+	for (i=Len; i>Pos; i--) Items[i+N-1]=Items[i-1];
+    Len+=N;
+    return(Items+Pos);
+}
+// END of make_room()
+
+// ==== END OF TEMPLATE DEFINITIONS Vlist.c++ ====
+
+#endif	/* VLIST_TMPL_DEFS */
@@ -0,0 +1,273 @@
+#ifndef VLIST_TMPL_DECLS
+#define VLIST_TMPL_DECLS
+
+// ==== TEMPLATE HEADER Vlist.h ====
+
+/* Contiguous list templates with a List1_-like interface. */
+
+// ---- STANDARD HEADERS ----
+
+#include <stdlib.h>
+#include <iostream.h>
+
+// ==== CLASSES ====
+
+/* The items of a Vlist_ are kept in one contiguous array which
+ * grows geometrically, so that appending is cheap on average
+ * and scanning the list runs over adjacent memory locations.
+ * The interface mimics List1_/Clist1_ (current position,
+ * begin(), ++, insert(), del() etc.) so that code written
+ * for linked lists works unchanged. The current position is
+ * an index: Cur==0 means "off the list" (the equivalent of
+ * Cur==NULL in List1_), otherwise the current item is Items[Cur-1].
+ * Unlike List1_, copies of a Vlist_ are always "deep";
+ * non-destructive scanning of a constant list is done by
+ * Cvlist_ objects which point to the list they scan.
+ * NOTE: insertions may move the items around in memory, so
+ * pointers to the items remain valid only as long as the list
+ * does not grow beyond the capacity set by reserve().
+ */
+
+// forward declarations
+template <class T_> class Cvlist_;
+
+/* Class Vlist_ : the contiguous list template with "destructive"
+ * operations (insertions, deletions, item modification).
+ */
+template <class T_>
+class Vlist_
+{
+    friend class Cvlist_<T_>;
+
+    // data
+    protected:
+
+    T_ *Items;	// the storage (NULL if no capacity)
+    unsigned int Len, Cap;  // current length and capacity
+    unsigned int Cur;	// 1+index of the current item, 0 if none
+
+    // methods
+    public:
+
+	// constructors
+    /* Starts an empty list. */
+    Vlist_(): Items(NULL), Len(0), Cap(0), Cur(0) {}
+
+    /* Starts a list with one item in it (which will be current). */
+    Vlist_(const T_& Item): Items(new T_ [1]), Len(1), Cap(1), Cur(1) { Items[0]=Item; }
+
+    /* Copy constructor. The current position is copied as well. */
+    Vlist_(const Vlist_<T_>& L);
+
+	// destructor
+    ~Vlist_() { delete [] Items; }
+
+	// assignment
+    /* = : Creates an exact copy of the rhs in the lhs (even the position of
+     * the current pointer is preserved). The storage of the lhs
+     * is reused if it is large enough.
+     */
+    Vlist_<T_>& operator=(const Vlist_<T_>& Rhs);
+
+	// Access
+    /* len(): returns the current length. */
+    unsigned int len() const { return(Len); }
+
+    /* !: returns 1 if the list is empty, 0 otherwise. */
+    int operator!() const { return(Len? 0: 1); }
+
+    /* Conversion to const void* : NULL is returned when the current
+     * position is off the list. The pointer value obtained
+     * by this conversion must not be used for anything else.
+     */
+    operator const void* () const { return(Cur? (const void*)(Items+Cur-1): NULL); }
+
+    /* *, ->: access the item at the current position, abort
+     * with an error message if the current position is off the list.
+     */
+    const T_& operator*() const { return(Items[cur_idx()]); }
+    T_& operator*() { return(Items[cur_idx()]); }
+    const T_* operator->() const { return(Items+cur_idx()); }
+    T_* operator->() { return(Items+cur_idx()); }
+
+    /* [Idx]: direct access to the Idx-th item, no range checks. */
+    const T_& operator[](unsigned int Idx) const { return(Items[Idx]); }
+    T_& operator[](unsigned int Idx) { return(Items[Idx]); }
+
+	// Move
+    /* begin(), end(): moves the current position to the head/tail
+     * of the list (off the list if it is empty).
+     */
+    void begin() { Cur=(Len>0); }
+    void end() { Cur=Len; }
+
+    /* Postfix ++: moves to the next position and returns 1
+     * if it was not already at the end in which case it returns 0
+     * and the current position walks off the list.
+     * Also returns 0 if the current position was off the list.
+     */
+    int operator++(int)
+    {
+	if (!Cur) return(0);
+	if (Cur<Len) { Cur++; return(1); }
+	Cur=0; return(0);
+    }
+
+    /* forward(): moves the current position forward by N steps (default 1)
+     * if possible. May walk off the list at the end.
+     * Returns the actual number of steps taken.
+     */
+    unsigned int forward(unsigned int N=1)
+    {
+	if (!Cur) return(0);
+	register unsigned int Stepno=Len-Cur+1;	// steps to walk off
+	if (N<Stepno) { Cur+=N; return(N); }
+	Cur=0; return(Stepno);
+    }
+
+	// Insertions
+    /* insert(Val): inserts a new item before the current item.
+     * The current position will be the new item. If the current position
+     * is off the list, then the new item will be appended to the end.
+     * Returns the calling object.
+     */
+    Vlist_<T_>& insert(const T_& Val);
+
+    /* insert(List): inserts a copy of List before the current item.
+     * The current position will be the first item of the inserted
+     * copy. If the current position is off the list, then List
+     * will be appended to the end. Returns calling object.
+     */
+    Vlist_<T_>& insert(const Vlist_<T_>& List);
+
+    /* List+=Val : appends a new item with the value Val at the end of the list.
+     * List+=List2: appends a copy of List2 at the end of the calling object.
+     * If the calling object was empty, then the current position
+     * will be its first item. Both return the calling object.
+     */
+    Vlist_<T_>& operator+=(const T_& Val);
+    Vlist_<T_>& operator+=(const Vlist_<T_>& List);
+
+    /* List^=Val: puts a new item with value Val before the beginning of List.
+     * List^=List2: puts a copy of List2 before the first item of List.
+     * The current item does not change (if the calling object
+     * was empty, then it will be the first item).
+     * Both return the calling object.
+     */
+    Vlist_<T_>& operator^=(const T_& Val);
+    Vlist_<T_>& operator^=(const Vlist_<T_>& List);
+
+	// Deletions
+    /* del(): deletes N items (default 1) from the list, beginning with the
+     * current item. If the current position is off the list or N==0,
+     * nothing happens. If N is larger than the length of the tail of
+     * the list from the current item, then the whole tail is deleted.
+     * The new current position will be the first item after the deleted region.
+     * Return value: the number of items actually deleted.
+     */
+    unsigned int del(unsigned int N=1);
+
+    /* clear(): removes all items from the calling object and returns it.
+     * The storage is kept for reuse.
+     */
+    Vlist_<T_>& clear() { Len=Cur=0; return(*this); }
+
+	// Memory management
+    /* reserve(): makes sure that the list can grow to N items without
+     * reallocation. Never shrinks the storage.
+     */
+    void reserve(unsigned int N);
+
+	// Auxiliaries
+    protected:
+
+    unsigned int cur_idx() const
+    {
+	if (!Cur)
+	{
+	    cerr<<"\n? Vlist_: Illegal access attempted\n";
+	    abort();
+	}
+	return(Cur-1);
+    }
+
+    /* is_item(): true if Val is one of the items of the calling object.
+     * Does not rely on T_::operator& which may be overloaded (cf. Smartptr_).
+     */
+    bool is_item(const T_& Val) const
+    {
+	const char *Vp=&reinterpret_cast<const char&>(Val);
+	return(Vp>=(const char*)Items && Vp<(const char*)(Items+Len));
+    }
+    T_ *make_room(unsigned int Pos, unsigned int N);
+};
+// END OF CLASS Vlist_
+
+/* Class Cvlist_ : scans a constant Vlist_ without modifying it.
+ * A Cvlist_ object keeps a pointer to the list and a current
+ * position of its own, therefore the list must not be destroyed
+ * or modified while it is being scanned by a Cvlist_.
+ */
+template <class T_>
+class Cvlist_
+{
+    // data
+    const Vlist_<T_> *Lptr;	// the list being scanned
+    unsigned int Cur;	// 1+index of the current item, 0 if none
+
+    // methods
+    public:
+
+	// constructors
+    /* Inits to scan L, starting from L's current position. */
+    Cvlist_(const Vlist_<T_>& L): Lptr(&L), Cur(L.Cur) {}
+
+	// Access
+    unsigned int len() const { return(Lptr->Len); }
+    int operator!() const { return(Lptr->Len? 0: 1); }
+    operator const void* () const { return(Cur? (const void*)(Lptr->Items+Cur-1): NULL); }
+
+    /* *, ->: access the item at the current position, abort
+     * with an error message if the current position is off the list.
+     */
+    const T_& operator*() const { return(Lptr->Items[cur_idx()]); }
+    const T_* operator->() const { return(Lptr->Items+cur_idx()); }
+
+	// Move
+    void begin() { Cur=(Lptr->Len>0); }
+    void end() { Cur=Lptr->Len; }
+    int operator++(int)
+    {
+	if (!Cur) return(0);
+	if (Cur<Lptr->Len) { Cur++; return(1); }
+	Cur=0; return(0);
+    }
+    unsigned int forward(unsigned int N=1)
+    {
+	if (!Cur) return(0);
+	register unsigned int Stepno=Lptr->Len-Cur+1;
+	if (N<Stepno) { Cur+=N; return(N); }
+	Cur=0; return(Stepno);
+    }
+
+    private:
+
+    unsigned int cur_idx() const
+    {
+	if (!Cur)
+	{
+	    cerr<<"\n? Cvlist_: Illegal const access attempted\n";
+	    abort();
+	}
+	return(Cur-1);
+    }
+};
+// END OF CLASS Cvlist_
+
+#ifdef INCLUDE_TMPL_DEFS
+#include "Vlist.c++"
+#endif
+
+// ==== END OF TEMPLATE HEADER Vlist.h ====
+
+#endif	/* VLIST_TMPL_DECLS */
@@ -27,6 +27,32 @@
 #define EPSILON DBL_EPSILON
 #endif
 
+/* The fake beta distances are single-precision and may fall
+ * slightly outside the triangle inequality bounds: the
+ * candidate preselection radius is made larger by CANDSLACK.
+ */
+#define CANDSLACK 1.0
+
+// ==== STATIC FUNCTIONS ====
+
+/* cell_hash(): maps the cell (X,Y,Z) of the spatial grid
+ * onto the [0..Size-1] range.
+ */
+static inline unsigned int cell_hash(int X, int Y, int Z, unsigned int Size)
+{
+    return(((unsigned int)X*73856093U ^ (unsigned int)Y*19349663U 
+	^ (unsigned int)Z*83492791U)%Size);
+}
+/* END of cell_hash() */
+
+/* uint_cmp(): auxiliary function for the qsort() in grid_cands(). */
+static int uint_cmp(const void *X, const void *Y)
+{
+    register unsigned int Kx= *((unsigned int *)X), Ky= *((unsigned int *)Y);
+    return((Kx>Ky)? 1: ((Kx<Ky)? -1: 0));
+}
+/* END of uint_cmp() */
+
 // ==== Access_ METHODS ====
 
 // ---- Side chain accessibility ----
@@ -42,22 +68,41 @@
  * is calculated and the angle of the smallest cone that encompasses the
  * whole set and centred on 'k' with an axis going through
  * the centroid is determined.
+ * A fake beta is not farther than sqrt(abdist) from its alpha, so
+ * only those residues are considered whose alphas are closer to
+ * the k-th alpha than NBRADIUS+2*(the largest alpha:beta distance).
+ * These candidates are selected from the spatial grid of the
+ * points in Xyz (from which Dista was made), or from Dista itself
+ * if Xyz is NULL (the default). The fake beta distances are calculated
+ * only for the candidates.
  */
-void Access_::betacone_shield(const Trimat_& Dista, const Polymer_& Polymer) 
+void Access_::betacone_shield(const Trimat_& Dista, const Polymer_& Polymer, 
+	const Points_ *Xyz) 
 {
     // reset internal sizes
     unsigned int Rno;	// the real chain length
     set_size(Rno=Dista.rno()-2);    // Dista is larger (N/C-terminal points)
     
-    // create the fake C-beta dist matrices 
-    static Fakebeta_ Fakebeta;	// just resize below upon next call
-    Fakebeta.update(Dista, Polymer);
+    // fake C-beta distances are made on demand (resized if necessary)
+    Fakebeta.update(Dista, Polymer, true);
     
     static const double NBRADIUS=8.0, NBRADIUS2=NBRADIUS*NBRADIUS;
     
-    register unsigned int i, j, k, ci, cj, Closeno;
+    register unsigned int i, j, k, ci, cj, c, Closeno, Candno;
     register double Ang, Largang, D, Trisum, Isum;
     
+    // candidate preselection radius
+    double Rcut=0.0;
+    for (i=0; i<Rno; i++)
+	if (Polymer.abdist(i)>Rcut) Rcut=Polymer.abdist(i);
+    Rcut=NBRADIUS+2.0*sqrt(Rcut)+CANDSLACK;
+    if (Xyz!=NULL)
+    {
+	make_grid(*Xyz, Rcut);
+	Seen.set_values(0);
+    }
+    Rcut*=Rcut;
+    
     /* The "canonical ordering" here is that 0 is meaningless (N-terminus),
      * 1..Rno contains the BETAs, Rno+1 is the C-terminus, and Rno+1..2*Rno+3
      * the ALPHAs (where Rno+1 and 2*Rno+3 are the pseudo-alphas corresponding
@@ -70,21 +115,27 @@ void Access_::betacone_shield(const Trimat_& Dista, const Polymer_& Polymer)
      */
     for (k=1; k<=Rno; k++)
     {
-	/* select close points: an index < Rno means the index-th beta,
-	 * index>=Rno means the (index-Rno)-th alpha. Start at i==1
-	 * because i==0 is the nonexistant N-terminal beta. The dist
-	 * matrices are accessed via the "safe index" mechanism.
+	/* select close points: an index <= Rno means the index-th beta,
+	 * index>=Rno+2 means the (index-Rno-2)-th alpha. The betas
+	 * are taken first, then the alphas, both in ascending order
+	 * from the sorted candidate list. There are no betas on the
+	 * N- and C-terminal moieties (0 and Rno+1).
 	 */
+	Candno=(Xyz==NULL)? dist_cands(Dista, k, Rcut): grid_cands(Dista, k, Rcut);
 	Trisum=0.0;
-	for (Closeno=0, i=1; i<=2*Rno+3; i++)
+	for (Closeno=0, c=0; c<2*Candno; c++)
 	{
-	    // skip the current point and the nonexistent beta on the C-terminal moiety
-	    if (i==k || i==Rno+1) continue;
-	    
-	    if (i<=Rno)	// beta:beta
+	    if (c<Candno)	// beta:beta
+	    {
+		i=Cand[c];
+		if (i==k || !i || i>Rno) continue;
 		D=Fakebeta.bb(i, k);
+	    }
 	    else    // beta:alpha
+	    {
+		i=Cand[c-Candno]+Rno+2;
 		D=Fakebeta.ab(i-Rno-2, k);
+	    }
 	    if (D<0.0 || D>NBRADIUS2) continue;	    // too far away from k or non-metric
 	    
 	    Close[Closeno]=i;	// store index
@@ -188,6 +239,71 @@ void Access_::betacone_shield(const Trimat_& Dista, const Polymer_& Polymer)
 }
 // END of betacone_shield()
 
+/* dist_cands(): puts those residue indices into Cand[] (in ascending order)
+ * for which the squared alpha distance from the k-th residue in Dista
+ * is not larger than Rcut2. Returns the number of candidates. Private
+ */
+unsigned int Access_::dist_cands(const Trimat_& Dista, unsigned int k, double Rcut2)
+{
+    register unsigned int c, Candno, Size=Dista.rno();
+    
+    for (Candno=0, c=0; c<Size; c++)
+	if (((c>=k)? Dista[c][k]: Dista[k][c])<=Rcut2) Cand[Candno++]=c;
+    return(Candno);
+}
+// END of dist_cands()
+
+/* make_grid(): sorts the points in Xyz into cubic cells of size Cellsize
+ * (only the first 3 coordinates are used). The cells are hashed
+ * into the Cellhead[] array, the points in a cell are chained
+ * through Cellnext[] (-1 terminates). Private
+ */
+void Access_::make_grid(const Points_& Xyz, double Cellsize)
+{
+    register unsigned int i, d, N=Xyz.active_len(), Dim=Xyz.dim();
+    register int *Pos;
+    register unsigned int h;
+    
+    Cellhead.set_values(-1);
+    for (i=0; i<N; i++)
+    {
+	Pos=&Cellpos[3*i];
+	for (d=0; d<3; d++)
+	    Pos[d]=(d<Dim)? int(floor(Xyz[i][d]/Cellsize)): 0;
+	h=cell_hash(Pos[0], Pos[1], Pos[2], Cellhead.len());
+	Cellnext[i]=Cellhead[h]; Cellhead[h]=i;
+    }
+}
+// END of make_grid()
+
+/* grid_cands(): does the same as dist_cands() but visits only the 27 grid
+ * cells around the k-th point (see make_grid()). Dista must have been
+ * calculated from the points in the grid, and the cells must not be
+ * smaller than sqrt(Rcut2). Private
+ */
+unsigned int Access_::grid_cands(const Trimat_& Dista, unsigned int k, double Rcut2)
+{
+    register unsigned int Candno=0;
+    register int c, X, Y, Z;
+    const int *Pos=&Cellpos[3*k];
+    
+    for (X=Pos[0]-1; X<=Pos[0]+1; X++)
+	for (Y=Pos[1]-1; Y<=Pos[1]+1; Y++)
+	    for (Z=Pos[2]-1; Z<=Pos[2]+1; Z++)
+		for (c=Cellhead[cell_hash(X, Y, Z, Cellhead.len())]; c>=0; c=Cellnext[c])
+		{
+		    // hash collisions may bring the same chain up again
+		    if (Seen[c]==k) continue;
+		    Seen[c]=k;
+		    if ((((unsigned int)c>=k)? Dista[c][k]: Dista[k][c])<=Rcut2)
+			Cand[Candno++]=c;
+		}
+    if (Candno>1)
+	qsort(&Cand[0], Candno, sizeof(unsigned int), uint_cmp);
+    return(Candno);
+}
+// END of grid_cands()
+
 // ---- Accessibility scoring and adjustment ----
 
 /* NOTE: distance "space" accessibility adjustment is NOT ported
@@ -280,8 +396,6 @@ float Access_::score_xyz(const Polymer_& Polymer, const Points_& Xyz)
  */
 int Access_::betacone_xyz(const Polymer_& Polymer, const Points_& Xyz)
 {
-    static Trimat_ Dista;   // re-allocated when necessary
-    
     register unsigned int Rno=Polymer.len();
     
     // Xyz holds the extra N/C terminal moiety coordinates
@@ -298,8 +412,8 @@ int Access_::betacone_xyz(const Polymer_& Polymer, const Points_& Xyz)
     }
     
     // generate the shieldedness in private array
-    Xyz.dist_mat2(Dista);
-    betacone_shield(Dista, Polymer);
+    Xyz.dist_mat2(Xyzdist, Xyzcols);
+    betacone_shield(Xyzdist, Polymer, &Xyz);
     return(1);
 }
 // END of betacone_xyz()
@@ -350,6 +464,8 @@ unsigned int Access_::set_size(unsigned int Rno)
     {
 	Relsh.len(Rno); Di0.len(2*(Rno+2)); 
 	Dik.len(2*(Rno+2)); Close.len(2*(Rno+2));
+	Cand.len(Rno+2); Seen.len(Rno+2);
+	Cellhead.len(2*(Rno+2)+1); Cellnext.len(Rno+2); Cellpos.len(3*(Rno+2));
 	Surface.len(Rno); Buried.len(Rno);
 	Surface.set_values(false); Buried.set_values(false);    // clear
     }
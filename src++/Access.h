@@ -23,6 +23,7 @@
 #include "Bits.h"
 #include "Trimat.h"
 #include "Points.h"
+#include "Coords.h"
 
 // ==== CLASSES ====
 
@@ -50,6 +51,12 @@ class Access_
     
     Array_<double> Di0, Dik;	// centroid dist sq and i-k dist sq
     Array_<unsigned int> Close;	// index lookup
+    Array_<unsigned int> Cand, Seen;	// candidate residues for a beta, duplicate filter
+    Array_<int> Cellhead, Cellnext, Cellpos;	// spatial hash of the alphas for betacone_xyz()
+    
+    Fakebeta_ Fakebeta;	// fake C-beta workspace for betacone_shield()
+    Trimat_ Xyzdist;	// distance workspace for betacone_xyz()
+    Coords_ Xyzcols;	// column-wise coordinate workspace for betacone_xyz()
     
     Bits_ Surface, Buried;	    // residues with known accessibilities
     
@@ -60,7 +67,10 @@ class Access_
     /* Inits to keep track of Rno>=0 (default 0) amino acids. */
     Access_(unsigned int Rno=0): 
 	Relsh(Rno), Di0(2*(Rno+2)), Dik(2*(Rno+2)), 
-	Close(2*(Rno+2)), Surface(Rno), Buried(Rno) {}
+	Close(2*(Rno+2)), Cand(Rno+2), Seen(Rno+2), 
+	Cellhead(2*(Rno+2)+1), Cellnext(Rno+2), Cellpos(3*(Rno+2)), 
+	Fakebeta(Rno), Xyzdist(Rno+2), 
+	Surface(Rno), Buried(Rno) {}
 
 	// size
     /* set_size(): resets the size of the internal arrays to Rno,
@@ -84,7 +94,9 @@ class Access_
     
     /* score_dist(),score_xyz(): calculate an accessibility score
      * (optimum 0.0) for distance spaces and Euclidean objects, 
-     * respectively.
+     * respectively. The neighbours are preselected using the triangle
+     * inequality, so Dista for score_dist() should be a Euclidean
+     * distance matrix (in any dimension, e.g. made from coordinates).
      * Return a very high value on error.
      */
     float score_dist(const Polymer_& Polymer, const Trimat_& Dista);
@@ -119,7 +131,11 @@ class Access_
     friend ostream& operator<<(ostream& Out, const Access_& Access);
     
     private:
-    void betacone_shield(const Trimat_& Dista, const Polymer_& Polymer);
+    void betacone_shield(const Trimat_& Dista, const Polymer_& Polymer, 
+	    const Points_ *Xyz=NULL);
+    unsigned int dist_cands(const Trimat_& Dista, unsigned int k, double Rcut2);
+    void make_grid(const Points_& Xyz, double Cellsize);
+    unsigned int grid_cands(const Trimat_& Dista, unsigned int k, double Rcut2);
     int betacone_xyz(const Polymer_& Polymer, const Points_& Xyz);
     float get_score(const Polymer_& Polymer) const;
     static int get_shield(double Rsh, char Aa);
@@ -15,6 +15,7 @@
 
 #include "Vector.h"
 #include "Sqmat.h"
+#include "Vec3.h"
 #include "Hirot.h"
 
 // ---- MODULE HEADER ----
@@ -371,21 +372,24 @@ double Beta_::ideal_struct(Points_& Model) const
     if (Rmsdown<0.0) return(-1.0);
     
     /* now replace the active segment in Model by the rotated Id
-     * taking the Strict into account
+     * taking the Strict into account (in place, with 3D temporaries)
      */
     register unsigned int i, L=Betamask.on_no();
     register float Strict1=1.0-Strict;
+    const Points_ *Idbest=&Idup;
+    Mat3_ Srot(Rotup);
+    Vec3_ Mi;
     
-    if (Rmsup<=Rmsdown)	    // choose better fit
+    if (Rmsup>Rmsdown)	    // choose better fit
     {
-	for (i=0; i<L; i++)
-	    Model[i]=Strict1*Model[i]+Strict*Rotup*Idup[i];
+	Idbest=&Iddown; Srot.get(Hr.rot_matrix());
+	Rmsup=Rmsdown;	// will be returned
     }
-    else
+    Srot*=Strict;
+    for (i=0; i<L; i++)
     {
-	for (i=0; i<L; i++)
-	    Model[i]=Strict1*Model[i]+Strict*Hr.rot_matrix()*Iddown[i];
-	Rmsup=Rmsdown;	// will be returned
+	Mi.get(Model[i]);
+	(Strict1*Mi+Srot*Vec3_((*Idbest)[i])).put(Model[i]);
     }
     Model+=Mctr;    // transpose back to original centroid
     
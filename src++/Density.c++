@@ -18,6 +18,7 @@
 // ---- UTILITY HEADERS ----
 
 #include "Sqmat.h"
+#include "Vec3.h"
 #include "Ql.h"
 
 // ---- PROTOTYPES ----
@@ -96,7 +97,7 @@ double scale_distdens(Trimat_& Dist, double Rmax)
  */
 double proj_dens(const Trimat_& Dist, const Pieces_& Pieces, Points_& Xyz)
 {
-    static Trimat_ Newdist; // will be resized every time when necessary
+    Trimat_ Newdist;
 
     double Fact, Sdx, Sx2, Xij;
     register unsigned int i, j,Ptno=Dist.rno();
@@ -164,12 +165,15 @@ double ellips_dens(double Expdens, const Pieces_& Pieces, Points_& Xyz)
     
     // rotate to new coord system and substitute into 3D ellipsoid equation
     double Coord123;
+    Mat3_ Evm(Evec);
+    Vec3_ Xi;
     for (i=0; i<Ptno; i++)
     {
 	Ellips[i]=0.0;
+	Xi.get(Xyz[i]);
 	for (j=0; j<3; j++)
 	{
-	    Coord123=Xyz[i]*Evec.row(j);
+	    Coord123=Xi*Evm.row(j);
 	    Ellips[i]+=(Coord123*Coord123/Evals[j]);
 	}
     }
@@ -61,6 +61,9 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <math.h>
+#ifdef ALLOC_STATS
+    #include <new>
+#endif
 
 // ---- C++ MODULE HEADERS ----
 
@@ -78,6 +81,7 @@
 #include "Pieces.h"
 #include "Polymer.h"
 #include "Output.h"
+#include "Runpool.h"
 #include "Score.h"
 #include "Sigproc.h"
 #include "Score.h"
@@ -97,6 +101,7 @@
 // ---- C++ UTILITY HEADERS ----
 
 #include "String.h"
+#include "Distcache.h"
 
 // ---- C UTILITY HEADERS ----
 
@@ -123,6 +128,85 @@ static Steric_ Steric;
 static unsigned int Rno=10;	    // just a non-0 value
 static Pieces_ Pieces(Rno);	    // must have a ctor
 
+static Runpool_ Runpool;	// worker threads for multithreaded runs
+static long Runseed=0;	// the RNG seed of the current set of runs
+static int Firstrun=1;	// the number of the first run (-f option)
+
+// ---- ALLOCATION STATISTICS ----
+
+/* If ALLOC_STATS is defined (GCC only), then all heap allocations
+ * are counted by the operator new below and the number of
+ * allocations and bytes of each cycle are printed by sim_run().
+ * The counters are kept for each thread separately.
+ */
+#ifdef ALLOC_STATS
+static __thread unsigned long Allocno=0, Allocbytes=0;
+
+void *operator new(size_t Size) throw(std::bad_alloc)
+{
+    Allocno++; Allocbytes+=Size;
+    void *Ptr=malloc(Size? Size: 1);
+    if (Ptr==NULL) throw std::bad_alloc();
+    return(Ptr);
+}
+
+void operator delete(void *Ptr) throw() { free(Ptr); }
+#endif
+
+// ---- SIMULATION CONTEXTS ----
+
+/* Simctx_: holds everything that is modified during a simulation run.
+ * In serial, multiprocess and PVM runs there is just one context
+ * which works on the static global Restraints, Access, Pieces
+ * and Steric objects. In multithreaded runs each worker thread
+ * has a context of its own which works on private copies of these
+ * (see Thrctx_ below).
+ */
+struct Simctx_
+{
+    Restraints_& Restraints;
+    Access_& Access;
+    Pieces_& Pieces;
+    Steric_& Steric;
+    Runpool_ *Pool;	// the pool of the worker thread or NULL
+    ostream& Out;	// the reports of the runs go here...
+    ostream& Err;	// ...and the error messages here (cf. Runpool_::out())
+    
+    Iproj_ Iproj;	// projection
+    Tangles_ Tangles;	// detangling
+    Trimat_ Dista, Distbest;	// distance matrices: extra 2 points for N/C term
+    Distcache_ Distcache;   // incremental Model->Dista refreshes
+    Coords_ Distwork;	// column-wise Model for the full Model->Dista conversions
+    Fakebeta_ Fakebeta;	// puts extra 2 points there automagically
+    Points_ Model, Best;    // coordinates
+    Scores_ Distsco, Euclsco, Bestsco;	// scores
+    int Graph;	    // graphics flag
+    #ifdef USE_OPENGL_GRAPHICS
+	Graphics_ Draw;
+    #endif
+    #ifdef USE_THREADS
+	struct timespec Cpustart;   // thread CPU time at the start of the run
+    #endif
+    
+    Simctx_(Restraints_& Rs, Access_& Ac, Pieces_& Ps, Steric_& St, 
+	    Runpool_ *Rp=NULL);
+};
+
+/* Thrctx_: the simulation context of a worker thread
+ * together with the private copies of the global objects.
+ */
+struct Thrctx_
+{
+    Restraints_ Restraints;
+    Access_ Access;
+    Pieces_ Pieces;
+    Steric_ Steric;
+    Simctx_ *Sim;
+    
+    Thrctx_(Runpool_& Pool);
+    ~Thrctx_() { delete Sim; }
+};
+
 // ---- PROTOTYPES ----
 
 #ifdef USE_PVM
@@ -132,6 +216,11 @@ static void init_pvmslave();
 
 unsigned int dragon_run(unsigned int Runno=1);
 static void init_dragon();
+static int thread_runs(unsigned int Runno);
+static void run_worker(Runpool_& Pool, unsigned int Thridx, void *);
+static int sim_run(Simctx_& Sim, int Rcyc, unsigned int Attempt, bool& Repeat);
+static void start_runtimer(Simctx_& Sim);
+static long runtimer_results(Simctx_& Sim);
 static void merge_distmat(const Trimat_& Bestdist, Trimat_& Dist);
 
 // ==== MAIN ====
@@ -145,12 +234,14 @@ int main(int argc,  char *argv[])
      * -c command_file: interprets commands from command_file
      * Neither -p nor -c: interactive mode (cf. "Clip" module)
      * -h: prints a short help
+     * -f first_run: numbers the runs from first_run instead of 1
      * -m procno: spawns procno processes for parallel runs (min. 2)
+     * -t thrno: runs the simulations in thrno threads (overrides -m)
      * -M: spawns a slave task on every node in the PVM if available
      * -A: give The Answer and exit
      * The options are processed by the "cmdopt" module.
      */
-    parse_optstr("hA c%s<command_file> m%d<process_no> M p%s<param_file> r%d<run_no>");
+    parse_optstr("hA c%s<command_file> f%d<first_run> m%d<process_no> M p%s<param_file> r%d<run_no> t%d<thread_no>");
     if (get_options(argc, argv)<0 || optval_bool('h'))
     {
 	char *Help=opt_helpstr();   // generate help string
@@ -159,6 +250,7 @@ int main(int argc,  char *argv[])
 	cerr<<"Options:-\n";
 	cerr<<"No options: run in interactive mode (press \'h\' for help)\n";
 	cerr<<"-c <command_file>: execute commands from <command_file>\n";
+	cerr<<"-f <first_run>: number the runs from <first_run> (default 1)\n";
 	cerr<<"-h: print this help and exit\n";
 	cerr<<"-m <process_no>: spawn <process_no> processes (>=2) for parallel runs\n";
 #ifdef USE_PVM
@@ -166,6 +258,7 @@ int main(int argc,  char *argv[])
 #endif
 	cerr<<"-p <param_file>: perform one run with parameters in <param_file>\n";
 	cerr<<"-p <param_file> -r <run_no>: perform <run_no> runs with parameters in <param_file>\n";
+	cerr<<"-t <thread_no>: run the simulations in <thread_no> threads (overrides -m)\n";
 	cerr<<"-A: give The Answer and exit\n";
 	free(Help);
 	return(EXIT_FAILURE);
@@ -199,6 +292,12 @@ int main(int argc,  char *argv[])
     #else
 	cout<<"not supported\n";
     #endif
+    cout<<"Threads: ";
+    #ifdef USE_THREADS
+	cout<<"supported\n";
+    #else
+	cout<<"not supported\n";
+    #endif
     cout<<"OpenGL graphics: ";
     #ifdef USE_OPENGL_GRAPHICS
 	cout<<"supported\n";
@@ -337,10 +436,24 @@ int main(int argc,  char *argv[])
     {
 #endif
 	// set the multiple process management object
-	int Mproc=0;
+	int Mproc=0, Thrno=0;
 	optval_int('m', &Mproc);
+	
+	// threads take precedence over processes
+	if (optval_int('t', &Thrno) && (Thrno=Runpool.set_maxthrno(Thrno)))	// = intended
+	{
+	    cout<<Thrno<<" parallel threads enabled.\n";
+	    Mproc=0;
+	}
 	if (Mproc=Sigproc.set_maxprocno(Mproc))	// = intended
 	    cout<<Mproc<<" parallel processes enabled.\n";
+	
+	// run numbering (together with Randseed this decides the random start)
+	if (optval_int('f', &Firstrun) && Firstrun<1)
+	{
+	    cerr<<"\n? Invalid first run number "<<Firstrun<<", 1 used\n";
+	    Firstrun=1;
+	}
 
 	if (Runno)
 	    Dretval=dragon_run(Runno); // run Runno times
@@ -566,13 +679,59 @@ static void init_dragon()
 	if (Params.changed("Sstrfnm"))
 	    Pieces.read_secstr(Params.s_value("Sstrfnm"));
     }
-    Restraints.setup_restr(Pieces, Polymer);
+    Restraints.setup_restr(Pieces, Polymer, Runpool.max_thrno());	// smoothing threads
     Steric.setup(Rno);
+    Steric.spec_threads(Runpool.max_thrno());	// spectral gradient threads
     
     cout<<"\n=== SECONDARY STRUCTURE ===\n\n"<<Pieces;
 }
 // END of init_dragon()
 
+/* Simctx_::Simctx_(): sets up a simulation context which works on
+ * the objects Rs, Ac, Ps and St. Rp is the pool if the context belongs
+ * to a worker thread, NULL otherwise (the default). In a worker thread
+ * the context must be set up by the thread itself, because it writes
+ * to the streams of the calling thread.
+ */
+Simctx_::Simctx_(Restraints_& Rs, Access_& Ac, Pieces_& Ps, Steric_& St, 
+	Runpool_ *Rp):
+	Restraints(Rs), Access(Ac), Pieces(Ps), Steric(St), Pool(Rp), 
+	Out(Rp!=NULL? Rp->out(): cout), Err(Rp!=NULL? Rp->err(): cerr), 
+	Iproj(Rno+2), Tangles(Ps), 
+	Dista(Rno+2), Distbest(Rno+2), Fakebeta(Rno), 
+	Model(Rno+2, Rno), Best(Rno+2), 
+	Distsco(Params.f_value("Minscore"), Params.f_value("Minchange")), 
+	Euclsco(Params.f_value("Minscore"), Params.f_value("Minchange")), 
+	Bestsco(Params.f_value("Minscore"), Params.f_value("Minchange")), 
+	Graph(0)
+{
+    // set up projection
+    Iproj.set_size(Rno+2);
+    Iproj.make_clusters();
+    
+    // init the scoring system
+    Steric.reset_viol(Restraints, Rno+2, Distsco);
+    Steric.reset_viol(Restraints, Rno+2, Euclsco);
+    Steric.reset_viol(Restraints, Rno+2, Bestsco);
+}
+// END of Simctx_()
+
+/* Thrctx_::Thrctx_(): makes private copies of the global objects
+ * which are modified during a run and sets up a simulation context
+ * on them for the worker threads of Pool. The secondary structure
+ * is read again because Pieces_ objects cannot be copied.
+ * Must be called with the pool locked.
+ */
+Thrctx_::Thrctx_(Runpool_& Pool):
+	Restraints(::Restraints), Access(::Access), 
+	Pieces(Rno), Steric(::Steric), Sim(NULL)
+{
+    Pieces.read_secstr(Params.s_value("Sstrfnm"));
+    Steric.spec_threads(1);	// the runs are parallel already
+    Sim=new Simctx_(Restraints, Access, Pieces, Steric, &Pool);
+}
+// END of Thrctx_()
+
 /* dragon_run(): performs a full DRAGON simulation run Runno (default 1)
  * times using the parameters in Params. The objects inside are
  * updated only at the entry and only if the corresponding parameters
@@ -581,6 +740,8 @@ static void init_dragon()
  * processes will run Runno/Mproc simulations sequentially.
  * If Mproc==1, then a separate process will be launched for each
  * of the Runno simulations. No process will be spawned if Runno==1.
+ * If threads were enabled with the -t option, then the runs are
+ * distributed among worker threads instead (see thread_runs()).
  * Return value: 0 if OK, otherwise the value of a signal caught inside.
  * From Version 4.11 on, PVM support is also built in. The PVM status
  * is read from the static global Pvmtask object.
@@ -594,61 +755,52 @@ unsigned int dragon_run(unsigned int Runno)
 #endif
 	init_dragon();  // non-PVM cases
 
-    // set up projection
-    Iproj_ Iproj(Rno+2);
-    Iproj.set_size(Rno+2);
-    Iproj.make_clusters();
-
-    // set up detangling
-    Tangles_ Tangles(Pieces);
-    static const double TADJ=0.5;   // tangle adjustment scaling
-    unsigned int Tangviol=0, Tangiter=Params.i_value("Tangiter");
-    
-    // set up the distance matrix and the coordinates: allow extra 2 points for N/C term
-    Trimat_ Dista(Rno+2), Distbest(Rno+2);
-    Fakebeta_ Fakebeta(Rno);	// puts extra 2 points there automagically
-    Points_ Model(Rno+2, Rno), Best(Rno+2);
-    
-    // set up scores
-    Scores_ Distsco(Params.f_value("Minscore"), Params.f_value("Minchange")), 
-	Euclsco(Params.f_value("Minscore"), Params.f_value("Minchange")), 
-	Bestsco(Params.f_value("Minscore"), Params.f_value("Minchange"));
-
-    // init graphics if enabled
-    int Graph=Params.i_value("Graph");
-    #ifdef USE_OPENGL_GRAPHICS
-	Graphics_ Draw;
-	if (Graph) Draw.update_polymer(Polymer);
-    #endif
-    
     // set the floating-point output for cout and cerr
     long Coutf=cout.flags(), Cerrf=cerr.flags();
     int Oldoutprec=cout.precision(3), Olderrprec=cerr.precision(3);
     cout.precision(3); cout.setf(ios::scientific, ios::floatfield);
     cerr.precision(3); cerr.setf(ios::scientific, ios::floatfield);
     
-    // ---- Main iteration cycle ----
-    
-    // codes for various exit types
-    typedef enum {NOEXIT=0, EXIT_SIGNAL, EXIT_CTRLC, EXIT_SCOREOK,
-	EXIT_MAXITER, EXIT_REPROJ} Exitreason_ ;
-    Exitreason_ Exreason=NOEXIT;
+    int Signal=0, Logfd=-1;
     
-    unsigned int Itno=0, It3dno=0, Dim=Rno+2, Oldim=Rno+2, 
-	Bestfound=0, Reprojmax, Repriter, Reprojno, 
-	Speciter=Params.i_value("Speciter");
-    float Stress=0.0, Rmss=0.0, Densfact=0.0, Speceps=Params.f_value("Speceps");
-    int Signal=0, Handflip=1, Logfd, Workdone=0, Noconv=0;
-    String_ Outname, Logname;
+    /* The random starting distance matrix of each run depends on
+     * Runseed and the run number only (cf. sim_run()). If the "Randseed"
+     * parameter is 0, then the time(NULL) value is used as the seed
+     * for the whole set of runs: it is printed for each run so that
+     * any run (including its repeats, cf. sim_run()) can be reproduced
+     * on its own later by setting "Randseed" and the run number
+     * (-f option). Must be set before the children
+     * are spawned or the threads are started.
+     */
+    Runseed=Params.i_value("Randseed");
+    if (!Runseed) Runseed=time(NULL);
     
-    // set 3D reprojections
-    Reprojmax=Params.i_value("Maxiter")/10+1;
-    if (Reprojmax<3) Reprojmax=3;
+    /* Multithreaded runs: the worker threads take care of
+     * everything (including their own simulation contexts)
+     */
+    if (Runpool.is_threaded() && Runno>1
+#ifdef USE_PVM
+	&& !Pvmtask.is_slave()
+#endif
+	)
+    {
+	Signal=thread_runs(Runno);
+	
+	// reset the floating-point output for cout and cerr
+	cout.flags(Coutf); cerr.flags(Cerrf);
+	cout.precision(Oldoutprec); cerr.precision(Olderrprec);
+	return(Signal);
+    }
     
-    // init the scoring system
-    Steric.reset_viol(Restraints, Rno+2, Distsco);
-    Steric.reset_viol(Restraints, Rno+2, Euclsco);
-    Steric.reset_viol(Restraints, Rno+2, Bestsco);
+    // the simulation context works on the global objects
+    Simctx_ Sim(Restraints, Access, Pieces, Steric);
+
+    // init graphics if enabled
+    int& Graph=Sim.Graph;
+    Graph=Params.i_value("Graph");
+    #ifdef USE_OPENGL_GRAPHICS
+	if (Graph) Sim.Draw.update_polymer(Polymer);
+    #endif
     
     /* Set up multiple process spawns. DRAGON can run in parallel
      * either if a -m flag requested that several copies be spawned
@@ -681,6 +833,9 @@ unsigned int dragon_run(unsigned int Runno)
 	 * or a PVM slave
 	 */
 	int Rcyc, Rcyclo, Rcychi;
+	unsigned int Attempt=0;	// no. of repeats of the current run
+	bool Repeat;
+	String_ Logname;
 	
 #ifdef USE_PVM
 	/* for PVM runs, interpret Runno as the simulation limits */
@@ -688,7 +843,10 @@ unsigned int dragon_run(unsigned int Runno)
 	    Rcyclo=Rcychi=Runno;    
 	else
 #endif
+	{
 	    Sigproc.get_runlimits(Runno, Rcyclo, Rcychi);
+	    Rcyclo+=Firstrun-1; Rcychi+=Firstrun-1;
+	}
 
 	cout<<"RUN from "<<Rcyclo<<" to "<<Rcychi<<endl;
 	
@@ -722,463 +880,623 @@ unsigned int dragon_run(unsigned int Runno)
 		
 	    }
 	    
-	    cout<<"\nRUN "<<Rcyc<<" STARTED: "<<time_stamp()<<endl;
-	    start_timer();
-	    
-	    /* Initialise the distance matrix to random values
-	     * within the pre-calculated bounds, modified by the
-	     * hydrophobic distances for "soft" restraints.
-	     * If the "Randseed" parameter is 0, then the time(NULL)
-	     * value is used as the seed (this is fairly random).
-	     * For parallel runs, this value is "spiced"
-	     * with either the task ID (under PVM) or the child
-	     * process ID (multiprocess run) to avoid identical
-	     * seeds on time-sychronised machines.
-	     */
-	    long Randseed=Params.i_value("Randseed");
-	    if (!Randseed || Runno>1)  // "random" start (always w/ multiples)
+	    Signal=sim_run(Sim, Rcyc, Attempt, Repeat);
+	    if (Repeat)
 	    {
-		Randseed=time(NULL);
-	    #ifdef USE_PVM
-		if (Pvmtask.is_slave())
-		    Randseed+=Pvmtask.tid();
-	    #endif
-		if (Sigproc.is_child())
-		    Randseed+=1024*getpid();	// give it a "large" perturbation
+		Rcyc--; Attempt++;	// start from different random matrix
 	    }
-	    cout<<"# Randseed="<<Randseed<<endl;
-	    Restraints.init_distmat(Dista, Polymer, Randseed);
+	    else Attempt=0;
+	}	    // for Rcyc (all simulations)
+	
+	// close windows if graphics was on
+	#ifdef USE_OPENGL_GRAPHICS
+	    if (Graph) Sim.Draw.close_window();
+	#endif
+
+    	if (Sigproc.is_child())
+	{
+	    close(Logfd);
+	    exit(Signal);
+	}
+    }	    // else: child or single simulation process
+
+    // reset the floating-point output for cout and cerr
+    cout.flags(Coutf); cerr.flags(Cerrf);
+    cout.precision(Oldoutprec); cerr.precision(Olderrprec);
     
-	    Itno=It3dno=Repriter=Reprojno=0;
-	    Oldim=Dim=Rno+2; Bestfound=0;
-	    Rmss=0.0; Densfact=0.0;
-	    Distsco.set_noexit();	// "prime" the scores
-	    Euclsco.set_noexit();
-	    Bestsco.set_noexit();
-	    Exreason=NOEXIT;
-	    
-	    /* Signal traps: most non-fatal signals are trapped
-	     * and then the handler throws a Sigexcept_
-	     * exception.
-	     */
-	    Sigproc.set_signal((SIG_PF)signal_handler);	    // set up signal trap
-	    do	// <--cycle until finished, interrupted or crashed
-	    {
-		try	// look for signal exceptions
-		{
-		    // print how much we have done
-		    Workdone=int(100.0*((Dim==3)? Rno-1+It3dno: 3.0-Dim+Rno-1.0)/(Rno-1.0+Params.i_value("Maxiter")));
-	    	    stop_timer();
-		    cout<<"CYCLE: "<<(Itno+1)<<" ("
-			<<Workdone<<"%, "
-			<<time_string(timer_results(TS_UTIME|TS_STIME))
-			<<")\n";
-		#ifdef USE_PVM
-		    // tell the master which cycle is being done
-		    if (Pvmtask.is_slave())
-			Pvmtask.job_status(Pvmtask_::SLAVE_RUNNING, Itno+1);
-		#endif
-		    // distance "space" adjustments in hyperspace:
-		    if (Dim>3 || Repriter==Reprojmax)
-		    {
-			// in 3D, count how many reprojections were done
-			if (Dim==3) Reprojno++;
-			
-			// make distance matrix from previous coords
-			if (Itno) Model.dist_mat2(Dista);
+    return(Signal);
+}
+// END of dragon_run()
+
+/* thread_runs(): performs Runno simulations in parallel worker threads
+ * managed by the static Runpool object. Each worker sets up its own
+ * simulation context and writes a logfile for each run just like
+ * the child processes do in multiprocess runs.
+ * Return value: 0 if OK, otherwise the value of a signal caught inside.
+ */
+static int thread_runs(unsigned int Runno)
+{
+    // the lazy hydrophobic distance estimation must be done beforehand
+    Polymer.update_estim();
+    
+    /* Parameter enquiries reset the "changed" bits. Do it here
+     * for all of them, so that the workers only read Params
+     * (init_dragon() has already acted on the bits that matter)
+     */
+    Params.reset_changed();
+    int Signal=Runpool.run_all(Runno, run_worker);
+    if (Signal)
+	cout<<"Threaded runs stopped by signal "<<Signal<<".\n";
+    else
+	cout<<Runno<<" run"<<(Runno==1? "":"s")<<" done in threads.\n";
+    return(Signal);
+}
+// END of thread_runs()
+
+/* run_worker(): the worker function executed by each thread of Pool.
+ * Thridx is the index of the thread, the last argument is not used.
+ * The worker takes runs from the pool until
+ * there are none left or a signal stops the pool.
+ */
+static void run_worker(Runpool_& Pool, unsigned int Thridx, void *)
+{
+    int Rcyc, Signal=0;
+    unsigned int Attempt;
+    bool Repeat;
+    String_ Logname;
     
-			// adjust density
-			Densfact=scale_distdens(Dista,
-			    Restraints.exp_rad(Rno, Params.f_value("Density")));
+    // private copies of the global objects are made one by one
+    Pool.lock();
+    Thrctx_ *Ctx=new Thrctx_(Pool);
+    Pool.unlock();
     
-			// "blend in" previous best distmat
-			if (Dim==3 && Bestfound)
-			    merge_distmat(Distbest, Dista);
-			
-			// ideal distances
-			Fakebeta.update(Dista, Polymer);    // get C:beta-related distances
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-				Pieces, Steric_::ALL | Steric_::RESTR | Steric_::SPECGRAD);
-			Steric.adjust_dist(Dista, Pieces, Steric_::ALL);
-			
-			// display new distance matrix
-			#ifdef USE_OPENGL_GRAPHICS
-			    if (Graph) Draw.display_dist(Dista);
-			#endif
-			
-			/* perform full projection: in 3.x compatibility mode
-			 * the overall projection will automatically be used
-			 * (cf. above the Iproj.set_size() call)
-			 */
-			Dim=Iproj.full_project(Dista, Params.f_value("Evfract"), Oldim, Model);
-	    
-			// post-projection refinement
-			Densfact=proj_dens(Dista, Pieces, Model);
-			Noconv=0;
-			Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);	// uses the pre-projection dists
-			if (Noconv || Stress<0.0)	// on error or no convergence
-			{
-			    Model.dist_mat2(Dista);
-			    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL);
-			}
-			
-			/* See if the BOND distance scores improved compared to
-			 * the previous embedding: if yes, then employ
-			 * a bolder dim reduction strategy 
-			 */
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);    // get C:beta-related distances
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-				Pieces, Steric_::ALL | Steric_::RESTR | Steric_::SCORE, &Distsco);
-			if (Distsco[Scores_::BOND].change()<0)
-			    Oldim=(Dim>4)? (2*(Dim-3))/3+3: 4;
-			else
-			    Oldim=(Dim>3)? Dim: 4;
-			
-			/* 3D-specific things: overall handedness adjustment,
-			 * reset 3D reproj counter
-			 */
-			if (Dim==3)
-			{
-			    // get correct enantiomer from comparison to known homol. struct
-			    if (Homodel.known_no()>0)
-				Handflip=Homodel.hand_check(Model);
-			    else	// we are on our own (check is based on secstr hands)
-				Handflip=hand_check(Pieces, Model);
-			    Repriter=0;
-			}
-			
-			// get accessibility score and list
-			Distsco[Scores_::ACCESS].score(Access.score_dist(Polymer, Dista));
-			cout<<"DIST: "<<Distsco<<endl;
-			cout<<"PROJ: Dim="<<Dim<<", Df="<<Densfact
-			    <<",  STR="<<Stress<<" ";
-			if (Dim==3 && Handflip==-1)
-			    cout<<", flip";
-			cout<<endl;
-			
-		    }	// if projection
+    while (!Signal && (Rcyc=Pool.next_run())>0)
+    {
+	Rcyc+=Firstrun-1;
 	
-		    // ---- Euclidean space adjustments ----
-		    
-		    #ifdef USE_OPENGL_GRAPHICS
-			if (Graph)
-			{
-			    Draw.display_eucl(Dista);
-			    Draw.display_coords(Model);
-			}
-		    #endif
-		    
-		    // detangling and RBA
-		    if (Pieces.clu_no()>1)
-		    {
-			Tangiter=Params.i_value("Tangiter");	// reset
-			Tangviol=Tangles.tangle_elim(Pieces, Model, TADJ, Tangiter);
-			cout<<"TNGL: "<<Tangviol<<" (cyc="<<Tangiter<<")"<<endl;
-			
-			if (Tangiter)   // had to do detangling
-			{
-			    Model.dist_mat2(Dista);
-			    Fakebeta.update(Dista, Polymer);
-			    Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-				    Pieces, Steric_::BETWEEN | Steric_::RESTR);
-			    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::BETWEEN);
-			}
-		    }
-		    // accessibility
-		    Access.solvent_xyz(Polymer, Pieces.hbond_bits(), Model);
-		    
-		    // 3D isotropic ellipsoidal density adjustment
-		    if (Dim==3)
-			Densfact=ellips_dens(Params.f_value("Density"), Pieces, Model);
-		    
-		    /* If the model is composed of several clusters, then first
-		     * the clusters are adjusted ("WITHIN"), then the relative
-		     * positions of the clusters ("BETWEEN"), finally all
-		     * atoms move together ("ALL"). Sub-adjustments are for
-		     * external restraints ("NMR" and 2o str), 
-		     * then all.
-		     */
-		    cout<<"EUCL: ";
-		    if (Pieces.clu_no()>1)
-		    {
+	// redirect the output of this thread to a logfile
+	Logname=Params.s_value("Outfnm");
+	Pool.lock();	    // may create the output directory
+	make_outname(Logname, Rcyc, "log");
+	Pool.unlock();
+	if (Pool.open_log(Logname))
+	    Pool.out()<<"WORKER THREAD #"<<(Thridx+1)<<endl;
+	
+	Attempt=0;
+	do
+	    Signal=sim_run(*(Ctx->Sim), Rcyc, Attempt++, Repeat);
+	while (Repeat && !Signal);
+	Pool.close_log();
+    }
+    delete Ctx;
+}
+// END of run_worker()
 
-			// WITHIN-external
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-				Pieces, Steric_::WITHIN | Steric_::REXT);
-			Steric.adjust_xyz(Dista, Model, Pieces, Steric_::WITHIN);
-			
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-				Pieces, Steric_::WITHIN | Steric_::REXT | Steric_::SPECGRAD);
-			Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
-			if (Noconv || Stress<0.0)
-			    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::WITHIN);
-			
-			// WITHIN-all
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-				Pieces, Steric_::WITHIN | Steric_::RESTR);
-			Steric.adjust_xyz(Dista, Model, Pieces, Steric_::WITHIN);
-			
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-				Pieces, Steric_::WITHIN | Steric_::RESTR | Steric_::SPECGRAD);
-			Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
-			if (Noconv || Stress<0.0)	// on error or no convergence
-			{
-			    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::WITHIN);
-			    cout<<"IN=???";
-			}
-			else cout<<"IN="<<Stress;
-			
-			#ifdef USE_OPENGL_GRAPHICS
-			    if (Graph) Draw.display_coords(Model);
-			#endif
-			
-			// cluster hydrophobic moment rotation
-    	    	    	hmom_clurot(Pieces, Polymer, Model);
-		    
-			// BETWEEN-external
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-				Pieces, Steric_::BETWEEN | Steric_::REXT);
-			Steric.adjust_xyz(Dista, Model, Pieces, Steric_::BETWEEN);
-			
-			// BETWEEN-all (RBA)
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-				Pieces, Steric_::BETWEEN | Steric_::RESTR);
-			Steric.adjust_xyz(Dista, Model, Pieces, Steric_::BETWEEN);
-			
-			#ifdef USE_OPENGL_GRAPHICS
-			    if (Graph) Draw.display_coords(Model);
-			#endif
-			
-		    }
-		    
-		    /* Adjusting all atoms together. If the model
-		     * is just one piece, then this is carried out 3 times
-		     * to compensate for the lost WITHIN/BETWEEN adjustments.
-		     */
-		    for (int i=0; i<(Pieces.clu_no()>1? 1: 3); i++)
-		    {
-			// ALL-external
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-			    Pieces, Steric_::ALL | Steric_::REXT);
-			Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL);
-		    
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-			    Pieces, Steric_::ALL | Steric_::REXT | Steric_::SPECGRAD);
-			Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
-			if (Noconv || Stress<0.0)
-			    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL);
-			    
-			// secondary structure adjustment (in 3D only!)
-			if (Dim==3)
-			{
-			    Rmss=apply_secstruct(Pieces, Model);    // fit ideal secstr in 3D
-			    cout<<" 2oSTR="<<Rmss;
-			}
-			// ALL-all
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-			    Pieces, Steric_::ALL | Steric_::RESTR);
-			Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL);
-		    
-			Model.dist_mat2(Dista);
-			Fakebeta.update(Dista, Polymer);
-			Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-			    Pieces, Steric_::ALL | Steric_::RESTR | Steric_::SPECGRAD);
-			Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
-			if (Noconv || Stress<0.0)	// on error or no convergence
-			{
-			    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL);
-			    cout<<" ALL=???";
-			}
-			else cout<<" ALL="<<Stress;
-		    }
-		    cout<<endl;
-		    
-		    #ifdef USE_OPENGL_GRAPHICS
-			if (Graph)
-			{
-			    Draw.display_eucl(Dista);
-			    Draw.display_coords(Model);
-			}
-		    #endif
-		    
-		    // adjust CA:CA bonds and CA(i):CA(i+2) only
-		    Model.dist_mat2(Dista);	// Fakebeta ignored, no update: only CAs
-		    Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-			Pieces, Steric_::ALL|Steric_::BOND);
-		    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL);
-		    
-		    // same with Specgrad as well: usually converges after Willie's adjustment
-		    Model.dist_mat2(Dista);
-		    Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-			Pieces, Steric_::ALL|Steric_::BOND|Steric_::SPECGRAD);
-		    Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
+/* sim_run(): performs the Rcyc-th simulation on the objects in the
+ * simulation context Sim. Attempt is the number of times this run
+ * has been repeated already (0 for the first try). Repeat is set to "true" if the run did not produce a result and has
+ * to be repeated from another random distance matrix.
+ * Return value: 0 if OK, otherwise the value of a signal caught inside.
+ */
+static int sim_run(Simctx_& Sim, int Rcyc, unsigned int Attempt, bool& Repeat)
+{
+    /* The names below shadow the static globals on purpose: 
+     * the simulation works on the objects of its context
+     */
+    Restraints_& Restraints=Sim.Restraints;
+    Access_& Access=Sim.Access;
+    Pieces_& Pieces=Sim.Pieces;
+    Steric_& Steric=Sim.Steric;
+    Iproj_& Iproj=Sim.Iproj;
+    Tangles_& Tangles=Sim.Tangles;
+    Trimat_& Dista=Sim.Dista, &Distbest=Sim.Distbest;
+    Distcache_& Distcache=Sim.Distcache;
+    Coords_& Distwork=Sim.Distwork;
+    Fakebeta_& Fakebeta=Sim.Fakebeta;
+    Points_& Model=Sim.Model, &Best=Sim.Best;
+    Scores_& Distsco=Sim.Distsco, &Euclsco=Sim.Euclsco, &Bestsco=Sim.Bestsco;
+    ostream& Out=Sim.Out, &Err=Sim.Err;
+    int Graph=Sim.Graph;
+    #ifdef USE_OPENGL_GRAPHICS
+	Graphics_& Draw=Sim.Draw;
+    #endif
     
-		    // generate violation score (different from Stress)
-		    Model.dist_mat2(Dista);
-		    Fakebeta.update(Dista, Polymer);
-		    Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
-			    Pieces, Steric_::ALL | Steric_::RESTR | Steric_::SCORE, &Euclsco);
-		    Euclsco[Scores_::ACCESS].score(Access.score_xyz(Polymer, Model));
+    // set up detangling
+    static const double TADJ=0.5;   // tangle adjustment scaling
+    unsigned int Tangviol=0, Tangiter=Params.i_value("Tangiter");
     
-		    // save best if in 3D and score was acceptable and wasn't tangled
-		    if (Dim==3)
+    // ---- Main iteration cycle ----
+    
+    // codes for various exit types
+    typedef enum {NOEXIT=0, EXIT_SIGNAL, EXIT_CTRLC, EXIT_SCOREOK,
+	EXIT_MAXITER, EXIT_REPROJ} Exitreason_ ;
+    Exitreason_ Exreason=NOEXIT;
+    
+    unsigned int Itno=0, It3dno=0, Dim=Rno+2, Oldim=Rno+2, 
+	Bestfound=0, Reprojmax, Repriter, Reprojno, 
+	Speciter=Params.i_value("Speciter");
+    float Stress=0.0, Rmss=0.0, Densfact=0.0, Speceps=Params.f_value("Speceps");
+    int Signal=0, Handflip=1, Workdone=0, Noconv=0;
+    long Runtime;   // CPU time of the run in seconds
+    String_ Outname;
+    
+    // set 3D reprojections
+    Reprojmax=Params.i_value("Maxiter")/10+1;
+    if (Reprojmax<3) Reprojmax=3;
+    
+    Repeat=false;
+    // the time stamp and time string functions use static buffers
+    if (Sim.Pool!=NULL) Sim.Pool->lock();
+    Out<<"\nRUN "<<Rcyc<<" STARTED: "<<time_stamp()<<endl;
+    if (Sim.Pool!=NULL) Sim.Pool->unlock();
+    start_runtimer(Sim);
+
+    /* Initialise the distance matrix to random values
+     * within the pre-calculated bounds, modified by the
+     * hydrophobic distances for "soft" restraints.
+     * The random numbers come from a private stream keyed on
+     * Runseed (cf. dragon_run()), the run number and the number
+     * of repeats, so that parallel runs never share a stream and
+     * each run can be reproduced wherever and whenever it is done.
+     */
+    Out<<"# Randseed="<<Runseed<<", run "<<Rcyc;
+    if (Attempt) Out<<", repeat "<<Attempt;
+    Out<<endl;
+    Restraints.init_distmat(Dista, Polymer, Runseed, Rcyc, Attempt);
+    Distcache.forget();	// Dista does not come from the cache
+    Iproj.cold_start();	// no eigenvectors from the previous run
+
+    Itno=It3dno=Repriter=Reprojno=0;
+    Oldim=Dim=Rno+2; Bestfound=0;
+    Rmss=0.0; Densfact=0.0;
+    Distsco.set_noexit();	// "prime" the scores
+    Euclsco.set_noexit();
+    Bestsco.set_noexit();
+    Exreason=NOEXIT;
+
+    /* Signal traps: most non-fatal signals are trapped
+     * and then the handler throws a Sigexcept_
+     * exception. In worker threads the signals are caught
+     * by the pool which is polled at the beginning of each cycle.
+     */
+    if (Sim.Pool==NULL)
+	Sigproc.set_signal((SIG_PF)signal_handler);	    // set up signal trap
+    #ifdef ALLOC_STATS
+	Allocno=Allocbytes=0;	// count from the first cycle on
+    #endif
+    do	// <--cycle until finished, interrupted or crashed
+    {
+	try	// look for signal exceptions
+	{
+	    if (Sim.Pool!=NULL) Sim.Pool->check_stop();
+	    
+	    // print how much we have done
+	    Workdone=int(100.0*((Dim==3)? Rno-1+It3dno: 3.0-Dim+Rno-1.0)/(Rno-1.0+Params.i_value("Maxiter")));
+	    Runtime=runtimer_results(Sim);
+	    if (Sim.Pool!=NULL) Sim.Pool->lock();
+	    Out<<"CYCLE: "<<(Itno+1)<<" ("
+		<<Workdone<<"%, "
+		<<time_string(Runtime)
+		<<")\n";
+	    if (Sim.Pool!=NULL) Sim.Pool->unlock();
+	#ifdef USE_PVM
+	    // tell the master which cycle is being done
+	    if (Pvmtask.is_slave())
+		Pvmtask.job_status(Pvmtask_::SLAVE_RUNNING, Itno+1);
+	#endif
+	    // distance "space" adjustments in hyperspace:
+	    if (Dim>3 || Repriter==Reprojmax)
+	    {
+		// in 3D, count how many reprojections were done
+		if (Dim==3) Reprojno++;
+
+		// make distance matrix from previous coords
+		if (Itno) Model.dist_mat2(Dista, Distwork);
+
+		// adjust density
+		Densfact=scale_distdens(Dista,
+		    Restraints.exp_rad(Rno, Params.f_value("Density")));
+
+		// "blend in" previous best distmat
+		if (Dim==3 && Bestfound)
+		    merge_distmat(Distbest, Dista);
+
+		// ideal distances
+		Fakebeta.update(Dista, Polymer);    // get C:beta-related distances
+		Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
+			Pieces, Steric_::ALL | Steric_::RESTR | Steric_::SPECGRAD);
+		Steric.adjust_dist(Dista, Pieces, Steric_::ALL);
+
+		// display new distance matrix
+		#ifdef USE_OPENGL_GRAPHICS
+		    if (Graph) Draw.display_dist(Dista);
+		#endif
+
+		/* perform full projection: in 3.x compatibility mode
+		 * the overall projection will automatically be used
+		 * (cf. above the Iproj.set_size() call)
+		 */
+		Dim=Iproj.full_project(Dista, Params.f_value("Evfract"), Oldim, Model);
+
+		// post-projection refinement
+		Densfact=proj_dens(Dista, Pieces, Model);
+		Noconv=0;
+		Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);	// uses the pre-projection dists
+		if (Noconv || Stress<0.0)	// on error or no convergence
+		{
+		    Model.dist_mat2(Dista, Distwork);
+		    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL);
+		}
+
+		/* See if the BOND distance scores improved compared to
+		 * the previous embedding: if yes, then employ
+		 * a bolder dim reduction strategy 
+		 */
+		Model.dist_mat2(Dista, Distwork);
+		Fakebeta.update(Dista, Polymer);    // get C:beta-related distances
+		Steric.ideal_dist(Dista, Fakebeta, Restraints, Polymer, 
+			Pieces, Steric_::ALL | Steric_::RESTR | Steric_::SCORE, &Distsco);
+		if (Distsco[Scores_::BOND].change()<0)
+		    Oldim=(Dim>4)? (2*(Dim-3))/3+3: 4;
+		else
+		    Oldim=(Dim>3)? Dim: 4;
+
+		/* 3D-specific things: overall handedness adjustment,
+		 * reset 3D reproj counter
+		 */
+		if (Dim==3)
+		{
+		    // get correct enantiomer from comparison to known homol. struct
+		    if (Homodel.known_no()>0)
 		    {
-			bool Tangled=Tangles.tangle_detect(Pieces, Model);
-			if (!Tangled && (!Bestfound || Bestsco.accept_new(Euclsco)))
-			{
-			    Best=Model; Bestsco.update(Euclsco);
-			    Distbest=Dista;
-			    Bestfound++; 
-			    Repriter=Reprojno=0;
-			    cout<<"** BEST: "<<Bestsco<<endl;
-			}
-			else    // count iterations in 3D
-			{
-			    It3dno++; 
-			    if (!Tangled && Bestfound)
-				Repriter++;   // don't shortcut reproj if tangled
-			    if (It3dno>=Params.i_value("Maxiter")) Exreason=EXIT_MAXITER;
-			    if (Reprojno==2) Exreason=EXIT_REPROJ;
-				cout<<"EUCL: "<<Euclsco<<endl;
-			}
+			if (Sim.Pool!=NULL) Sim.Pool->lock();	// shared object
+			Handflip=Homodel.hand_check(Model, Out);
+			if (Sim.Pool!=NULL) Sim.Pool->unlock();
 		    }
-		    else cout<<"EUCL: "<<Euclsco<<endl;
-	    
-		    // leave early if in 3D and score was good
-		    if (Dim==3 && Bestfound && Bestsco.is_exit())
-			Exreason=EXIT_SCOREOK;
-		    
-		    // count overall iterations
-		    Itno++;
-		}	// end of try-block
-		catch(Sigexcept_ Sigexc)	// signals land us here
+		    else	// we are on our own (check is based on secstr hands)
+			Handflip=hand_check(Pieces, Model);
+		    Repriter=0;
+		}
+
+		// get accessibility score and list
+		Distsco[Scores_::ACCESS].score(Access.score_dist(Polymer, Dista));
+		Out<<"DIST: "<<Distsco<<endl;
+		Out<<"PROJ: Dim="<<Dim<<", Df="<<Densfact
+		    <<",  STR="<<Stress<<" ";
+		if (Dim==3 && Handflip==-1)
+		    Out<<", flip";
+		Out<<endl;
+
+		// Dista was rewritten here, the next refresh must rebuild it
+		Distcache.forget();
+	    }	// if projection
+
+	    // ---- Euclidean space adjustments ----
+
+	    /* From here on Dista is only read between the refreshes from
+	     * Model, so only the entries of the points that moved since
+	     * the previous refresh are recalculated. The cache stays valid
+	     * from one cycle to the next unless there was a projection.
+	     */
+
+	    #ifdef USE_OPENGL_GRAPHICS
+		if (Graph)
 		{
-		    Signal=Sigexc.sigval();
-		    Exreason=(Signal==SIGINT)? EXIT_CTRLC: EXIT_SIGNAL;
+		    Draw.display_eucl(Dista);
+		    Draw.display_coords(Model);
 		}
-	    }
-	    while (Exreason==NOEXIT);   // end of big do-cycle
-	    Sigproc.set_signal(SIG_DFL);    // don't catch signals any more
-	
-	    cout<<"EXIT: ";
-	    switch (Exreason)
+	    #endif
+
+	    // detangling and RBA
+	    if (Pieces.clu_no()>1)
 	    {
-		case EXIT_SIGNAL: cerr<<"on signal "<<Signal<<endl; break;
-		case EXIT_CTRLC: cerr<<"user interrupt requested\n"; break;
-		case EXIT_SCOREOK: cerr<<"score convergence criterion satisfied\n"; break;
-		case EXIT_MAXITER: cerr<<"maximal number of iterations reached\n"; break;
-		case EXIT_REPROJ: cerr<<"no further improvement on 3D reprojection\n"; break;
-		default: cerr<<"reason unknown (not implemented)\n"; break;
+		Tangiter=Params.i_value("Tangiter");	// reset
+		Tangviol=Tangles.tangle_elim(Pieces, Model, TADJ, Tangiter);
+		Out<<"TNGL: "<<Tangviol<<" (cyc="<<Tangiter<<")"<<endl;
+
+		if (Tangiter)   // had to do detangling
+		{
+		    Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+			    Pieces, Steric_::BETWEEN | Steric_::RESTR);
+		    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::BETWEEN|Steric_::SPARSE);
+		}
 	    }
-	    
-	    // output
-	    stop_timer();
-	    cout<<"TIME: "<<time_string(timer_results(TS_UTIME|TS_STIME))<<endl;
-	    if (Bestfound)
+	    // accessibility
+	    Access.solvent_xyz(Polymer, Pieces.hbond_bits(), Model);
+
+	    // 3D isotropic ellipsoidal density adjustment
+	    if (Dim==3)
+		Densfact=ellips_dens(Params.f_value("Density"), Pieces, Model);
+
+	    /* If the model is composed of several clusters, then first
+	     * the clusters are adjusted ("WITHIN"), then the relative
+	     * positions of the clusters ("BETWEEN"), finally all
+	     * atoms move together ("ALL"). Sub-adjustments are for
+	     * external restraints ("NMR" and 2o str), 
+	     * then all.
+	     */
+	    Out<<"EUCL: ";
+	    if (Pieces.clu_no()>1)
 	    {
-		cout<<"END: "<<Bestsco<<", Itno:"<<Itno<<"="<<(Itno-It3dno)<<"+"<<It3dno<<endl;
-		
+
+		// WITHIN-external
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+			Pieces, Steric_::WITHIN | Steric_::REXT);
+		Steric.adjust_xyz(Dista, Model, Pieces, Steric_::WITHIN|Steric_::SPARSE);
+
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+			Pieces, Steric_::WITHIN | Steric_::REXT | Steric_::SPECGRAD);
+		Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
+		if (Noconv || Stress<0.0)
+		    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::WITHIN|Steric_::SPARSE);
+
+		// WITHIN-all
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+			Pieces, Steric_::WITHIN | Steric_::RESTR);
+		Steric.adjust_xyz(Dista, Model, Pieces, Steric_::WITHIN|Steric_::SPARSE);
+
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+			Pieces, Steric_::WITHIN | Steric_::RESTR | Steric_::SPECGRAD);
+		Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
+		if (Noconv || Stress<0.0)	// on error or no convergence
+		{
+		    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::WITHIN|Steric_::SPARSE);
+		    Out<<"IN=???";
+		}
+		else Out<<"IN="<<Stress;
+
 		#ifdef USE_OPENGL_GRAPHICS
-		    if (Graph)
-		    {
-			Draw.display_eucl(Distbest);
-			Draw.display_coords(Best);
-		    }
+		    if (Graph) Draw.display_coords(Model);
+		#endif
+
+		// cluster hydrophobic moment rotation
+		hmom_clurot(Pieces, Polymer, Model);
+
+		// BETWEEN-external
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+			Pieces, Steric_::BETWEEN | Steric_::REXT);
+		Steric.adjust_xyz(Dista, Model, Pieces, Steric_::BETWEEN|Steric_::SPARSE);
+
+		// BETWEEN-all (RBA)
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+			Pieces, Steric_::BETWEEN | Steric_::RESTR);
+		Steric.adjust_xyz(Dista, Model, Pieces, Steric_::BETWEEN|Steric_::SPARSE);
+
+		#ifdef USE_OPENGL_GRAPHICS
+		    if (Graph) Draw.display_coords(Model);
 		#endif
 
-		// get output file
-		Outname=Params.s_value("Outfnm");
-		make_outname(Outname, Rcyc, "pdb");
-		cout<<"SAVE: "<<Outname<<endl;
-		pdb_result(Outname, Best, Polymer, Pieces, Bestsco);
-		
-		// write violation file
-		Viollist_ Viollist;
-		
-		Outname=Params.s_value("Outfnm");
-		make_outname(Outname, Rcyc, "viol");
-		Fakebeta.update(Distbest, Polymer);
-		Steric.ideal_dist(Distbest, Fakebeta, Restraints, Polymer, Pieces, 
-		    Steric_::ALL | Steric_::RESTR | Steric_::SCORE, &Euclsco, &Viollist);
-		Viollist.write_file(Outname);
-		cout<<"VIOLS: "<<Outname<<endl;
-		cout<<"\nRun "<<Rcyc<<" finished: "<<time_stamp()<<endl;
 	    }
-	    else if (Dim==3)   // no result and no signals: repeat run
+
+	    /* Adjusting all atoms together. If the model
+	     * is just one piece, then this is carried out 3 times
+	     * to compensate for the lost WITHIN/BETWEEN adjustments.
+	     */
+	    for (int i=0; i<(Pieces.clu_no()>1? 1: 3); i++)
 	    {
-		// save last conformation anyway, but no violation file is made
-		Outname=Params.s_value("Outfnm");
-		Outname+="_TEMPORARY";
-		make_outname(Outname, Rcyc, "pdb");
-		pdb_result(Outname, Model, Polymer, Pieces, Euclsco);
-		cout<<"END: Temporary result, possibly tangled! Repeating run "<<Rcyc
-		    <<endl<<"SAVE: "<<Outname<<endl;
-		
-		// attempt detangling
-		if (Pieces.clu_no()>1)
+		// ALL-external
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+		    Pieces, Steric_::ALL | Steric_::REXT);
+		Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL|Steric_::SPARSE);
+
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+		    Pieces, Steric_::ALL | Steric_::REXT | Steric_::SPECGRAD);
+		Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
+		if (Noconv || Stress<0.0)
+		    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL|Steric_::SPARSE);
+
+		// secondary structure adjustment (in 3D only!)
+		if (Dim==3)
 		{
-		    Tangiter=2*Params.i_value("Tangiter");	// reset to generous value
-		    Tangviol=Tangles.tangle_elim(Pieces, Model, TADJ, Tangiter);
-		    cout<<"TNGL: "<<Tangviol<<" (cyc="<<Tangiter<<")"<<endl;
-		    Outname=Params.s_value("Outfnm");
-		    Outname+="_DETANGLED";
-		    make_outname(Outname, Rcyc, "pdb");
-		    pdb_result(Outname, Model, Polymer, Pieces, Euclsco);
-		    cout<<"SAVE: "<<Outname<<endl;
+		    Rmss=apply_secstruct(Pieces, Model);    // fit ideal secstr in 3D
+		    Out<<" 2oSTR="<<Rmss;
 		}
-		
-		if (!Params.i_value("Randseed") && !Signal)
+		// ALL-all
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+		    Pieces, Steric_::ALL | Steric_::RESTR);
+		Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL|Steric_::SPARSE);
+
+		Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+		    Pieces, Steric_::ALL | Steric_::RESTR | Steric_::SPECGRAD);
+		Stress=Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
+		if (Noconv || Stress<0.0)	// on error or no convergence
 		{
-		    // start from different random matrix
-		    Rcyc--;
+		    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL|Steric_::SPARSE);
+		    Out<<" ALL=???";
 		}
-		else cout<<endl;
+		else Out<<" ALL="<<Stress;
 	    }
-	    cerr<<flush; cout<<flush;
-	    
-	}	    // for Rcyc (all simulations)
-	
-	// close windows if graphics was on
+	    Out<<endl;
+
+	    #ifdef USE_OPENGL_GRAPHICS
+		if (Graph)
+		{
+		    Draw.display_eucl(Dista);
+		    Draw.display_coords(Model);
+		}
+	    #endif
+
+	    // adjust CA:CA bonds and CA(i):CA(i+2) only
+	    Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+		Pieces, Steric_::ALL|Steric_::BOND);
+	    Steric.adjust_xyz(Dista, Model, Pieces, Steric_::ALL|Steric_::SPARSE);
+
+	    // same with Specgrad as well: usually converges after Willie's adjustment
+	    Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+		Pieces, Steric_::ALL|Steric_::BOND|Steric_::SPECGRAD);
+	    Steric.adjust_xyz(Model, Speciter, Speceps, Noconv);
+
+	    // generate violation score (different from Stress)
+	    Steric.refresh(Model, Distcache, Dista, Fakebeta, Restraints, Polymer, 
+		    Pieces, Steric_::ALL | Steric_::RESTR | Steric_::SCORE, &Euclsco);
+	    Euclsco[Scores_::ACCESS].score(Access.score_xyz(Polymer, Model));
+
+	    // save best if in 3D and score was acceptable and wasn't tangled
+	    if (Dim==3)
+	    {
+		bool Tangled=Tangles.tangle_detect(Pieces, Model);
+		if (!Tangled && (!Bestfound || Bestsco.accept_new(Euclsco)))
+		{
+		    Best=Model; Bestsco.update(Euclsco);
+		    Distbest=Dista;
+		    Bestfound++; 
+		    Repriter=Reprojno=0;
+		    Out<<"** BEST: "<<Bestsco<<endl;
+		}
+		else    // count iterations in 3D
+		{
+		    It3dno++; 
+		    if (!Tangled && Bestfound)
+			Repriter++;   // don't shortcut reproj if tangled
+		    if (It3dno>=Params.i_value("Maxiter")) Exreason=EXIT_MAXITER;
+		    if (Reprojno==2) Exreason=EXIT_REPROJ;
+			Out<<"EUCL: "<<Euclsco<<endl;
+		}
+	    }
+	    else Out<<"EUCL: "<<Euclsco<<endl;
+
+	    // leave early if in 3D and score was good
+	    if (Dim==3 && Bestfound && Bestsco.is_exit())
+		Exreason=EXIT_SCOREOK;
+
+	    #ifdef ALLOC_STATS
+		Out<<"ALLOC: "<<Allocno<<" ("<<Allocbytes<<" bytes)"<<endl;
+		Allocno=Allocbytes=0;
+	    #endif
+
+	    // count overall iterations
+	    Itno++;
+	}	// end of try-block
+	catch(Sigexcept_ Sigexc)	// signals land us here
+	{
+	    Signal=Sigexc.sigval();
+	    Exreason=(Signal==SIGINT)? EXIT_CTRLC: EXIT_SIGNAL;
+	}
+    }
+    while (Exreason==NOEXIT);   // end of big do-cycle
+    if (Sim.Pool==NULL)
+	Sigproc.set_signal(SIG_DFL);    // don't catch signals any more
+
+    Out<<"EXIT: ";
+    switch (Exreason)
+    {
+	case EXIT_SIGNAL: Err<<"on signal "<<Signal<<endl; break;
+	case EXIT_CTRLC: Err<<"user interrupt requested\n"; break;
+	case EXIT_SCOREOK: Err<<"score convergence criterion satisfied\n"; break;
+	case EXIT_MAXITER: Err<<"maximal number of iterations reached\n"; break;
+	case EXIT_REPROJ: Err<<"no further improvement on 3D reprojection\n"; break;
+	default: Err<<"reason unknown (not implemented)\n"; break;
+    }
+
+    // output
+    Runtime=runtimer_results(Sim);
+    if (Sim.Pool!=NULL) Sim.Pool->lock();
+    Out<<"TIME: "<<time_string(Runtime)<<endl;
+    if (Sim.Pool!=NULL) Sim.Pool->unlock();
+    if (Bestfound)
+    {
+	Out<<"END: "<<Bestsco<<", Itno:"<<Itno<<"="<<(Itno-It3dno)<<"+"<<It3dno<<endl;
+
 	#ifdef USE_OPENGL_GRAPHICS
-	    if (Graph) Draw.close_window();
+	    if (Graph)
+	    {
+		Draw.display_eucl(Distbest);
+		Draw.display_coords(Best);
+	    }
 	#endif
 
-    	if (Sigproc.is_child())
+	// get output file
+	Outname=Params.s_value("Outfnm");
+	make_outname(Outname, Rcyc, "pdb");
+	Out<<"SAVE: "<<Outname<<endl;
+	pdb_result(Outname, Best, Polymer, Pieces, Bestsco);
+
+	// write violation file
+	Viollist_ Viollist;
+
+	Outname=Params.s_value("Outfnm");
+	make_outname(Outname, Rcyc, "viol");
+	Fakebeta.update(Distbest, Polymer);
+	Steric.ideal_dist(Distbest, Fakebeta, Restraints, Polymer, Pieces, 
+	    Steric_::ALL | Steric_::RESTR | Steric_::SCORE, &Euclsco, &Viollist);
+	Viollist.write_file(Outname, Out);
+	Out<<"VIOLS: "<<Outname<<endl;
+	if (Sim.Pool!=NULL) Sim.Pool->lock();
+	Out<<"\nRun "<<Rcyc<<" finished: "<<time_stamp()<<endl;
+	if (Sim.Pool!=NULL) Sim.Pool->unlock();
+    }
+    else if (Dim==3)   // no result and no signals: repeat run
+    {
+	// save last conformation anyway, but no violation file is made
+	Outname=Params.s_value("Outfnm");
+	Outname+="_TEMPORARY";
+	make_outname(Outname, Rcyc, "pdb");
+	pdb_result(Outname, Model, Polymer, Pieces, Euclsco);
+	Out<<"END: Temporary result, possibly tangled! Repeating run "<<Rcyc
+	    <<endl<<"SAVE: "<<Outname<<endl;
+
+	// attempt detangling
+	if (Pieces.clu_no()>1)
 	{
-	    close(Logfd);
-	    exit(Signal);
+	    Tangiter=2*Params.i_value("Tangiter");	// reset to generous value
+	    Tangviol=Tangles.tangle_elim(Pieces, Model, TADJ, Tangiter);
+	    Out<<"TNGL: "<<Tangviol<<" (cyc="<<Tangiter<<")"<<endl;
+	    Outname=Params.s_value("Outfnm");
+	    Outname+="_DETANGLED";
+	    make_outname(Outname, Rcyc, "pdb");
+	    pdb_result(Outname, Model, Polymer, Pieces, Euclsco);
+	    Out<<"SAVE: "<<Outname<<endl;
 	}
-    }	    // else: child or single simulation process
 
-    // reset the floating-point output for cout and cerr
-    cout.flags(Coutf); cerr.flags(Cerrf);
-    cout.precision(Oldoutprec); cerr.precision(Olderrprec);
+	/* Start from a different random matrix. This is done with
+	 * a fixed "Randseed" as well: the matrix of each repeat depends
+	 * on the seed, the run number and Attempt only, so the repeats
+	 * of a run are reproduced together with the run itself.
+	 */
+	if (!Signal) Repeat=true;
+	else Out<<endl;
+    }
+    Err<<flush; Out<<flush;
     
     return(Signal);
 }
-// END of dragon_run()
+// END of sim_run()
 
 // ---- Auxiliaries ----
 
+/* start_runtimer(), runtimer_results(): time the simulation run in Sim.
+ * runtimer_results() returns the CPU time (in seconds) used since the
+ * last start_runtimer() call. The tstamp timer is process-wide,
+ * therefore in worker threads the CPU time of the calling thread
+ * is measured instead and the start is kept in the context.
+ */
+static void start_runtimer(Simctx_& Sim)
+{
+    #ifdef USE_THREADS
+    if (Sim.Pool!=NULL)
+    {
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &(Sim.Cpustart));
+	return;
+    }
+    #endif
+    start_timer();
+}
+
+static long runtimer_results(Simctx_& Sim)
+{
+    #ifdef USE_THREADS
+    if (Sim.Pool!=NULL)
+    {
+	struct timespec Now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Now);
+	return(Now.tv_sec-Sim.Cpustart.tv_sec-(Now.tv_nsec<Sim.Cpustart.tv_nsec));
+    }
+    #endif
+    stop_timer();
+    return(timer_results(TS_UTIME|TS_STIME));
+}
+// END of start_runtimer(), runtimer_results()
+
 /* merge_distmat: mixes the distances in Bestdist into Dist so
  * that local distances (diagonals close to the main diag) will be
  * more or less the same, whereas global distances will come from
@@ -1188,21 +1506,16 @@ unsigned int dragon_run(unsigned int Runno)
 static void merge_distmat(const Trimat_& Bestdist, Trimat_& Dist)
 {
     static const unsigned int GSTEP=10;
-    static double Mix[GSTEP], Mixm1[GSTEP];
-    static char Init=1;
+    double Mix[GSTEP], Mixm1[GSTEP];
     
     register double Nij, Dij, Ndij;
     register unsigned int d, i, j, Ptno=Bestdist.rno();
     
-    // fill up the blend coefficient arrays on first call
-    if (Init)
+    // fill up the blend coefficient arrays (cheap, no need to cache)
+    for (d=0; d<GSTEP; d++)
     {
-	for (d=0; d<GSTEP; d++)
-	{
-	    Mix[d]=exp(-(d*d/double(GSTEP)));
-	    Mixm1[d]=1.0-Mix[d];
-	}
-	Init=0;
+	Mix[d]=exp(-(d*d/double(GSTEP)));
+	Mixm1[d]=1.0-Mix[d];
     }
     
     // adjust from second off-diagonal
@@ -50,9 +50,11 @@ float Fakebeta_::get_dist(float D1, float D2, float D3, float L)
 /* update(): updates the CA:CB and CB:CB distance matrices using the
  * CA:CA matrix Dista and the prescribed CA(i):CB(i) distances from
  * Polymer_ . The matrices within may be resized if necessary.
+ * If Lazy is true, then only the Lambdas are calculated and the
+ * matrix entries are made on demand later (see lazy_ab(), lazy_bb()).
  * Return value: the new size.
  */
-unsigned int Fakebeta_::update(const Trimat_& Dista, const Polymer_& Polymer)
+unsigned int Fakebeta_::update(const Trimat_& Dista, const Polymer_& Polymer, bool Lazy)
 {
     if (Dista.rno()!=Polymer.len()+2)
     {
@@ -70,15 +72,35 @@ unsigned int Fakebeta_::update(const Trimat_& Dista, const Polymer_& Polymer)
      */
     Rno-=2;
     
-    register unsigned int i, j;
+    register unsigned int i, j, k;
     register float Daf, Dbf, Dcf, Defgh, Dij;
     
     // calc the Lambda[] and Dhj[] values
     make_lambda(Dista, Polymer);
     
+    Lazymode=Lazy;
+    if (Lazymode)
+    {
+	/* invalidate all entries by starting a new epoch. The stamps are
+	 * zeroed if the size has changed or the epoch counter wrapped around
+	 */
+	Dptr=&Dista; Pptr=&Polymer;
+	unsigned int Oldlen=Abstamp.len((Rno+2)*(Rno+2));
+	Bbstamp.len((Rno+2)*(Rno+3)/2);
+	if (++Epoch==0 || Oldlen!=Abstamp.len())
+	{
+	    Abstamp.set_values(0); Bbstamp.set_values(0);
+	    Epoch=1;
+	}
+	return(Rno);
+    }
+    
     /* alpha[i]:beta[j] distances: the underlying logic is the same as
      * in DRAGON 3.x but the cycles are rearranged for efficiency.
      * Note the special treatment of the N- and C-termini.
+     * The beta[i]:beta[j] distances need the alpha:beta rows i-1..i+1,
+     * so the (i-1)-th beta:beta row is done as soon as the i-th alpha:beta
+     * row is ready (while the rows are still in the cache).
      */
     
     // N-terminus (i==0)
@@ -88,36 +110,40 @@ unsigned int Fakebeta_::update(const Trimat_& Dista, const Polymer_& Polymer)
 	Distab[0][j]=get_dist((float)Dista[j][0], Defgh, Dhj[j], Lambda[j]);
     }
     
-    // middle of the chain
-    for (i=1; i<=Rno; i++)
+    for (i=1; i<=Rno+1; i++)
     {
-	Distab[i][i]=Polymer.abdist(i-1);	    // just copy prescribed value
-	for (j=1; j<=Rno; j++)
+	if (i<=Rno)	// middle of the chain
 	{
-	    if (i==j) continue;
-	    
-	    Daf=float((i>=j-1)? Dista[i][j-1]: Dista[j-1][i]);
-	    Dcf=float((i>=j+1)? Dista[i][j+1]: Dista[j+1][i]);
-	    Defgh=0.5F*(Daf+Dcf)-0.25F*(float)Dista[j+1][j-1];
-	    Dbf=float((i>=j)? Dista[i][j]: Dista[j][i]);
-	    Distab[i][j]=get_dist(Dbf, Defgh, Dhj[j], Lambda[j]);
+	    Distab[i][i]=Polymer.abdist(i-1);	    // just copy prescribed value
+	    for (j=1; j<=Rno; j++)
+	    {
+		if (i==j) continue;
+		
+		Daf=float((i>=j-1)? Dista[i][j-1]: Dista[j-1][i]);
+		Dcf=float((i>=j+1)? Dista[i][j+1]: Dista[j+1][i]);
+		Defgh=0.5F*(Daf+Dcf)-0.25F*(float)Dista[j+1][j-1];
+		Dbf=float((i>=j)? Dista[i][j]: Dista[j][i]);
+		Distab[i][j]=get_dist(Dbf, Defgh, Dhj[j], Lambda[j]);
+	    }
 	}
-    }
-    
-    // C-terminus (i==Rno+1 automatically here)
-    for (j=1; j<=Rno; j++)
-    {
-	Defgh=0.5F*((float)Dista[i][j-1]+(float)Dista[i][j+1])-0.25F*(float)Dista[j+1][j-1];
-	Distab[i][j]=get_dist((float)Dista[i][j], Defgh, Dhj[j], Lambda[j]);
-    }
-    
-    // beta[i]:beta[j] distances
-    for (i=2; i<=Rno; i++)
-	for (j=1; j<i; j++)
+	else	// C-terminus (i==Rno+1)
+	{
+	    for (j=1; j<=Rno; j++)
+	    {
+		Defgh=0.5F*((float)Dista[i][j-1]+(float)Dista[i][j+1])-0.25F*(float)Dista[j+1][j-1];
+		Distab[i][j]=get_dist((float)Dista[i][j], Defgh, Dhj[j], Lambda[j]);
+	    }
+	}
+	
+	// beta[i-1]:beta[j] distances
+	if (i<3) continue;
+	k=i-1;
+	for (j=1; j<k; j++)
 	{
-	    Dij=0.5F*((float)Distab[i-1][j]+(float)Distab[i+1][j])-0.25F*(float)Dista[i+1][i-1];
-	    Distb[i][j]=get_dist((float)Distab[i][j], Dij, Dhj[i], Lambda[i]);
+	    Dij=0.5F*((float)Distab[k-1][j]+(float)Distab[k+1][j])-0.25F*(float)Dista[k+1][k-1];
+	    Distb[k][j]=get_dist((float)Distab[k][j], Dij, Dhj[k], Lambda[k]);
 	}
+    }
     return(Rno);
 }
 // END of update()
@@ -153,6 +179,52 @@ void Fakebeta_::beta_xyz(const Points_& Xyz, const Polymer_& P, Points_& Beta)
 
 // ---- Auxiliaries ----
 
+/* lazy_ab(): calculates the CA(i):CB(j) squared distance in lazy mode
+ * the same way as update() does, stores it in Distab and marks it
+ * as valid for the current epoch. Entries which update() does not
+ * calculate either are returned as they are. Private
+ */
+double Fakebeta_::lazy_ab(unsigned int i, unsigned int j) const
+{
+    register unsigned int Size=Lambda.len();
+    
+    if (!j || j>=Size-1) return(Distab(i, j));	// no beta on the termini
+    
+    if (i==j)
+	Distab[i][i]=Pptr->abdist(i-1);	    // just copy prescribed value
+    else
+    {
+	const Trimat_& Dista=*Dptr;
+	register float Daf, Dbf, Dcf, Defgh;
+	
+	Daf=float((i>=j-1)? Dista[i][j-1]: Dista[j-1][i]);
+	Dcf=float((i>=j+1)? Dista[i][j+1]: Dista[j+1][i]);
+	Defgh=0.5F*(Daf+Dcf)-0.25F*(float)Dista[j+1][j-1];
+	Dbf=float((i>=j)? Dista[i][j]: Dista[j][i]);
+	Distab[i][j]=get_dist(Dbf, Defgh, Dhj[j], Lambda[j]);
+    }
+    Abstamp[i*Size+j]=Epoch;
+    return(Distab[i][j]);
+}
+// END of lazy_ab()
+
+/* lazy_bb(): calculates the CB(i):CB(j) squared distance (i>=j)
+ * in lazy mode like update() does, with the CA:CB distances
+ * obtained through ab(). Private
+ */
+double Fakebeta_::lazy_bb(unsigned int i, unsigned int j) const
+{
+    if (i<2 || i>=Lambda.len()-1 || !j || j>=i)
+	return(Distb[i][j]);	// not calculated by update() either
+    
+    register float Dij;
+    Dij=0.5F*((float)ab(i-1, j)+(float)ab(i+1, j))-0.25F*(float)(*Dptr)[i+1][i-1];
+    Distb[i][j]=get_dist((float)ab(i, j), Dij, Dhj[i], Lambda[i]);
+    Bbstamp[i*(i+1)/2+j]=Epoch;
+    return(Distb[i][j]);
+}
+// END of lazy_bb()
+
 /* make_lambda: given the C-alpha distances between A,B,C, and the
  * fake C-alpha/C-beta B-J distances in Seq[].Abdist, the H-J
  * distances are calculated for every C-beta [1..Rno], returned
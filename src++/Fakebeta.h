@@ -63,36 +63,64 @@
  * The quantity Lambda is defined as BJ/HJ,  0...1, and B
  * divides the JH segment as BJ:BH=Lambda:(1-Lambda).
  * Lambdas can be const accessed (for the benefit of the steric routines).
+ * In "lazy" mode the matrix entries are calculated only when they are
+ * first asked for after an update and are remembered until the next one.
  */
 class Fakebeta_
 {
     // data
     private:
     
-    Sqmat_ Distab;  // [i][j]==dist^2(CA(i),CB(j))
-    Trimat_ Distb;  // CB:CB distances
+    mutable Sqmat_ Distab;  // [i][j]==dist^2(CA(i),CB(j))
+    mutable Trimat_ Distb;  // CB:CB distances
     Array_<float> Lambda, Dhj; // auxiliary vectors (see comments above)
     
+    // lazy mode
+    const Trimat_ *Dptr;    // the CA:CA distances of the last update
+    const Polymer_ *Pptr;   // and the polymer
+    mutable Array_<unsigned int> Abstamp, Bbstamp;	// Epoch if Distab/Distb entry is valid
+    unsigned int Epoch;	// no. of lazy updates
+    bool Lazymode;	    // true if in lazy mode
+    
     // methods
     public:
     
 	// constructors
     /* Init to hold Rno monomers plus the two terminals. */
     Fakebeta_(unsigned int Rno=1): 
-	Distab(Rno+2), Distb(Rno+2), Lambda(Rno+2), Dhj(Rno+2) {}
+	Distab(Rno+2), Distb(Rno+2), Lambda(Rno+2), Dhj(Rno+2), 
+	Dptr(NULL), Pptr(NULL), Epoch(0), Lazymode(false) {}
     
 	// access
-    double ab(unsigned int i, unsigned int j) const { return(Distab(i, j)); }
-    double bb(unsigned int i, unsigned int j) const { return(Distb(i, j)); }
+    /* ab(i, j) is the squared CA(i):CB(j), bb(i, j) the squared CB(i):CB(j)
+     * distance. In lazy mode these are calculated on the first access.
+     */
+    double ab(unsigned int i, unsigned int j) const
+    {
+	return((Lazymode && Abstamp[i*Lambda.len()+j]!=Epoch)? lazy_ab(i, j): Distab(i, j));
+    }
+    double bb(unsigned int i, unsigned int j) const
+    {
+	if (!Lazymode) return(Distb(i, j));
+	if (i<j) { register unsigned int t=i; i=j; j=t; }
+	return((Bbstamp[i*(i+1)/2+j]!=Epoch)? lazy_bb(i, j): Distb[i][j]);
+    }
     const float& lambda(unsigned int i) const { return(Lambda[i]); }
     
 	// distance update
     /* update(): updates the CA:CB and CB:CB distance matrices using the
      * CA:CA matrix Dista and the prescribed CA(i):CB(i) distances from
      * Polymer_ . The matrices within may be resized if necessary.
+     * If Lazy is true (default false), then only the Lambdas are
+     * calculated here and the matrix entries later on demand
+     * (see ab() and bb()): this is much faster if only some of the
+     * entries are needed, e.g. for the steric checks. In this case Dista
+     * and Polymer must not be changed until the next update.
+     * The results are the same in both modes. Use the default "bulk" mode
+     * when most of the entries will be looked at.
      * Return value: the new size.
      */
-    unsigned int update(const Trimat_& Dista, const Polymer_& Polymer);
+    unsigned int update(const Trimat_& Dista, const Polymer_& Polymer, bool Lazy=false);
     
     /* beta_xyz(): generates the fake C-beta coordinates from the C-alpha coordinates
      * stored in Xyz and puts the result into Beta.
@@ -104,6 +132,8 @@ class Fakebeta_
     
     static float get_dist(float D1, float D2, float D3, float L);
     void make_lambda(const Trimat_& Dista, const Polymer_& Polymer);
+    double lazy_ab(unsigned int i, unsigned int j) const;
+    double lazy_bb(unsigned int i, unsigned int j) const;
 };
 // END OF CLASS Fakebeta_
 
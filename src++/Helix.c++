@@ -15,6 +15,7 @@
 
 #include "Vector.h"
 #include "Sqmat.h"
+#include "Vec3.h"
 #include "Hirot.h"
 
 // ---- MODULE HEADER ----
@@ -376,11 +377,16 @@ double Helix_::ideal_struct(Points_& Model) const
     if (Rms<0.0) return(Rms);	// something disastrous happened in hi_rot()
     
     /* now replace the active segment in Model by the rotated Id
-     * using the Strict weight
+     * using the Strict weight (in place, with 3D temporaries)
      */
     float Strict1=1.0-Strict;
+    Mat3_ Srot(Hr.rot_matrix()); Srot*=Strict;
+    Vec3_ Mi;
     for (register unsigned int i=0; i<len(); i++)
-	Model[i]=Strict1*Model[i]+Strict*Hr.rot_matrix()*Id[i];
+    {
+	Mi.get(Model[i]);
+	(Strict1*Mi+Srot*Vec3_(Id[i])).put(Model[i]);
+    }
     Model+=Mctr;    // transpose back to original centroid
     
     Model.mask(Oldmask);	// reset original mask
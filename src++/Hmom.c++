@@ -47,9 +47,9 @@ static int rot_ndim(const Vector_& P, const Vector_& Q, Sqmat_& R);
 void hmom_clurot(const Pieces_& Pieces, const Polymer_& Polymer, 
 	Points_& Xyz)
 {
-    static Points_ Beta;   // fake beta positions
-    static Vector_ Ctr, Ab, Hmom;
-    static Sqmat_ Rot;
+    Points_ Beta;   // fake beta positions
+    Vector_ Ctr, Hmom;
+    Sqmat_ Rot;
     
     unsigned int Ptno=Xyz.len(), Cluno=Pieces.clu_no();
     if (Cluno<=1) return;
@@ -67,8 +67,7 @@ void hmom_clurot(const Pieces_& Pieces, const Polymer_& Polymer,
     Beta.len_dim(Ptno, Dim);
     Fakebeta_::beta_xyz(Xyz, Polymer, Beta);
     
-    // store moment vectors in Beta
-    Ab.dim(Dim);
+    // store moment vectors in Beta (in place)
     register unsigned int i;
     
     for (i=0; i<Ptno; i++)
@@ -79,20 +78,20 @@ void hmom_clurot(const Pieces_& Pieces, const Polymer_& Polymer,
 	    continue;
 	}
 	
-	Ab=Beta[i]; Ab-=Xyz[i];
-	Ab.vec_norm();
-	Ab*=Polymer.phob(i-1);	// shift because of N/C termini
-	Beta[i]=Ab;
+	Beta[i]-=Xyz[i];
+	Beta[i].vec_norm();
+	Beta[i]*=Polymer.phob(i-1);	// shift because of N/C termini
     }
     
     // adjust all clusters one by one
     register unsigned int ci;
+    Ptview_ Xclu, Bclu;	    // the current cluster in Xyz and Beta
     
     Ctr.dim(Dim); 
     Rot.set_size(Dim); Hmom.dim(Dim); 
     for (ci=0; ci<Cluno; ci++)
     {
-	if (Pieces.clus(ci).on_no()<=1)		// 1-size cluster: do nothing
+	if (Pieces.clu_len(ci)<=1)		// 1-size cluster: do nothing
 	    continue;
 	
 	// check cluster type and skip coils: 4-Apr-1997.
@@ -100,20 +99,20 @@ void hmom_clurot(const Pieces_& Pieces, const Polymer_& Polymer,
 	if (Clutyp==Pieces_::COIL)
 	    continue;
 	
-	Xyz.mask(Pieces.clus(ci));
-	Beta.mask(Pieces.clus(ci));
+	Xclu=Ptview_(Xyz, Pieces.clu_idx(ci), Pieces.clu_len(ci));
+	Bclu=Ptview_(Beta, Pieces.clu_idx(ci), Pieces.clu_len(ci));
 
 	// sum the moment vectors in Beta for current cluster
 	Hmom.set_values();  // zero
-	for (i=0; i<Beta.active_len(); i++)
-	    Hmom+=Beta[i];
+	for (i=0; i<Bclu.active_len(); i++)
+	    Hmom+=Bclu[i];
 
-	Ctr=Xyz.centroid(); Ctr*=-1.0;	// point towards overall centroid
+	Ctr=Xclu.centroid(); Ctr*=-1.0;	// point towards overall centroid
 	if (!rot_ndim(Hmom, Ctr, Rot))	// get DAMPED rotation matrix
 	    continue;    // skip rest on error
-	Xyz+=Ctr;   // center cluster: observe sign change!
-	Xyz*=Rot;   // rotate so that Hmom points to overall centroid 
-	Xyz-=Ctr;   // move back to original place
+	Xclu+=Ctr;   // center cluster: observe sign change!
+	Xclu*=Rot;   // rotate so that Hmom points to overall centroid 
+	Xclu-=Ctr;   // move back to original place
     }
     Xyz.mask(Oldmask);
 }
@@ -133,8 +132,8 @@ void hmom_clurot(const Pieces_& Pieces, const Polymer_& Polymer,
  */
 static int rot_ndim(const Vector_& P, const Vector_& Q, Sqmat_& R)
 {
-    static Sqmat_ B, U;
-    static Svd_ Svd;
+    Sqmat_ B, U;
+    Svd_ Svd;
     
     unsigned int N=P.dim();
     B.set_size(N); B.diag_matrix();   // NxN unit matrix
@@ -229,9 +229,9 @@ void Homodel_::get_ca(const Chain_ *Chain, Points_& Cas)
  * From V4.11.2 on, also prepares for RMS checks between model
  * structure and the best known structure (to get the right enantiomer).
  */
-List1_<Restr_> Homodel_::make_restrs(float Maxdist, int Minsepar)
+Vlist_<Restr_> Homodel_::make_restrs(float Maxdist, int Minsepar)
 {
-    List1_<Restr_> Rlist;
+    Vlist_<Restr_> Rlist;
     if (!Knownno)
     {
 	cerr<<"\n? Homodel_::make_restrs(): No known structure\n";
@@ -397,8 +397,9 @@ List1_<Restr_> Homodel_::make_restrs(float Maxdist, int Minsepar)
  * Returns 1 if Model is more similar to the scaffold than its mirror image, 
  * -1 if a flip was needed (which is done inside) and 0 on error
  * or if Model was not 3D. Cf. the hand_check() fn in "Sterchem".
+ * The RMS values are reported to Out (cout by default).
  */
-int Homodel_::hand_check(Points_& Model)
+int Homodel_::hand_check(Points_& Model, ostream& Out)
 {
     if (Model.dim()!=3 || Bestknown==NULL) 
 	return(0);  // not in 3D or not in homology mode, do nothing
@@ -453,7 +454,7 @@ int Homodel_::hand_check(Points_& Model)
     Cas+=Casctr; Cas.mask(true);    // reset Calphas of known
     
     // choose the enantiomer with the lower RMS value
-    cout<<"HAND: (homol) RMS="<<Rms<<", FLIP="<<Rmsflip<<endl;
+    Out<<"HAND: (homol) RMS="<<Rms<<", FLIP="<<Rmsflip<<endl;
     if (Rms<=Rmsflip)
     {
 	// keep the original
@@ -463,7 +464,7 @@ int Homodel_::hand_check(Points_& Model)
     {
 	// use the flipped enantiomer
 	Flipmodel+=Modctr; Flipmodel.mask(true);
-	Model=Flipmodel; Model.mask(Oldmodelmask);
+	Model.swap(Flipmodel); Model.mask(Oldmodelmask);
 	return(-1);
     }
 }
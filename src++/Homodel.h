@@ -23,7 +23,7 @@
 // ---- UTILITY HEADERS ----
 
 #include "Points.h"
-#include "List1.h"
+#include "Vlist.h"
 #include "Hirot.h"
 #include "Vector.h"
 #include "Bits.h"
@@ -121,15 +121,16 @@ class Homodel_
      * From V4.11.2 on, also prepares for RMS checks between model
      * structure and the best known structure (to get the right enantiomer).
      */
-    List1_<Restr_> make_restrs(float Maxdist, int Minsepar=2);
+    Vlist_<Restr_> make_restrs(float Maxdist, int Minsepar=2);
     
     /* hand_check(): compares the model C-alpha coordinates in Model to
      * the C-alpha coordinates of the scaffold structure most homologous to the model.
      * Returns 1 if Model is more similar to the scaffold than its mirror image, 
      * -1 if a flip was needed (which is done inside) and 0 on error
      * or if Model was not 3D. Cf. the hand_check() fn in "Sterchem".
+     * The RMS values are reported to Out (cout by default).
      */
-    int hand_check(Points_& Model);
+    int hand_check(Points_& Model, ostream& Out=cout);
     
     // hidden methods
     private:
@@ -19,7 +19,6 @@
 
 #include "Ql.h"
 #include "Rsmdiag.h"
-#include "Hirot.h"
 
 // ---- TYPEDEFS AND PROTOTYPES ----
 
@@ -44,7 +43,7 @@ extern "C" int descend_rs(const void *P1, const void *P2);
 Iproj_::Iproj_(unsigned int Resno):
 	Rno(Resno), Cluno(0), 
 	Locals(Resno), Locdist(Resno), Clusters(NULL), 
-	Ptclu(NULL), Ptoffs(NULL), Cluoffs(NULL), 
+	Ptclu(NULL), Ptoffs(NULL), Cluoffs(NULL), Cluidx(NULL), Clubeg(NULL), 
 	Maxlocdim(0), Sksize(0), Diagshf(0.0)
 {
     if (!Rno)
@@ -243,7 +242,9 @@ unsigned int Iproj_::make_clusters(const Array_<Bits_>& Clus)
  * in Abprods[][] (cf. ctr_prod()) corresponding to the i:th point.
  * Cluoffs[ci] returns the column index in Abprods for the ci:th
  * cluster. These index arrays are meant to speed up the ctr_prod()
- * method. Private
+ * method. Also lists the points of the ci:th cluster in
+ * Cluidx[Clubeg[ci]..Clubeg[ci+1]-1] for the cluster views
+ * (cf. clu_view()). Private
  */
 void Iproj_::make_offsets()
 {
@@ -257,7 +258,14 @@ void Iproj_::make_offsets()
     if (Cluoffs!=NULL) delete [] Cluoffs;
     Cluoffs=new unsigned int [Cluno];
 
-    register unsigned int i, ci, k;
+    register unsigned int i, ci, k, m;
+    
+    for (ci=k=0; ci<Cluno; ci++) k+=Clusters[ci].on_no();
+    if (Cluidx!=NULL) delete [] Cluidx;
+    Cluidx=new unsigned int [k];
+    
+    if (Clubeg!=NULL) delete [] Clubeg;
+    Clubeg=new unsigned int [Cluno+1];
     
     // fill up Ptclu
     for (i=0; i<Rno; i++)
@@ -267,14 +275,18 @@ void Iproj_::make_offsets()
 	Ptclu[i]=ci;
     }
     
-    // init the Abprods offset arrays
-    for (ci=k=0; ci<Cluno; ci++)
+    // init the Abprods offset arrays and the member lists
+    for (ci=k=m=0; ci<Cluno; ci++)
     {
 	Cluoffs[ci]=k++;
+	Clubeg[ci]=m;
 	for (i=0; i<Rno; i++)
 	    if (Clusters[ci].get_bit(i))
-		Ptoffs[i]=k++;
+	    {
+		Ptoffs[i]=k++; Cluidx[m++]=i;
+	    }
     }
+    Clubeg[Cluno]=m;
 }
 // END of make_offsets()
 
@@ -305,7 +317,7 @@ unsigned int Iproj_::full_project(Trimat_& Dist,
     if (Cluno==1)
     {
 	Xyz.mask(true);	    // switch everybody ON
-	return(metric_project(Metric, Evfract, 3, Oldim, Xyz));
+	return(metric_project(Metric, Evfract, 3, Oldim, Xyz, NULL, true));
     }
     
     // "crushed" local embedding of clusters
@@ -355,10 +367,11 @@ void Iproj_::cluster_project(Trimat_& Dist, unsigned int Oldim)
 	
 	D=metric_project(Mloc, 1.0, 1, Embed, Locals, &(Imoms[ci]));
 	
-	make_locdist();	// create local Euclidean distances
+	make_locdist(ci);	// create local Euclidean distances
 	Sksize+=D;    // sum dimensions for skeleton size
 	if (D>Maxlocdim) Maxlocdim=D;	// get max. local dimension
     }
+    Locals.mask(true);	// clusters are accessed via views from now on
     apply_locdist(Dist);
     Sksize+=Cluno;  // the final skeleton size
 }
@@ -382,7 +395,7 @@ unsigned int Iproj_::skel_project(Trimat_& Dm,
 {
     if (Cluno<=1) return(Oldim);    // don't do anything in 1-cluster case
     
-    static Trimat_ Metric;
+    Trimat_& Metric=Fullmet;
     dist_metric(Dm, Metric);
     
     // fill up the skeleton metric matrix
@@ -396,7 +409,7 @@ unsigned int Iproj_::skel_project(Trimat_& Dm,
 
     // disallow flat skeletons
     Dim=metric_project(Skmet, Evfract, 
-	(Maxlocdim>=3)? Maxlocdim: 3, Oldim, Skxyz);
+	(Maxlocdim>=3)? Maxlocdim: 3, Oldim, Skxyz, NULL, true);
 
     // put the local flesh onto the skeleton
     flesh_skel(Dm, Xyz);
@@ -417,15 +430,13 @@ void Iproj_::flesh_skel(const Trimat_& Dist, Points_& Xyz)
     register unsigned int ci, wi, a0, Da, p, i, Dim=Skxyz.dim(), Fno;
     Matrix_ R;
     Vector_ Iv(Dim);
+    Ptview_ Xv, Lv, Fv;	// cluster views of Xyz, Locals and Xyzflip
         
-    static Hirot_ Hr;
-    static Array_<Points_> Distorts, Ideals;	// for each clu
-    static Points_ W;	// weights
     Rs_ *Rss=new Rs_ [Cluno];	// RMS values for the cluster fits
     
     Xyz.len_dim(Rno, Dim);	// activate all Xyz
-    Distorts.len(Cluno); Ideals.len(Cluno);
-    W.len(Cluno); W.mask(true);
+    Distorts.len(Cluno); Ideals.len(Cluno);	// workspace members
+    Framewgt.len(Cluno); Framewgt.mask(true);
     
     const double HALFVAL=0.1;
     double Lendiff;
@@ -435,22 +446,22 @@ void Iproj_::flesh_skel(const Trimat_& Dist, Points_& Xyz)
     for (ci=wi=a0=0; ci<Cluno; ci++)
     {
 	// check the cluster size: don't attempt rotation if it is 1
-	Xyz.mask(Clusters[ci]);
-	if (Xyz.active_len()==1)    // 1-point cluster
+	Xv=clu_view(Xyz, ci);
+	if (Xv.active_len()==1)    // 1-point cluster
 	{
-	    Xyz[0]=Skxyz[a0];	// the whole thing is just a centroid
+	    Xv[0]=Skxyz[a0];	// the whole thing is just a centroid
 	    continue;
 	}
 	
 	// make the local/global "rotation" matrix
-	Locals.mask(Clusters[ci]);	// activate ci-th cluster only
+	Lv=clu_view(Locals, ci);	// ci-th cluster only
 	
-	Da=Locals.dim();
+	Da=Lv.dim();
 	R.set_size(Dim, Da);
 	
 	Distorts[ci].len_dim(Da, Dim);
 	Ideals[ci].len_dim(Da, Dim);
-	W[ci].dim(Da);
+	Framewgt[ci].dim(Da);
 	
 	// make up ideal and distorted frames
 	for (p=0; p<Da; p++)
@@ -459,11 +470,11 @@ void Iproj_::flesh_skel(const Trimat_& Dist, Points_& Xyz)
 	    Ideals[ci][p].set_values();
 	    Lendiff=Ideals[ci][p][p]=Imoms[ci][p];  // p-th coord is the ideal length
 	    Lendiff=fabs(Distorts[ci][p].vec_len()-Lendiff)/Lendiff;
-	    W[ci][p]=(HALFVAL/(HALFVAL+Lendiff));	    // weight is high if rel. length diff is small
+	    Framewgt[ci][p]=(HALFVAL/(HALFVAL+Lendiff));	    // weight is high if rel. length diff is small
 	}
 	
 	// rotate ideal frame onto distorted (with flip: improper rotation)
-	Hr.best_rotflip(Ideals[ci], Distorts[ci], W[ci]);
+	Hr.best_rotflip(Ideals[ci], Distorts[ci], Framewgt[ci]);
 	
 	// get the sign of the determinant of the rotation matrix
 	if (Detsign=Hr.det_sign())	// assignment intentional
@@ -481,12 +492,11 @@ void Iproj_::flesh_skel(const Trimat_& Dist, Points_& Xyz)
 	}
 	
 	// apply the local-->global transform to points in local cluster
-	for (i=0; i<Locals.active_len(); i++)
-	    Xyz[i]=R*Locals[i]+Skxyz[a0];
+	for (i=0; i<Lv.active_len(); i++)
+	    Xv[i]=R*Lv[i]+Skxyz[a0];
 
 	a0+=Da+1;    
     }
-    Xyz.mask(true);
     
     Fno=wi;	// the number of flippable ("non-flat") clusters
     if (!Fno)	// don't bother w/ corrections if no flips can be done...
@@ -497,7 +507,7 @@ void Iproj_::flesh_skel(const Trimat_& Dist, Points_& Xyz)
     
     // see if flipping the clusters improves the overall structure
     float Q, Qflip;
-    Points_ Xyzflip=Xyz;    // temp copy for flipping local clus
+    Xyzflip=Xyz;    // temp copy for flipping local clus
     register unsigned int Flipno;
     
     /* NOTE: redoing the rotations is terribly inefficient:
@@ -526,8 +536,8 @@ void Iproj_::flesh_skel(const Trimat_& Dist, Points_& Xyz)
 	    ci=Rss[wi].ci; a0=Rss[wi].a0;
 	    Q=Rss[wi].Q;
 	    
-	    Locals.mask(Clusters[ci]);	// activate ci-th cluster only
-	    Da=Locals.dim();
+	    Lv=clu_view(Locals, ci);	// ci-th cluster only
+	    Da=Lv.dim();
 	    R.set_size(Dim, Da);
 	    
 	    // invert the shortest axis if the orig. transform was "pure"
@@ -535,7 +545,7 @@ void Iproj_::flesh_skel(const Trimat_& Dist, Points_& Xyz)
 		Ideals[ci][Da-1][Da-1]*=(-1.0);
 	    
 	    // "pure" rotation onto distorted
-	    Hr.best_rot(Ideals[ci], Distorts[ci], W[ci]);
+	    Hr.best_rot(Ideals[ci], Distorts[ci], Framewgt[ci]);
 	    
 	    for (p=0; p<Da; p++)
 	    {
@@ -545,12 +555,11 @@ void Iproj_::flesh_skel(const Trimat_& Dist, Points_& Xyz)
 	    }
 	    
 	    // apply the flip transform to the copy
-	    Xyzflip.mask(Clusters[ci]);
-	    for (i=0; i<Locals.active_len(); i++)
-		Xyzflip[i]=R*Locals[i]+Skxyz[a0];
+	    Fv=clu_view(Xyzflip, ci);
+	    for (i=0; i<Lv.active_len(); i++)
+		Fv[i]=R*Lv[i]+Skxyz[a0];
 	    
 	    // check if the flipping improved matters
-	    Xyzflip.mask(true);
 	    Qflip=clu_qual(Clusters[ci], Xyzflip, Dist);
 	    if (Qflip<Q)
 	    {
@@ -560,16 +569,13 @@ void Iproj_::flesh_skel(const Trimat_& Dist, Points_& Xyz)
 	    }
 	    else	// put back original vectors
 	    {
-		Xyz.mask(Clusters[ci]);
-		Xyzflip.mask(Clusters[ci]);
-		for (p=0; p<Clusters[ci].on_no(); p++)
-		    Xyzflip[p]=Xyz[p];
-		Xyzflip.mask(true);
+		Xv=clu_view(Xyz, ci);
+		for (p=0; p<Fv.active_len(); p++)
+		    Fv[p]=Xv[p];
 		if (Rss[wi].Detsign>0)
 		    Ideals[ci][Da-1][Da-1]*=(-1.0);	// flip back if necessary
 	    }
 	}
-	Xyz.mask(true);
 	if (Flipno) Xyz=Xyzflip;	// was modified, put back
     }
     while (Flipno);
@@ -624,27 +630,27 @@ int descend_rs(const void *P1, const void *P2)
  * If Oldim<Mindim, then Mindim is set to Oldim.
  * Xyz is supposed to have been appropriately masked; the point dimensions
  * will be adjusted within. 
+ * If Warm is true (default false), then the Lanczos diagonalisation
+ * is started from the eigenvectors of the previous warm call:
+ * this is useful when the same matrix is projected again and again
+ * with small changes between the cycles.
  * Return value: the new dimension or 0 if Xyz doesn't have enough 
  * active points. Also returns the sqrt of moments of inertia in *Moms
  * if Moms!=NULL (NULL is the default). Private
  */
 unsigned int Iproj_::metric_project(const Trimat_& Metric,  
 	double Evfract, unsigned int Mindim, unsigned int Oldim, 
-	Points_& Xyz, Vector_ *Moms)
+	Points_& Xyz, Vector_ *Moms, bool Warm)
 {
     unsigned int i, j, Size=Metric.rno();
 
-    // diagonalise metric matrix
-    static Vector_ Eval;
-    static Sqmat_ Evec;
-    
     if (Size>Xyz.active_len())	// paranoia
     {
 	cerr<<"? metric_project(): free point no. "
 	    <<Xyz.active_len()<<"<"<<Size<<", cannot project\n";
 	return(0);  // *Moms not modified
     }
-    Eval.dim(Size);
+    Eval.dim(Size);	// workspace members
     Evec.set_size(Size);
     
     // modify dimension limits if necessary
@@ -652,16 +658,27 @@ unsigned int Iproj_::metric_project(const Trimat_& Metric,
     if (!Mindim) Mindim=1;
     if (Mindim>=Oldim) Mindim=Oldim-1;
     
-    /* Diagonalisation: if the old dimension is less than fourth
-     * of Size, then the Rsm object is used which generates all
-     * eigenvalues and a chosen set of eigenvectors. Otherwise, 
+    /* Diagonalisation: only the first Oldim eigenvalues are used below.
+     * If Oldim is much smaller than Size, then these and their
+     * eigenvectors are obtained by the Lanczos method (warm-started
+     * from the previous cycle if Warm is set). If the old
+     * dimension is less than fourth of Size (or Lanczos did not
+     * converge), then the Rsm object is used which generates
+     * all eigenvalues and a chosen set of eigenvectors. Otherwise,
      * all eigenvectors are made: this is faster, say the books.
      */
+    static const unsigned int LANCZOS_RATIO=10;
     Rsmdiag_ Rsm;
-    bool Somevec=bool(4*Oldim<=Size);
+    bool Lanc=bool(LANCZOS_RATIO*Oldim<=Size), Somevec=false;
     
-    if (Somevec) Rsm.get_evals(Metric, Eval); // all eigenvalues
-    else eigen_ql(Metric, Eval, Evec);	// total diagonalisation
+    if (Lanc && Lanczos.top_eigen(Metric, Oldim, Eval, Evec, Warm))
+	Lanc=false;	// no convergence, use the full methods
+    if (!Lanc)
+    {
+	Somevec=bool(4*Oldim<=Size);
+	if (Somevec) Rsm.get_evals(Metric, Eval); // all eigenvalues
+	else eigen_ql(Metric, Eval, Evec);	// total diagonalisation
+    }
     
     // subtract Diagshf from the eigenvalues
     for (i=0; i<Oldim; i++)
@@ -726,37 +743,35 @@ unsigned int Iproj_::metric_project(const Trimat_& Metric,
  * to the correct size prior to the call.
  * Metric is the overall metric matrix of the individual points, 
  * Locals and Imoms hold the local inertial coordinates and moments of
- * inertia for all points. Locals is a "maskable array".
+ * inertia for all points. The clusters of Locals are accessed
+ * via views (cf. clu_view()), its mask is not changed.
  * Imoms is supposed to be in an all-active
  * state (not checked). Private
  */
 void Iproj_::make_skmet(const Trimat_& Metric)
 {
-    static Matrix_ Abprods;	// centroid scalar products
-    static Array_<double> Momscal;	// moment scaling
-    
     Abprods.set_size(Cluno, Rno+Cluno);
     Momscal.len(Sksize);
     ctr_prod(Metric, Abprods);	// get centroid scalar products
 
     register unsigned int ci, cj, ix, a0, b0, Da, Db, Pa, Pb, Na, Nb, p, q, ap, aq, bq;
     register double AA, AB, Spa0;
-    Matrix_ Loca, Aibj, Sptq;	// temp matrices for mixed inertial scalprods
-    Matrix_ *Locds=new Matrix_ [Cluno];    // local coords extracted for speed
+    Ptview_ Lva, Lvb;	    // local coords of clusters [ci] and [cj]
+    Locds.len(Cluno);	// local coords extracted for speed
     
     for (ci=a0=Pa=0; ci<Cluno; ci++)
     {
 	// INTRA-cluster
 	AA=Skmet[a0][a0]=Abprods[ci][Pa];   // <a0|a0>
-	Locals.mask(Clusters[ci]);
-	Na=Clusters[ci].on_no();	// dim and no. of pts in [ci]
-	Da=(Na==1)? 0: Locals.dim();	// 1-member clusters are 0-dimensional
+	Lva=clu_view(Locals, ci);
+	Na=Lva.active_len();	// dim and no. of pts in [ci]
+	Da=(Na==1)? 0: Lva.dim();	// 1-member clusters are 0-dimensional
 	
 	for (p=0, ap=a0+1; p<Da; p++, ap++)
 	{
 	    // <s'p|a0>: norm s'p to sqrt of inert. mom.
 	    Momscal[ap]=1.0/Imoms[ci][p];
-	    Spa0=Skmet[ap][a0]=iv_ctrprod(Abprods, ci, Pa, p)*Momscal[ap];
+	    Spa0=Skmet[ap][a0]=iv_ctrprod(Lva, Abprods, ci, Pa, p)*Momscal[ap];
 	    
 	    // <sp|sp>
 	    Skmet[ap][ap]=Imoms[ci][p]*Imoms[ci][p]+2.0*Spa0+AA;
@@ -773,7 +788,7 @@ void Iproj_::make_skmet(const Trimat_& Metric)
 	{
 	    Locds[ci].set_size(Na, Da);
 	    for (ix=0; ix<Na; ix++)
-		Locds[ci].row(Locals[ix], ix);
+		Locds[ci].row(Lva[ix], ix);
 	    Loca=Locds[ci].get_transpose();	    // transpose needed for ci/cj stuff
 	}
 	
@@ -781,21 +796,19 @@ void Iproj_::make_skmet(const Trimat_& Metric)
 	for (cj=b0=Pb=0; cj<ci; cj++)
 	{
 	    AB=Skmet[a0][b0]=Abprods[ci][Pb];	// <a0|b0>
-	    Locals.mask(Clusters[cj]);
-	    Nb=Clusters[cj].on_no(); // dim and no. of pts in [cj]
-	    Db=(Nb==1)? 0: Locals.dim(); // 1-point clusters are 0-dimensional
+	    Lvb=clu_view(Locals, cj);
+	    Nb=Lvb.active_len(); // dim and no. of pts in [cj]
+	    Db=(Nb==1)? 0: Lvb.dim(); // 1-point clusters are 0-dimensional
 	    
-	    // fill up the <a0|tq> row with <a0|t'q>: uses cj-th mask
+	    // fill up the <a0|tq> row with <a0|t'q>: uses cj-th cluster
 	    for (q=0, bq=b0+1; q<Db; q++, bq++)
-		Skmet[a0][bq]=iv_ctrprod(Abprods, ci, Pb, q)*Momscal[bq];
+		Skmet[a0][bq]=iv_ctrprod(Lvb, Abprods, ci, Pb, q)*Momscal[bq];
 	    
-	    // fill up the <sp|b0> column with <s'p|b0>: needs ci-th mask
-	    Locals.mask(Clusters[ci]);
+	    // fill up the <sp|b0> column with <s'p|b0>: needs ci-th cluster
 	    for (p=0, ap=a0+1; p<Da; p++, ap++)
-		Skmet[ap][b0]=iv_ctrprod(Abprods, cj, Pa, p)*Momscal[ap];
+		Skmet[ap][b0]=iv_ctrprod(Lva, Abprods, cj, Pa, p)*Momscal[ap];
 
 	    // make the <sp|tq> rectangular region
-	    Locals.mask(true);	// access will be via get_bit() from now on
 	    Aibj.set_size(Na, Nb);	// <a'i|b'j>
 	    
 	    // prepare for <s'p|t'q> products if Da and Db both >0
@@ -824,8 +837,6 @@ void Iproj_::make_skmet(const Trimat_& Metric)
 	// next step
 	a0+=Da+1; Pa+=Na+1;
     }	    // for ci
-    
-    delete [] Locds;
 }
 // END of make_skmet()
 
@@ -895,19 +906,18 @@ void Iproj_::ctr_prod(const Trimat_& Metric, Matrix_& Abprods) const
  * Ctridx-th cluster and the Coord-th local axis of inertia of the current
  * cluster. Abprods contains the scalar products of the position vectors
  * and the centroids (for the layout, see the comments of ctr_prod() ), 
- * Locals holds the local cluster coordinates, it is assumed to have been
- * masked appropriately before the call.
+ * Loc is the view of the local coordinates of the current cluster.
  * Coffs marks the column of Abprods where the Cluidx-th
- * cluster starts (with the centroid). Private
+ * cluster starts (with the centroid). Private static
  */
-double Iproj_::iv_ctrprod(const Matrix_& Abprods,
-	unsigned int Ctridx, unsigned int Coffs, unsigned int Coord) const
+double Iproj_::iv_ctrprod(const Ptview_& Loc, const Matrix_& Abprods,
+	unsigned int Ctridx, unsigned int Coffs, unsigned int Coord)
 {
     register unsigned int ic;
     register double A0b0=Abprods[Ctridx][Coffs], Temp=0.0;
 
-    for (ic=0; ic<Locals.active_len(); ic++)
-	Temp+=Locals[ic][Coord]*(Abprods[Ctridx][Coffs+ic+1]-A0b0);
+    for (ic=0; ic<Loc.active_len(); ic++)
+	Temp+=Loc[ic][Coord]*(Abprods[Ctridx][Coffs+ic+1]-A0b0);
     return(Temp);
 }
 // END of iv_ctrprod()
@@ -965,7 +975,6 @@ unsigned int Iproj_::trineq_filter(Trimat_& Dist, Trimat_& Metric,
     if (Tsmcyc>MAX_TSMCYC) Tsmcyc=MAX_TSMCYC;
     
     unsigned int Itno, Tviol, Cviol;
-    static Vector_ Cdist2;
     
     // construct Metric and smooth it until no violations are found
     Metric.set_size(Dist.rno());
@@ -1208,23 +1217,18 @@ unsigned int Iproj_::sub_matrix(const Trimat_& Mat, const Bits_& Act,
 // END of sub_matrix()
 
 /* make_locdist(): calculates the interpoint distances among the
- * active points in Locals and puts these into Locdist. 
+ * points of the ci-th cluster in Locals and puts these into Locdist. 
  * Locdist is assumed to have been zeroed before the call. Private
  */
-void Iproj_::make_locdist()
+void Iproj_::make_locdist(unsigned int ci)
 {
     register unsigned int i, j;
-    register int di, dj;
+    Ptview_ Lv=clu_view(Locals, ci);
     
-    for (di=i=0; i<Rno; i++, di++)
-    {
-	if (!Locals.active(i)) { di--; continue; }	// inactive point, skip
-	for (dj=j=0; j<=i; j++, dj++)
-	{
-	    if (!Locals.active(j)) { dj--; continue; }	// inactive
-	    Locdist[i][j]=diff_len2(Locals[di], Locals[dj]);	// calc distances
-	}
-    }
+    // member indices are ascending, so [idx(i)][idx(j)] is in the lower triangle
+    for (i=0; i<Lv.active_len(); i++)
+	for (j=0; j<=i; j++)
+	    Locdist[Lv.idx(i)][Lv.idx(j)]=diff_len2(Lv[i], Lv[j]);	// calc distances
 }
 // END of make_locdist() 
 
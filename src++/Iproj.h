@@ -18,8 +18,11 @@
 #include "Array.h"
 #include "Vector.h"
 #include "Matrix.h"
+#include "Sqmat.h"
 #include "Trimat.h"
 #include "Points.h"
+#include "Lanczos.h"
+#include "Hirot.h"
 
 // ==== CLASSES ====
 
@@ -38,12 +41,31 @@ class Iproj_
     Points_ Locals, Imoms;  // local cluster coordinates and moments of inertia
     Bits_ *Clusters;	    // the cluster membership
     unsigned int *Ptclu, *Ptoffs, *Cluoffs; // idx offset arrays, cf. make_offsets()
+    unsigned int *Cluidx, *Clubeg;  // cluster member lists, cf. make_offsets()
     unsigned int Rno, Cluno;	// residue and cluster numbers
     Trimat_ Skmet, Locdist;	// skeleton metric matrix and local Euclidean distances
     Points_ Skxyz;	// skeleton coordinates
     unsigned int Maxlocdim, Sksize; // maximal local dimension, skeleton size
     double Diagshf;	// diagonal shift
     
+    /* Workspaces of the projection routines. These are kept here
+     * rather than as function statics so that each Iproj_ object
+     * can be used independently (e.g. in different threads).
+     * The library classes reallocate only if the size changes.
+     */
+    Vector_ Eval;	// eigenvalues...
+    Sqmat_ Evec;	// ...and eigenvectors in metric_project()
+    Matrix_ Abprods;	// centroid scalar products in make_skmet()
+    Array_<double> Momscal;	// moment scaling in make_skmet()
+    Vector_ Cdist2;	// centroid distances in trineq_filter()
+    Trimat_ Fullmet;	// full metric matrix in skel_project()
+    Lanczos_ Lanczos;	// partial diagonaliser in metric_project()
+    Array_<Matrix_> Locds;	// local cluster coordinates in make_skmet()...
+    Matrix_ Loca, Aibj, Sptq;	// ...and the mixed inertial scalar products
+    Array_<Points_> Distorts, Ideals;	// cluster frames in flesh_skel()...
+    Points_ Framewgt, Xyzflip;	// ...their weights and the flipped coordinates
+    Hirot_ Hr;	// rotations in flesh_skel()
+    
     // methods
     public:
     
@@ -56,6 +78,7 @@ class Iproj_
     {
 	delete [] Clusters; delete [] Ptclu; 
 	delete [] Ptoffs; delete [] Cluoffs;
+	delete [] Cluidx; delete [] Clubeg;
     }
     
 	// size
@@ -130,11 +153,23 @@ class Iproj_
     unsigned int skel_project(Trimat_& Dm, 
 	    double Evfract, unsigned int Oldim, Points_& Xyz);
     
+    /* cold_start(): the full and skeleton projections reuse the
+     * eigenvectors of the previous projection to speed up the
+     * diagonalisation. This method makes the next projection start
+     * from scratch: call it at the beginning of each simulation run
+     * so that the runs do not depend on each other.
+     */
+    void cold_start() { Lanczos.forget(); }
+    
     // private methods
     private:
 	// size
     void make_offsets();
     
+    /* clu_view(): returns a view of the points of the ci-th cluster in Pts. */
+    Ptview_ clu_view(Points_& Pts, unsigned int ci) const
+	{ return(Ptview_(Pts, Cluidx+Clubeg[ci], Clubeg[ci+1]-Clubeg[ci])); }
+    
 	// reconstruction
     void flesh_skel(const Trimat_& Dist, Points_& Xyz);
     static float clu_qual(const Bits_& Clu, const Points_& Xyz, const Trimat_& Dist);
@@ -142,13 +177,13 @@ class Iproj_
 	// projections
     unsigned int metric_project(const Trimat_& Metric,  
 	    double Evfract, unsigned int Mindim, unsigned int Oldim, 
-	    Points_& Xyz, Vector_ *Moms=NULL);
+	    Points_& Xyz, Vector_ *Moms=NULL, bool Warm=false);
     
 	// scalar products
     void make_skmet(const Trimat_& Metric);
     void ctr_prod(const Trimat_& Metric, Matrix_& Abprods) const;
-    double iv_ctrprod(const Matrix_& Abprods,
-	    unsigned int Ctridx, unsigned int Coffs, unsigned int Coord) const;
+    static double iv_ctrprod(const Ptview_& Loc, const Matrix_& Abprods,
+	    unsigned int Ctridx, unsigned int Coffs, unsigned int Coord);
     void aibj_prod(const Trimat_& Metric, const Matrix_& Abprods, 
 	    unsigned int Aidx, unsigned int Bidx, 
 	    unsigned int Aoffs, unsigned int Boffs, 
@@ -170,7 +205,7 @@ class Iproj_
     static unsigned int sub_matrix(const Trimat_& Mat, const Bits_& Act, 
 	Trimat_& Submat);
     
-    void make_locdist();
+    void make_locdist(unsigned int ci);
     void apply_locdist(Trimat_& Dist) const;
 
     // "forbidden methods"
@@ -21,7 +21,7 @@
 
 // ---- UTILITY HEADERS ----
 
-#include "List1.h"
+#include "Vlist.h"
 #include "pdbprot.h" 
 
 // ---- MODULE HEADERS ----
@@ -52,7 +52,7 @@ static void make_atoms(Chain_ *Chain, const Points_& Xyz, const Polymer_& Model)
  */
 void make_outname(String_& Basename, int Rcyc, const String_& Ext)
 {
-    static String_ Numstr;
+    String_ Numstr;
     
     prepare_basename(Basename);
     Basename+="_"; 
@@ -266,7 +266,7 @@ static Pdbentry_ *make_pdbentry(const Points_& Xyz, const Polymer_& Model,
  */
 static void make_secs(Chain_ *Chain, const Pieces_& Pieces)
 {
-    Clist1_<Sstr_> Slist=Pieces.secs();
+    Cvlist_<Sstr_> Slist=Pieces.secs();
     unsigned int Slen=Slist.len();
     if (!Slen)	// no secondary structure, exit
     {
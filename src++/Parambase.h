@@ -77,8 +77,10 @@ class Parambase_
     /* changed(): returns Changed (true after input, false if no change) */
     bool changed() const { return(Changed); }
     
-    /* not_changed(): resets Changed to false. Used after value enquiries. */
-    void not_changed() { Changed=false; }
+    /* not_changed(): resets Changed to false. Used after value enquiries.
+     * Does not write if already reset so that parallel readers do not clash.
+     */
+    void not_changed() { if (Changed) Changed=false; }
     
     /* name(): returns the name. */
     const String_& name() const { return(Name); }
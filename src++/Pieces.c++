@@ -162,8 +162,10 @@ void Pieces_::make_coils()
 }
 // END of make_coils()
 
-/* make_ptidx(): constructs the internal index array Ptclu.
- * Ptclu[i] is the index of the cluster that contains the i:th point.
+/* make_ptidx(): constructs the internal index arrays. Ptclu[i] is
+ * the index of the cluster that contains the i:th point, and
+ * the members of the ci-th cluster are listed in Cluidx from
+ * Clubeg[ci] on (see clu_idx()).
  * Private
  */
 void Pieces_::make_ptidx()
@@ -172,6 +174,7 @@ void Pieces_::make_ptidx()
     Ptclu=new int [Rno+2];
     
     register int i, ci;
+    register unsigned int k;
     
     for (i=0; i<Rno+2; i++)
     {
@@ -180,6 +183,18 @@ void Pieces_::make_ptidx()
 	    cerr<<"\n! Pieces_::make_ptidx(): Point "<<i<<" is not found in any of the clusters\n";
 	Ptclu[i]=ci;
     }
+    
+    // list the cluster members
+    Clubeg.len(clu_no()+1);
+    for (ci=k=0; ci<clu_no(); ci++) k+=Clus[ci].on_no();
+    Cluidx.len(k);
+    for (ci=k=0; ci<clu_no(); ci++)
+    {
+	Clubeg[ci]=k;
+	for (i=0; i<Rno+2; i++)
+	    if (Clus[ci].get_bit(i)) Cluidx[k++]=i;
+    }
+    Clubeg[clu_no()]=k;
 }
 
 // ---- Input/output ----
@@ -243,7 +258,7 @@ istream& operator>>(istream& In, Pieces_& P)
     streampos Linbeg=0, Linend=In.tellg();  // current pos
     Helix_ Htemp;   // temporary structures and list
     Beta_ Btemp;
-    List1_<Sstr_> Templist;
+    Vlist_<Sstr_> Templist;
     Bits_ Hsmask(P.Rno+2), Secsmask(P.Rno+2, false);	// new secondary structure mask
     
     // read the stream line-by-line
@@ -347,7 +362,7 @@ istream& operator>>(istream& In, Pieces_& P)
 /* <<: lists the secondary structure elements to Out. */
 ostream& operator<<(ostream& Out, const Pieces_& P)
 {
-    Clist1_<Sstr_> Sl=P.secs();
+    Cvlist_<Sstr_> Sl=P.secs();
     for (Sl.begin(); Sl!=NULL; Sl++)
 	Out<<(*(*Sl));
     return(Out);
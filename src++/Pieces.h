@@ -18,7 +18,7 @@
 
 // ---- UTILITY HEADERS ----
 
-#include "List1.h"
+#include "Vlist.h"
 #include "Array.h"
 #include "Bits.h"
 #include "Smartptr.h"
@@ -57,12 +57,13 @@ class Pieces_
     // data
     private:
     
-    List1_<Sstr_> Secs;	// secondary structure list
-    List1_<Linsegm_> Coils;	// coils between sstr elements
+    Vlist_<Sstr_> Secs;	// secondary structure list
+    Vlist_<Linsegm_> Coils;	// coils between sstr elements
     Bits_ Secsmask;	// true for all residues within secondary structures
     Array_<Bits_> Clus;	// mask for each cluster to be used in projection
     Array_<Clutype_> Ctype;	// Ctype[i] is the cluster type of cluster i
     int *Ptclu;    // Ptclu[i] is the cluster index holding i
+    Array_<unsigned int> Cluidx, Clubeg;    // members of cluster ci: Cluidx[Clubeg[ci]..Clubeg[ci+1]-1]
     unsigned int Rno;	// chain size (may be changed but not queried)
     bool Changed;	// sentinel (true if re-calc needed)
     
@@ -92,13 +93,21 @@ class Pieces_
     void res_no(unsigned int R);
     
 	// structure list access
-    const List1_<Sstr_>& secs() const { return(Secs); }
-    const List1_<Linsegm_>& coils() const { return(Coils); }
+    const Vlist_<Sstr_>& secs() const { return(Secs); }
+    const Vlist_<Linsegm_>& coils() const { return(Coils); }
     
 	// cluster access
     /* clus(i): returns a const reference to the i-th residue cluster safely. */
     const Bits_& clus(unsigned int i) const { return(Clus(i)); }
     
+    /* clu_idx(i): returns the indices of the members of the i-th
+     * residue cluster in increasing order, clu_len(i) of them.
+     * Handy for making masked views (cf. Ptview_) of a cluster.
+     * No range checks.
+     */
+    const unsigned int *clu_idx(unsigned int i) const { return(&Cluidx[Clubeg[i]]); }
+    unsigned int clu_len(unsigned int i) const { return(Clubeg[i+1]-Clubeg[i]); }
+    
     /* clu_type(i): returns the type of the i-th residue cluster
      * or UNKNOWN when i is invalid.
      */
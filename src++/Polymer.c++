@@ -48,14 +48,7 @@ Acdist_ Polymer_::Acdist;
  */
 double Polymer_::estim_dist(unsigned int R1, unsigned int R2)
 {
-    // shall we do the estimation?
-    if (Changed)
-    {
-	for (unsigned int i=0; i<len(); i++)
-	    Consphob[i]=Monomers[i].Cons*Monomers[i].Phob;
-	Dp.estim_params(Consphob);
-	Changed=0;
-    }
+    update_estim();	// shall we do the estimation?
     if (!len() || R1>len() || R2>len())
     {
 	cerr<<"\n? Polymer_::estim_dist("<<R1<<", "<<R2<<"): Invalid index, 0.0 returned\n";
@@ -65,6 +58,22 @@ double Polymer_::estim_dist(unsigned int R1, unsigned int R2)
 }
 // END of estim_dist()
 
+/* update_estim(): performs the hydrophobic distance estimation
+ * if the conservation or hydrophobicity data have changed.
+ * Called automatically by estim_dist(), call explicitly before
+ * several threads start calling estim_dist() on the same object.
+ */
+void Polymer_::update_estim()
+{
+    if (!Changed) return;
+    
+    for (unsigned int i=0; i<len(); i++)
+	Consphob[i]=Monomers[i].Cons*Monomers[i].Phob;
+    Dp.estim_params(Consphob);
+    Changed=0;
+}
+// END of update_estim()
+
 /* master(Mseq): changes the master sequence within the alignment. An
  * argument of 0 means the consensus, otherwise the Mseq-1:th sequence
  * will be the consensus. No action is taken if Mseq is invalid.
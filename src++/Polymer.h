@@ -146,6 +146,13 @@ class Polymer_
      */
     double estim_dist(unsigned int R1, unsigned int R2);
     
+    /* update_estim(): performs the hydrophobic distance estimation
+     * if the conservation or hydrophobicity data have changed.
+     * Called automatically by estim_dist(), call explicitly before
+     * several threads start calling estim_dist() on the same object.
+     */
+    void update_estim();
+    
     /* master(): returns 0 if the master sequence is the consensus of the
      * alignment, and i+1 if the i-th sequence in the alignment is the master.
      * master(Mseq): changes the master sequence within the alignment. An
@@ -13,10 +13,14 @@
 #include <string.h>
 #include <ctype.h>
 
+#ifdef USE_THREADS
+    #include <pthread.h>
+#endif
+
 // ---- MODULE HEADERS ----
 
 #include "Restr.h"
-#include "portrandom.h"
+#include "ctrrandom.h"
 
 // ---- DEFINITIONS ----
 
@@ -24,6 +28,77 @@
 #define M_PI		3.14159265358979323846
 #endif
 
+// tile size of the bound smoothing passes (cf. smooth_tiles())
+#define SMOOTH_TILE 64
+
+// ---- TYPEDEFS AND PROTOTYPES ----
+
+/* Bound smoothing: Smoothjob_ describes the smoothing of a restraint
+ * set. The bounds are read in place from the restraint matrix Bounds
+ * (lower triangle: lower bounds, upper triangle: upper bounds).
+ * A pass is shared among Thrno threads, each works on a Smoothpart_
+ * of it. The helper threads are kept for all passes and wait
+ * for the next one on the Go condition.
+ */
+typedef struct
+{
+    const Sqmat_ *Bounds;   // the restraint limits, read only during a pass
+    const Trimat_ *Strict;  // strictness: 0.0 for soft restraints
+    Trimat_ *Newbound;	// new bounds of a pass (0.0 if unchanged)
+    unsigned int Size, Thrno;	// size, number of threads
+    bool Lower;	    // false for upper, true for lower bound passes
+#ifdef USE_THREADS
+    pthread_mutex_t Lock;
+    pthread_cond_t Go, Done;
+    unsigned int Gen, Busy; // pass counter, no. of busy helpers
+    pthread_t *Threads;	// Threads[1..Thrno-1] are the helpers
+    bool Quit;	    // helpers shall exit
+#endif
+}
+Smoothjob_;
+
+typedef struct
+{
+    Smoothjob_ *Job;
+    unsigned int Thridx;    // thread index [0..Job->Thrno-1]
+    int Adjno, Violno;	// number of adjustments and violations found
+    double *Scratch;	// tile workspace, 5*SMOOTH_TILE*SMOOTH_TILE
+}
+Smoothpart_;
+
+static Smoothpart_ *smooth_start(Smoothjob_& Job);
+static void smooth_stop(Smoothjob_& Job, Smoothpart_ *Parts);
+static int smooth_pass(Smoothjob_& Job, Smoothpart_ *Parts, int& Violno);
+static void smooth_tiles(Smoothpart_& Part);
+static void smooth_gather(const Smoothjob_& Job, unsigned int Ib, unsigned int Kb,
+	bool Lower, double *Blk);
+
+/* Restraint merging: Restrhash_ is an open-addressing hash table
+ * which indexes the CA/SCC restraints of a list by their ends.
+ * An end is coded as 2*Pos for CA and 2*Pos+1 for SCC, the lower
+ * code is E1, so X:Y and Y:X restraints get the same key.
+ */
+typedef struct
+{
+    Restr_ *Rp;		// restraint in the list, NULL if the slot is empty
+    unsigned int E1, E2;    // end codes (E1<=E2)
+}
+Rhslot_;
+
+struct Restrhash_
+{
+    Rhslot_ *Slots;
+    unsigned int Size, No;  // table size (a power of 2), no. of entries
+};
+
+static void rhash_init(Restrhash_& Rhash, unsigned int N);
+static int rhash_ends(const Restr_& R, unsigned int& E1, unsigned int& E2);
+static Rhslot_ *rhash_slot(const Restrhash_& Rhash, unsigned int E1, unsigned int E2);
+static void rhash_add(Restrhash_& Rhash, Restr_ *Rp);
+#ifdef USE_THREADS
+extern "C" void *smooth_thread(void *Part);
+#endif
+
 // ==== Restr_ METHODS ====
 
 // ---- Input,output ----
@@ -324,9 +399,11 @@ int Restraints_::merge_restr(unsigned int i, unsigned int j,
  * according to the list of external restraints (which should already
  * be prepared in the calling object), secondary structure (from Pieces)
  * and intra-monomer atom distances (from Polymer). Call only once
- * before the simulations.
+ * before the simulations. The bounds are smoothed by Thrno
+ * threads (default 1) if thread support was compiled in.
  */
-void Restraints_::setup_restr(const Pieces_& Pieces, const Polymer_& Polymer)
+void Restraints_::setup_restr(const Pieces_& Pieces, const Polymer_& Polymer,
+	unsigned int Thrno)
 {
     // zero everything
     Lowup.set_values(); Lowup2.set_values();
@@ -337,9 +414,10 @@ void Restraints_::setup_restr(const Pieces_& Pieces, const Polymer_& Polymer)
     setup_bondbump();
     setup_secstrestr(Pieces);
     setup_extrestr(Polymer);
+    compile_extrestr(Pieces);
 
     // smooth restraints
-    smooth_restr(0);
+    smooth_restr(0, Thrno);
 }
 // END of setup_restr()
 
@@ -443,6 +521,40 @@ void Restraints_::setup_extrestr(const Polymer_& Polymer)
 }
 // END of setup_extrestr()
 
+/* compile_extrestr(): puts the non-CA:CA external restraints into
+ * the Ext array in list order and sorts their indices into Extin
+ * and Extbetw according to the cluster layout in Pieces.
+ * Atoms other than CA are taken to be SCC, as in the steric checks.
+ * Private
+ */
+void Restraints_::compile_extrestr(const Pieces_& Pieces)
+{
+    static const String_ CA("CA");  // string comparison
+    
+    unsigned int k, Inno, Betwno;
+    bool Ca1, Ca2;
+    
+    Ext.len(Restrs.len()); Extin.len(Restrs.len()); Extbetw.len(Restrs.len());
+    for (Restrs.begin(), k=Inno=Betwno=0; Restrs!=NULL; Restrs++)
+    {
+	Ca1=bool(Restrs->atom(1)==CA); Ca2=bool(Restrs->atom(2)==CA);
+	if (Ca1 && Ca2) continue;   // not used by the steric checks
+	
+	Extrestr_& E=Ext[k];
+	E.Pos1=Restrs->pos(1); E.Pos2=Restrs->pos(2);
+	E.Type=Ca1? CA_SCC: (Ca2? SCC_CA: SCC_SCC);
+	E.Low=Restrs->low(); E.Up=Restrs->up();
+	E.Low2=Restrs->low2(); E.Up2=Restrs->up2();
+	E.Strict=Restrs->strict();
+	
+	if (Pieces.members(E.Pos1, E.Pos2)>=0) Extin[Inno++]=k;
+	else Extbetw[Betwno++]=k;
+	k++;
+    }
+    Ext.len(k); Extin.len(Inno); Extbetw.len(Betwno);
+}
+// END of compile_extrestr()
+
 /* setup_secstrestr(): adds the distance restraints defined by the 
  * secondary structure. These overwrite everything they see.
  * The list of secondary structures comes from Pieces.
@@ -453,7 +565,7 @@ void Restraints_::setup_secstrestr(const Pieces_& Pieces)
     // Factors by which the distances are allowed to deviate
     const float LODEVFACT=0.99F, HIDEVFACT=1.01F;
     
-    Clist1_<Sstr_> Slist=Pieces.secs();    // secondary struct list iterator
+    Cvlist_<Sstr_> Slist=Pieces.secs();    // secondary struct list iterator
     if (!Slist.len()) return;	    // there were none
     
     Trimat_ Idist(Size), Strimat(Size);	// temp storage
@@ -483,118 +595,381 @@ void Restraints_::setup_secstrestr(const Pieces_& Pieces)
  * are already set up. Performs Pass passes (or as many as necessary
  * if Pass=0, default 1) and does not check the
  * incompatibility between the "hard" restraints.
+ * The bounds are read in place from Lowup. Each pass is split into
+ * tiles which are shared among Thrno threads (default 1, cf. smooth_pass()
+ * below), the threads are started once and kept for all passes.
+ * The new bounds are collected during a pass and applied at its end,
+ * so the result does not depend on the order of the tiles or on
+ * the number of threads.
  * Return value: the number of inequality violations found.
  * Private
  */
-int Restraints_::smooth_restr(unsigned int Pass)
+int Restraints_::smooth_restr(unsigned int Pass, unsigned int Thrno)
 {
     // NOTE: this is a real Piglet Algorithm. Use with caution.
     
-    // NOTE: this EPSILON was needed by GCC when compiling with -O2
-    static const double EPSILON=FLT_EPSILON;
+    register unsigned int i, j;
+    register const double *Nb;
+    int Cyc, Adjno, Violno=0;
     
-    Trimat_ Newbound(Size);    // temp storage for new bounds
-    register unsigned int i, j, k;
-    register double Lnew, Unew, Ltemp, Btemp;
-    int Cyc, Adjno, Violno;
+    /* The new bounds cannot be written into Lowup during a pass
+     * because the other tiles still read the old ones, they are
+     * kept in a triangular matrix until the end of the pass.
+     */
+    Trimat_ Newbound(Size);
+    Smoothjob_ Job;
+    Job.Bounds=&Lowup; Job.Strict=&Strict; Job.Newbound=&Newbound;
+    Job.Size=Size; Job.Thrno=(Thrno? Thrno: 1); Job.Lower=false;
+    Smoothpart_ *Parts=smooth_start(Job);
     
     // fix upper limits first (following Kuntz...)
     cout<<"SMUP: "<<flush;
     for (Cyc=0; !Pass || Cyc<Pass; Cyc++)
     {
-	Newbound.set_values(0.0); Adjno=0;
     	cout<<'.'<<flush;
-
-	// scan all pairs, collect new unsquared upper limits in Newbound
-	for (i=0; i<Size; i++)
-	{
-	    for (j=0; j<i; j++)
-	    {
-		if (hard(i, j)) continue;	// was "hard" restraint, no change
-
-		Btemp=up(i, j);
-		for (k=0; k<Size; k++)
-		{
-		    if (k==i || k==j) continue;
-		    Unew=up(i, k)+up(j, k);
-		    
-		    // upper limit can be narrowed
-		    if (Btemp>Unew+EPSILON)
-		    {
-			Btemp=Unew; ++Adjno;
-		    }
-		}	// for k
-		if (Btemp<up(i, j)-EPSILON) Newbound[i][j]=Btemp;
-		
-	    }	    // for j
-	}	// for i
+	Adjno=smooth_pass(Job, Parts, Violno);
 	if (!Adjno) break;  // no further modifications
 	
 	// copy modified upper limits back
 	for (i=0; i<Size; i++)
+	{
+	    Nb=Newbound[i];
 	    for (j=0; j<i; j++)
-		if (Newbound[i][j]>0.0) up(i, j, Newbound[i][j]);
+		if (Nb[j]>0.0) up(i, j, Nb[j]);
+	}
     }	    // for Cyc
     cout<<Cyc<<endl;
     
     // fix lower limits
     cout<<"SMLOW: "<<flush;
+    Job.Lower=true;
     for (Cyc=0; !Pass || Cyc<Pass; Cyc++)
     {
-	Newbound.set_values(0.0); Adjno=Violno=0;
 	cout<<'.'<<flush;
-	// scan all pairs, collect new lower limits in Newbound
-	for (i=0; i<Size; i++)
-	{
-	    for (j=0; j<i; j++)
-	    {
-		if (hard(i, j)) continue;	// was "hard" restraint
-		
-		Btemp=low(i, j);
-		for (k=0; k<Size; k++)
-		{
-		    if (k==i || k==j) continue;
-		    Lnew=low(i, k)-up(j, k);
-		    Ltemp=low(j, k)-up(i, k);
-		    if (Ltemp>Lnew) Lnew=Ltemp;
-		    if (up(i, j)<Lnew)
-		    {
-			Violno++; continue; // inequality violation :-(
-		    }
-		    
-		    // lower limit can be narrowed
-		    if (Btemp<Lnew-EPSILON) { Btemp=Lnew; ++Adjno; }
-		}	// for k
-		if (Btemp>low(i, j)+EPSILON) Newbound[i][j]=Btemp;
-		
-	    }	    // for j
-	}	// for i
+	Adjno=smooth_pass(Job, Parts, Violno);
 	if (!Adjno) break;  // no further modifications
 	
 	// copy modified lower limits back
 	for (i=0; i<Size; i++)
+	{
+	    Nb=Newbound[i];
 	    for (j=0; j<i; j++)
-		if (Newbound[i][j]>0.0) low(i, j, Newbound[i][j]);
+		if (Nb[j]>0.0) low(i, j, Nb[j]);
+	}
 	
 	if (Violno) break;  // something is fishy, stop here
     }	    // for Cyc
     cout<<Cyc<<", triangle violations="<<Violno<<endl;
+    
+    smooth_stop(Job, Parts);
     return(Violno);
 }
 // END of smooth_restr()
 
+/* smooth_start(): sets up the parts of Job and starts Job.Thrno-1
+ * helper threads which wait for the passes. If not all of them
+ * could be started, then Job.Thrno is reduced accordingly.
+ * Without thread support Job.Thrno is set to 1.
+ * Returns the array of parts, to be released by smooth_stop().
+ */
+static Smoothpart_ *smooth_start(Smoothjob_& Job)
+{
+    register unsigned int t;
+    
+#ifndef USE_THREADS
+    Job.Thrno=1;
+#endif
+    Smoothpart_ *Parts=new Smoothpart_ [Job.Thrno];
+    for (t=0; t<Job.Thrno; t++)
+    {
+	Parts[t].Job=&Job; Parts[t].Thridx=t;
+	Parts[t].Adjno=Parts[t].Violno=0;
+	Parts[t].Scratch=new double [5*SMOOTH_TILE*SMOOTH_TILE];
+    }
+    
+#ifdef USE_THREADS
+    Job.Threads=new pthread_t [Job.Thrno];
+    pthread_mutex_init(&Job.Lock, NULL);
+    pthread_cond_init(&Job.Go, NULL);
+    pthread_cond_init(&Job.Done, NULL);
+    Job.Gen=Job.Busy=0; Job.Quit=false;
+    
+    for (t=1; t<Job.Thrno; t++)
+	if (pthread_create(Job.Threads+t, NULL, smooth_thread, Parts+t))
+	    break;  // go on with the ones that could be started
+    for (register unsigned int u=t; u<Job.Thrno; u++)
+	delete [] Parts[u].Scratch;
+    Job.Thrno=t;
+#endif
+    return(Parts);
+}
+// END of smooth_start()
+
+/* smooth_stop(): stops and joins the helper threads of Job
+ * and releases its Parts.
+ */
+static void smooth_stop(Smoothjob_& Job, Smoothpart_ *Parts)
+{
+    register unsigned int t;
+    
+#ifdef USE_THREADS
+    pthread_mutex_lock(&Job.Lock);
+    Job.Quit=true; Job.Gen++;
+    pthread_cond_broadcast(&Job.Go);
+    pthread_mutex_unlock(&Job.Lock);
+    for (t=1; t<Job.Thrno; t++)
+	pthread_join(Job.Threads[t], NULL);
+    
+    pthread_mutex_destroy(&Job.Lock);
+    pthread_cond_destroy(&Job.Go);
+    pthread_cond_destroy(&Job.Done);
+    delete [] Job.Threads;
+#endif
+    for (t=0; t<Job.Thrno; t++) delete [] Parts[t].Scratch;
+    delete [] Parts;
+}
+// END of smooth_stop()
+
+/* smooth_pass(): performs one upper (Job.Lower==false) or lower
+ * (Job.Lower==true) bound smoothing pass over all soft pairs.
+ * The new bounds are put into Job.Newbound, unchanged bounds are 0.0.
+ * The lower triangle is divided into SMOOTH_TILE x SMOOTH_TILE tiles
+ * which are dealt out to the Job.Thrno parts; the calling thread does
+ * the first part, the helpers started by smooth_start() the others.
+ * Return value: the number of bound adjustments, the number of
+ * triangle inequality violations is returned in Violno.
+ */
+static int smooth_pass(Smoothjob_& Job, Smoothpart_ *Parts, int& Violno)
+{
+    register unsigned int t;
+    
+    Job.Newbound->set_values(0.0);
+    for (t=0; t<Job.Thrno; t++) Parts[t].Adjno=Parts[t].Violno=0;
+    
+#ifdef USE_THREADS
+    if (Job.Thrno>1)
+    {
+	pthread_mutex_lock(&Job.Lock);
+	Job.Busy=Job.Thrno-1; Job.Gen++;
+	pthread_cond_broadcast(&Job.Go);
+	pthread_mutex_unlock(&Job.Lock);
+    }
+#endif
+    smooth_tiles(Parts[0]);	// caller's share
+#ifdef USE_THREADS
+    if (Job.Thrno>1)
+    {
+	pthread_mutex_lock(&Job.Lock);
+	while (Job.Busy) pthread_cond_wait(&Job.Done, &Job.Lock);
+	pthread_mutex_unlock(&Job.Lock);
+    }
+#endif
+    
+    int Adjno=0;
+    for (Violno=0, t=0; t<Job.Thrno; t++)
+    {
+	Adjno+=Parts[t].Adjno; Violno+=Parts[t].Violno;
+    }
+    return(Adjno);
+}
+// END of smooth_pass()
+
+/* smooth_tiles(): smooths the soft bounds in every Job->Thrno-th tile
+ * of the lower triangle, starting with the Part.Thridx-th.
+ * The third index k is tiled, too: the bounds of the i and j rows
+ * within a k tile are copied to Part.Scratch by smooth_gather(),
+ * and the running new bounds of the (i,j) tile are kept there as well.
+ * k runs in ascending order for every i:j pair, as in an untiled loop,
+ * so the adjustments are counted the same way. The k==i and k==j
+ * terms need not be skipped, cf. smooth_gather().
+ * Only the "old" bounds in Job->Bounds are read, the new
+ * bounds go to Job->Newbound. Adjustments and violations are
+ * counted in Part.
+ */
+static void smooth_tiles(Smoothpart_& Part)
+{
+    // NOTE: this EPSILON was needed by GCC when compiling with -O2
+    static const double EPSILON=FLT_EPSILON;
+    static const unsigned int T2=SMOOTH_TILE*SMOOTH_TILE;
+    
+    const Smoothjob_& Job=*Part.Job;
+    const Sqmat_& Bounds=*Job.Bounds;
+    const Trimat_& Strict=*Job.Strict;
+    const unsigned int Size=Job.Size, Tiles=(Size+SMOOTH_TILE-1)/SMOOTH_TILE;
+    double *Btile=Part.Scratch,	    // running new bounds of the i:j tile
+	*Uiblk=Btile+T2, *Ujblk=Uiblk+T2, *Liblk=Ujblk+T2, *Ljblk=Liblk+T2;
+    register unsigned int Ib, Jb, Kb, Tidx, i, j, k;
+    unsigned int I0, J0, Imax, Jmax, Jend, Klen;
+    register const double *Ui, *Uj, *Li, *Lj;
+    register double Lnew, Unew, Ltemp, Btemp, Uij;
+    
+    for (Tidx=0, Ib=0; Ib<Tiles; Ib++)
+	for (Jb=0; Jb<=Ib; Jb++, Tidx++)
+	{
+	    if (Tidx%Job.Thrno!=Part.Thridx) continue;	// somebody else's
+	    
+	    I0=Ib*SMOOTH_TILE; Imax=I0+SMOOTH_TILE; if (Imax>Size) Imax=Size;
+	    J0=Jb*SMOOTH_TILE; Jmax=J0+SMOOTH_TILE; if (Jmax>Size) Jmax=Size;
+	    
+	    // start from the old bounds
+	    for (i=I0; i<Imax; i++)
+	    {
+		Jend=(Jmax>i)? i: Jmax;
+		for (j=J0; j<Jend; j++)
+		    Btile[(i-I0)*SMOOTH_TILE+j-J0]=(Job.Lower)? Bounds[i][j]: Bounds[j][i];
+	    }
+	    
+	    for (Kb=0; Kb<Tiles; Kb++)
+	    {
+		Klen=Size-Kb*SMOOTH_TILE; if (Klen>SMOOTH_TILE) Klen=SMOOTH_TILE;
+		smooth_gather(Job, Ib, Kb, false, Uiblk);
+		smooth_gather(Job, Jb, Kb, false, Ujblk);
+		if (Job.Lower)
+		{
+		    smooth_gather(Job, Ib, Kb, true, Liblk);
+		    smooth_gather(Job, Jb, Kb, true, Ljblk);
+		}
+		
+		for (i=I0; i<Imax; i++)
+		{
+		    Jend=(Jmax>i)? i: Jmax;
+		    Ui=Uiblk+(i-I0)*SMOOTH_TILE; Li=Liblk+(i-I0)*SMOOTH_TILE;
+		    for (j=J0; j<Jend; j++)
+		    {
+			if (i-j<=2 || Strict[i][j]>0.0) continue;   // "hard" restraint, no change
+			Uj=Ujblk+(j-J0)*SMOOTH_TILE; Lj=Ljblk+(j-J0)*SMOOTH_TILE;
+			Btemp=Btile[(i-I0)*SMOOTH_TILE+j-J0];
+			
+			if (!Job.Lower)	// upper limits
+			{
+			    for (k=0; k<Klen; k++)
+			    {
+				Unew=Ui[k]+Uj[k];
+				
+				// upper limit can be narrowed
+				if (Btemp>Unew+EPSILON)
+				{
+				    Btemp=Unew; ++Part.Adjno;
+				}
+			    }	// for k
+			}
+			else	// lower limits
+			{
+			    Uij=Bounds[j][i];
+			    for (k=0; k<Klen; k++)
+			    {
+				Lnew=Li[k]-Uj[k];
+				Ltemp=Lj[k]-Ui[k];
+				if (Ltemp>Lnew) Lnew=Ltemp;
+				if (Uij<Lnew)
+				{
+				    Part.Violno++; continue; // inequality violation :-(
+				}
+				
+				// lower limit can be narrowed
+				if (Btemp<Lnew-EPSILON) { Btemp=Lnew; ++Part.Adjno; }
+			    }	// for k
+			}
+			Btile[(i-I0)*SMOOTH_TILE+j-J0]=Btemp;
+		    }	    // for j
+		}	// for i
+	    }	    // for Kb
+	    
+	    // keep the bounds that have changed
+	    for (i=I0; i<Imax; i++)
+	    {
+		Jend=(Jmax>i)? i: Jmax;
+		for (j=J0; j<Jend; j++)
+		{
+		    if (i-j<=2 || Strict[i][j]>0.0) continue;
+		    Btemp=Btile[(i-I0)*SMOOTH_TILE+j-J0];
+		    if (!Job.Lower)
+		    {
+			if (Btemp<Bounds[j][i]-EPSILON) (*Job.Newbound)[i][j]=Btemp;
+		    }
+		    else if (Btemp>Bounds[i][j]+EPSILON) (*Job.Newbound)[i][j]=Btemp;
+		}
+	    }
+	}	// for Jb
+}
+// END of smooth_tiles()
+
+/* smooth_gather(): copies the upper (Lower==false) or lower (Lower==true)
+ * bounds between the points of the Ib-th and Kb-th tiles from
+ * Job.Bounds to Blk, so that Blk[(i-I0)*SMOOTH_TILE+k-K0] is the
+ * i:k bound (I0, K0 being the first indices of the tiles). The upper
+ * bounds of a row partly lie in a column of the restraint matrix,
+ * this is why they are copied. The i:i entries are DBL_MAX (upper)
+ * or -DBL_MAX (lower) so that the triangles with a degenerate side
+ * can neither narrow a bound nor be counted as violations.
+ */
+static void smooth_gather(const Smoothjob_& Job, unsigned int Ib, unsigned int Kb,
+	bool Lower, double *Blk)
+{
+    const Sqmat_& Bounds=*Job.Bounds;
+    const unsigned int I0=Ib*SMOOTH_TILE, K0=Kb*SMOOTH_TILE;
+    const double Diag=(Lower)? -DBL_MAX: DBL_MAX;
+    unsigned int Imax=I0+SMOOTH_TILE, Kmax=K0+SMOOTH_TILE;
+    register unsigned int i, k;
+    register const double *Row;
+    register double *B;
+    
+    if (Imax>Job.Size) Imax=Job.Size;
+    if (Kmax>Job.Size) Kmax=Job.Size;
+    for (i=I0; i<Imax; i++)
+    {
+	B=Blk+(i-I0)*SMOOTH_TILE; Row=Bounds[i];
+	for (k=K0; k<Kmax; k++)
+	    B[k-K0]=(k==i)? Diag: ((k<i)==Lower)? Row[k]: Bounds[k][i];
+    }
+}
+// END of smooth_gather()
+
+#ifdef USE_THREADS
+/* smooth_thread(): the start function of the bound smoothing helper
+ * threads, Part points to a Smoothpart_ structure. Does its part
+ * of every pass posted by smooth_pass() until smooth_stop() is called.
+ */
+void *smooth_thread(void *Part)
+{
+    Smoothpart_ *Sp=(Smoothpart_*)Part;
+    Smoothjob_ *Job=Sp->Job;
+    unsigned int Gen=0;
+    bool Quit;
+    
+    while (1)
+    {
+	pthread_mutex_lock(&Job->Lock);
+	while (Job->Gen==Gen) pthread_cond_wait(&Job->Go, &Job->Lock);
+	Gen=Job->Gen; Quit=Job->Quit;
+	pthread_mutex_unlock(&Job->Lock);
+	if (Quit) break;
+	
+	smooth_tiles(*Sp);
+	
+	pthread_mutex_lock(&Job->Lock);
+	if (!--Job->Busy) pthread_cond_signal(&Job->Done);
+	pthread_mutex_unlock(&Job->Lock);
+    }
+    return(NULL);
+}
+// END of smooth_thread()
+#endif
+
 // ---- Distance matrix initialisation ----
 
 /* init_distmat(): produces a random (squared) distance matrix with entries from a
  * Gaussian distribution. The average and S.D is calculated from the
  * expected radius of the molecule, assuming a spherical shape.
- * The random number generator is initialised with
- * Randseed. Only random numbers falling between the distance bounds
- * are accepted. "Softly" restrained positions are modified by the
- * hydrophobic distance estimates.
+ * The random numbers come from the counter-based stream
+ * keyed on Randseed, the run number Run and the stream ID Stream
+ * (default 0), so a given run always gets the same matrix no matter
+ * where and when it is performed. Only random numbers falling
+ * between the distance bounds are accepted. "Softly" restrained
+ * positions are modified by the hydrophobic distance estimates.
  */
 void Restraints_::init_distmat(Trimat_& Dist, Polymer_& Polymer, 
-	long Randseed) const
+	long Randseed, unsigned int Run, unsigned int Stream) const
 {
     register unsigned int i, j, Ptno=Dist.rno();
     
@@ -610,7 +985,8 @@ void Restraints_::init_distmat(Trimat_& Dist, Polymer_& Polymer,
     Rexp=exp_rad(Ptno-2);
     Avgdist=36.0*Rexp/35.0; Dev=sqrt(1.2)*Rexp;
 
-    init_portrand(Randseed);     /* init RNG */
+    Ctrrand_ Rng;
+    init_ctrrand(&Rng, Randseed, Run, Stream);	// private RNG stream
     for (i=0; i<Ptno; i++)
     {
 	for (j=0; j<=i; j++)
@@ -635,16 +1011,15 @@ void Restraints_::init_distmat(Trimat_& Dist, Polymer_& Polymer,
 	     * within a protein of the same size. If this doesn't work, 
 	     * use a simple uniform distribution.
 	     */
-	    Drand=portrandom_gauss();   // zero mean, unit variance
+	    Drand=ctrrandom_gauss(&Rng);   // zero mean, unit variance
 	    Drand=(Drand*Dev)+Avgdist;	// prescribed mean & variance
 	    if (Drand<Low || Drand>Up)
-		Drand=(Up-Low)*port_random()+Low;  // uniform
+		Drand=(Up-Low)*ctr_random(&Rng)+Low;  // uniform
 
 	    // adjust with hydrophobic estimate if "soft", skip N-, C-termini
-	    if (i>0 && i<Ptno-1 && j>0 && !hard(i, j))
+	    if (i>0 && i<Ptno-1 && j>0 && !hard(i, j)
+		&& (Destim=Polymer.estim_dist(i-1, j-1))>=0.0)  // hydrophobic estimate, <0.0 on error
 	    {
-		Destim=Polymer.estim_dist(i-1, j-1);  // hydrophobic estimate
-		if (Destim<0.0) continue;   // error?
 		if (Destim>Up) Destim=0.95*Up;	// bracket if necessary
 		if (Destim<Low) Destim=1.05*Low;
 		Strict=strict(i, j)*Polymer.cons(i-1)*Polymer.cons(j-1); // strictness from conservation
@@ -712,7 +1087,7 @@ ostream& operator<<(ostream& Out, const Restraints_& D)
     if (!(D.Restrs)) Out<<"# <no external restraints>\n";
     else
     {
-	Clist1_<Restr_> Rl=D.ext_restr(); // const access
+	Cvlist_<Restr_> Rl=D.ext_restr(); // const access
 	for (Rl.begin(); Rl!=NULL; Rl++) Out<<(*Rl);
     }
     return(Out);
@@ -841,20 +1216,27 @@ istream& operator>>(istream& Inf, Restraints_& Restraints)
  * clear the restraint list.
  * Return value: the number of restraints processed.
  */
-int Restraints_::add_restrs(const List1_<Restr_>& Rs)
+int Restraints_::add_restrs(const Vlist_<Restr_>& Rs)
 {
-    Clist1_<Restr_> Ra(Rs); // const iterator
-    List1_<Restr_> Rnew;    // put "new" restraints here
+    static const String_ CA("CA"), SCC("SCC");
+    Cvlist_<Restr_> Ra(Rs); // const iterator
+    Vlist_<Restr_> Rnew;    // put "new" restraints here
+    Restrhash_ Rhash;
     
     int Rsno=0;
     
+    // index the old restraints only, the new ones are not merged
+    rhash_init(Rhash, Restrs.len());
+    for (Restrs.begin(); Restrs!=NULL; Restrs++)
+	rhash_add(Rhash, &(*Restrs));
+    
     for (Ra.begin(); Ra!=NULL; Ra++)
     {
 	// pass CA/SCC restraints straight on
-	if ((Ra->atom(1)==String_("CA") || Ra->atom(1)==String_("SCC")) &&
-	    (Ra->atom(2)==String_("CA") || Ra->atom(2)==String_("SCC")))
+	if ((Ra->atom(1)==CA || Ra->atom(1)==SCC) &&
+	    (Ra->atom(2)==CA || Ra->atom(2)==SCC))
 	{
-	    if (!absorb_restraint(Restrs, *Ra)) 
+	    if (!absorb_restraint(Rhash, *Ra)) 
 		Rnew+=(*Ra);    // save on "new list" (could not be absorbed)
 	}
 	else
@@ -864,6 +1246,7 @@ int Restraints_::add_restrs(const List1_<Restr_>& Rs)
 	}
 	Rsno++;
     }
+    delete [] Rhash.Slots;
     Restrs+=Rnew;   // append new list to original
     return(Rsno);
 }
@@ -875,19 +1258,22 @@ int Restraints_::add_restrs(const List1_<Restr_>& Rs)
  * (which will contain CA/SCC restraints only). If there was a
  * restraint between the atoms of R, then it is "absorbed" into
  * Restrs (see absorb_restrain()). If R is the first restraint between its atoms, 
- * then it is simply appended to Restrs. Private
+ * then it is simply appended to Restrs and to the index Rhash. Private
  */
 inline
-void Restraints_::add_restraint(const Restr_& R)
+void Restraints_::add_restraint(const Restr_& R, Restrhash_& Rhash)
 {
-    if (!absorb_restraint(Restrs, R))
+    if (!absorb_restraint(Rhash, R))
+    {
 	Restrs+=R;	// first restraint between these atoms, append to list
-    Restrs.end();
+	Restrs.end();
+	rhash_add(Rhash, &(*Restrs));
+    }
 }
 // END of add_restraint()
 
 /* absorb_restraint(): check if the restraint R is between
- * the same CA/SCC atoms as one of the restraints in the list Rlist.
+ * the same CA/SCC atoms as one of the restraints indexed in Rhash.
  * If this is the case, then the range of that restraint is 
  * modified: the restraint range is narrowed if R is stricter and either its
  * Lowlim is higher or Uplim is lower than that of the previous restraint
@@ -895,35 +1281,108 @@ void Restraints_::add_restraint(const Restr_& R)
  * Otherwise no action is taken.
  * Return value: 1 if R could be "absorbed", 0 if not. Static private
  */
-int Restraints_::absorb_restraint(List1_<Restr_>& Rlist, const Restr_& R)
+int Restraints_::absorb_restraint(const Restrhash_& Rhash, const Restr_& R)
+{
+    unsigned int E1, E2;
+    if (!rhash_ends(R, E1, E2)) return(0);
+    
+    Restr_ *Rp=rhash_slot(Rhash, E1, E2)->Rp;	// same atoms as R
+    if (Rp==NULL) return(0);
+    
+    // try to narrow restraint range
+    if (Rp->low()<=R.low() && Rp->strict()<=R.strict())
+    {
+	Rp->low(R.low());
+	Rp->strict(R.strict());
+    }
+    if (Rp->up()>=R.up() && Rp->strict()<=R.strict())
+    {
+	Rp->up(R.up());
+	Rp->strict(R.strict());
+    }
+    return(1);	// R is "absorbed" into *Rp
+}
+// END of absorb_restraint()
+
+/* rhash_init(): sets up an empty index for about N restraints. */
+static void rhash_init(Restrhash_& Rhash, unsigned int N)
+{
+    for (Rhash.Size=64; Rhash.Size<2*N; Rhash.Size*=2);
+    Rhash.Slots=new Rhslot_ [Rhash.Size];
+    memset(Rhash.Slots, 0, Rhash.Size*sizeof(Rhslot_));
+    Rhash.No=0;
+}
+// END of rhash_init()
+
+/* rhash_ends(): puts the end codes of R into E1<=E2.
+ * Returns 0 if R is not between CA/SCC atoms (these are not indexed), 1 otherwise.
+ */
+static int rhash_ends(const Restr_& R, unsigned int& E1, unsigned int& E2)
+{
+    static const String_ CA("CA"), SCC("SCC");
+    
+    if (R.atom(1)==CA) E1=2*R.pos(1);
+    else if (R.atom(1)==SCC) E1=2*R.pos(1)+1;
+    else return(0);
+    if (R.atom(2)==CA) E2=2*R.pos(2);
+    else if (R.atom(2)==SCC) E2=2*R.pos(2)+1;
+    else return(0);
+    if (E1>E2) { register unsigned int E=E1; E1=E2; E2=E; }
+    return(1);
+}
+// END of rhash_ends()
+
+/* rhash_slot(): returns the slot of the (E1, E2) key in Rhash
+ * or the empty slot where it should go (linear probing).
+ */
+static Rhslot_ *rhash_slot(const Restrhash_& Rhash, unsigned int E1, unsigned int E2)
 {
-    for (Rlist.begin(); Rlist!=NULL; Rlist++)
+    register unsigned int h=E1*2654435761U+E2;
+    register Rhslot_ *Sl;
+    
+    h^=h>>15; h*=2246822519U; h^=h>>13;
+    for (h&=Rhash.Size-1; ; h=(h+1)&(Rhash.Size-1))
+    {
+	Sl=Rhash.Slots+h;
+	if (Sl->Rp==NULL || Sl->E1==E1 && Sl->E2==E2)
+	    return(Sl);
+    }
+}
+// END of rhash_slot()
+
+/* rhash_add(): indexes the restraint pointed to by Rp in Rhash
+ * unless there is one between the same atoms already (the first
+ * one will absorb the rest, as in a list scan). The table is
+ * kept at most half full.
+ */
+static void rhash_add(Restrhash_& Rhash, Restr_ *Rp)
+{
+    unsigned int E1, E2, i;
+    if (!rhash_ends(*Rp, E1, E2)) return;
+    
+    if (2*(Rhash.No+1)>Rhash.Size)	// grow and rehash
     {
-	// is *Rlist between the same atoms as R?
-	if (Rlist->pos(1)==R.pos(1) && Rlist->pos(2)==R.pos(2) &&	// X:Y == X:Y 
-	    Rlist->atom(1)==R.atom(1) && Rlist->atom(2)==R.atom(2)
-	    ||
-	    Rlist->pos(1)==R.pos(2) && Rlist->pos(2)==R.pos(1) &&	// X:Y == Y:X 
-	    Rlist->atom(1)==R.atom(2) && Rlist->atom(2)==R.atom(1))
+	Rhslot_ *Old=Rhash.Slots, *Sl;
+	unsigned int Oldsize=Rhash.Size;
+	
+	Rhash.Size*=2;
+	Rhash.Slots=new Rhslot_ [Rhash.Size];
+	memset(Rhash.Slots, 0, Rhash.Size*sizeof(Rhslot_));
+	for (i=0; i<Oldsize; i++)
 	{
-	    // try to narrow restraint range
-	    if (Rlist->low()<=R.low() && Rlist->strict()<=R.strict())
-	    {
-		Rlist->low(R.low());
-		Rlist->strict(R.strict());
-	    }
-	    if (Rlist->up()>=R.up() && Rlist->strict()<=R.strict())
-	    {
-		Rlist->up(R.up());
-		Rlist->strict(R.strict());
-	    }
-	    
-	    return(1);	// R is "absorbed" into *Rlist
+	    if (Old[i].Rp==NULL) continue;
+	    Sl=rhash_slot(Rhash, Old[i].E1, Old[i].E2);
+	    *Sl=Old[i];
 	}
+	delete [] Old;
     }
-    return(0);
+    
+    Rhslot_ *Sl=rhash_slot(Rhash, E1, E2);
+    if (Sl->Rp!=NULL) return;	// already there
+    Sl->Rp=Rp; Sl->E1=E1; Sl->E2=E2;
+    Rhash.No++;
 }
-// END of absorb_restraint()
+// END of rhash_add()
 
 /* convert_restraints(): converts the restraints in the internal restraint list
  * which may have been specified between side-chain atoms, into
@@ -940,8 +1399,17 @@ void Restraints_::convert_restraints(const Polymer_& Polymer)
      * in the calling object is deep-copied to Ra and cleared;
      * Ra's items are then processed back into the internal list.
      */
-    List1_<Restr_> Ra(Restrs);	// copy list into Ra
+    static const String_ CA("CA"), SCC("SCC");
+    Vlist_<Restr_> Ra(Restrs);	// copy list into Ra
+    Restrhash_ Rhash;	// index of the new list for merging
+    
     Restrs.clear();	// clear previous restraints
+    rhash_init(Rhash, 4*Ra.len());
+
+    /* Rhash points into Restrs: make room for the max. 4 restraints
+     * per item in Ra so that appending never moves the list
+     */
+    Restrs.reserve(4*Ra.len());
     
     // scan all restraints
     for (Ra.begin(); Ra!=NULL; Ra++)
@@ -953,10 +1421,10 @@ void Restraints_::convert_restraints(const Polymer_& Polymer)
 	    continue;
 
 	// pass CA/SCC restraints straight on
-	if ((Ra->atom(1)==String_("CA") || Ra->atom(1)==String_("SCC")) &&
-	    (Ra->atom(2)==String_("CA") || Ra->atom(2)==String_("SCC")))
+	if ((Ra->atom(1)==CA || Ra->atom(1)==SCC) &&
+	    (Ra->atom(2)==CA || Ra->atom(2)==SCC))
 	{
-	    add_restraint(*Ra);
+	    add_restraint(*Ra, Rhash);
 	    continue;
 	}
 	
@@ -986,26 +1454,27 @@ void Restraints_::convert_restraints(const Polymer_& Polymer)
 	R.atom(1, "CA"); R.atom(2, "CA");
 	R.low(Ra->low()-(Cad1+Cad2));
 	R.up(Ra->up()+Cad1+Cad2);
-	add_restraint(R);
+	add_restraint(R, Rhash);
 	
 	// make a CA:SCC restraint
 	R.atom(2, "SCC");
 	R.low(Ra->low()-(Cad1+Sccd2));
 	R.up(Ra->up()+Cad1+Sccd2);
-	add_restraint(R);
+	add_restraint(R, Rhash);
 	
 	// make a SCC:CA restraint
 	R.atom(1, "SCC"); R.atom(2, "CA");
 	R.low(Ra->low()-(Sccd1+Cad2));
 	R.up(Ra->up()+Sccd1+Cad2);
-	add_restraint(R);
+	add_restraint(R, Rhash);
 	
 	// make a SCC:SCC restraint
 	R.atom(2, "SCC");
 	R.low(Ra->low()-(Sccd1+Sccd2));
 	R.up(Ra->up()+Sccd1+Sccd2);
-	add_restraint(R);
+	add_restraint(R, Rhash);
     }
+    delete [] Rhash.Slots;
 }
 // END of convert_restraints()
 
@@ -20,7 +20,7 @@
 
 #include "Sqmat.h"
 #include "Trimat.h"
-#include "List1.h"
+#include "Vlist.h"
 #include "Polymer.h"
 #include "Pieces.h"
 
@@ -34,6 +34,8 @@
 
 // ==== CLASSES ====
 
+struct Restrhash_;	// restraint index for merging, see Restr.c++
+
 /* Class Restr_: holds the external distance restraints. 
  * Can be asked to return the non-squared or squared restraint
  * between two atoms in two residues with a strictness value.
@@ -132,10 +134,28 @@ class Restr_
  */
 class Restraints_
 {
+    public:
+    
+    /* The external restraints left in the list after setup_restr()
+     * (i.e. the ones which are not between two C-alphas) are also
+     * "compiled" into an array of Extrestr_ items for the steric checks.
+     * The atoms are coded by Type as below, Pos1, Pos2 and the limits
+     * are the same as in the corresponding Restr_ object.
+     */
+    enum Exttype_ {CA_SCC, SCC_CA, SCC_SCC};
+    struct Extrestr_
+    {
+	unsigned int Pos1, Pos2;    // positions [1..Rno]
+	Exttype_ Type;	    // which atoms
+	float Low, Up, Low2, Up2, Strict;   // limits and strictness
+    };
+    
     // data
     private:
     
-    List1_<Restr_> Restrs;  // external distance restraints
+    Vlist_<Restr_> Restrs;  // external distance restraints
+    Array_<Extrestr_> Ext;  // the same compiled (see above)
+    Array_<unsigned int> Extin, Extbetw;  // indices of the Ext items within and between clusters
     Sqmat_ Lowup, Lowup2;   // unsquared (lower triangle) and squared (upper triangle) restraint limits
     Trimat_ Strict;	    // strictness: 0.0 for non-specific restraints
     Array_<double> Maxsepar;	// maximal residue separation
@@ -161,9 +181,21 @@ class Restraints_
     unsigned int set_size(unsigned int Rno);
     
     // Const access is provided to the external restraint list
-    const List1_<Restr_>& ext_restr() const { return(Restrs); }
+    const Vlist_<Restr_>& ext_restr() const { return(Restrs); }
     unsigned int restr_no() const { return(Restrs.len()); }
     
+    /* Const access to the compiled external restraints (see Extrestr_).
+     * These are valid after setup_restr() only. ext_within() and
+     * ext_between() list the indices of the restraints whose positions
+     * were in the same cluster and in different clusters, respectively,
+     * according to the Pieces object passed to setup_restr(). The
+     * order of the restraints is the same as in ext_restr().
+     */
+    const Extrestr_& ext(unsigned int k) const { return(Ext[k]); }
+    unsigned int ext_no() const { return(Ext.len()); }
+    const Array_<unsigned int>& ext_within() const { return(Extin); }
+    const Array_<unsigned int>& ext_between() const { return(Extbetw); }
+    
     // Const access to the maximal allowable separation
     double max_separ(unsigned int S) const
     {
@@ -222,20 +254,25 @@ class Restraints_
      * according to the list of external restraints (which should already
      * be prepared in the calling object), secondary structure (from Pieces)
      * and intra-monomer atom distances (from Polymer). Call only once
-     * before the simulations.
+     * before the simulations. Also compiles the remaining external
+     * restraints (see ext() above). The bounds are smoothed by Thrno
+     * threads (default 1) if thread support was compiled in.
      */
-    void setup_restr(const Pieces_& Pieces, const Polymer_& Polymer);
+    void setup_restr(const Pieces_& Pieces, const Polymer_& Polymer,
+	    unsigned int Thrno=1);
     
     /* init_distmat(): produces a random (squared) distance matrix with entries from a
      * Gaussian distribution. The average and S.D is calculated from the
      * expected radius of the molecule, assuming a spherical shape.
-     * The random number generator is initialised with
-     * Randseed. Only random numbers falling between the distance bounds
-     * are accepted. "Softly" restrained positions are modified by the
-     * hydrophobic distance estimates.
+     * The random numbers come from the counter-based stream
+     * keyed on Randseed, the run number Run and the stream ID Stream
+     * (default 0), so a given run always gets the same matrix no matter
+     * where and when it is performed. Only random numbers falling
+     * between the distance bounds are accepted. "Softly" restrained
+     * positions are modified by the hydrophobic distance estimates.
      */
     void init_distmat(Trimat_& Dist, Polymer_& Polymer, 
-	    long Randseed) const;
+	    long Randseed, unsigned int Run, unsigned int Stream=0) const;
     
     /* exp_rad(): returns the expected radius for an Rno-long
      * chain with a density Dens.
@@ -284,7 +321,7 @@ class Restraints_
      * clear the restraint list.
      * Return value: the number of restraints processed.
      */
-    int add_restrs(const List1_<Restr_>& Rs);
+    int add_restrs(const Vlist_<Restr_>& Rs);
     
     /* convert_restraints(): converts the restraints in the internal restraint list
      * which may have been specified between side-chain atoms, into
@@ -303,12 +340,13 @@ class Restraints_
     void setup_bondbump();
     void setup_extrestr(const Polymer_& Polymer);
     void setup_secstrestr(const Pieces_& Pieces);
-    int smooth_restr(unsigned int Pass=1);
+    void compile_extrestr(const Pieces_& Pieces);
+    int smooth_restr(unsigned int Pass=1, unsigned int Thrno=1);
     void flory_constr();
     static int get_cascc(const Polymer_& Polymer, unsigned int Pos, 
 	const String_& Atom, float& Cad, float& Sccd);
-    static int absorb_restraint(List1_<Restr_>& Rlist, const Restr_& R);
-    void add_restraint(const Restr_& R);
+    static int absorb_restraint(const Restrhash_& Rhash, const Restr_& R);
+    void add_restraint(const Restr_& R, Restrhash_& Rhash);
     
     // static members
     public:
@@ -0,0 +1,626 @@
+// ==== PROJECT DRAGON: METHODS Runpool.c++ ====
+
+/* Worker thread pool for in-process parallel simulation runs. */
+
+// ---- MODULE HEADER ----
+
+#include "Runpool.h"
+
+// ---- MODULE HEADERS ----
+
+#include "Sigproc.h"
+
+// ---- STANDARD HEADERS ----
+
+#include <string.h>
+#include <errno.h>
+
+#ifdef USE_THREADS
+
+// ==== LOG REDIRECTION ====
+
+#define THRBUFLEN 512	// size of the put area of the worker streams
+
+struct Thrlog_;
+
+/* Thrbuf_: the stream buffer of an output channel of a worker thread
+ * (Chan==0: output, 1: errors). The characters are collected in a small
+ * put area which is passed on to the logfile of the thread or to the
+ * run buffers of its Thrlog_ record when it is full or the stream
+ * is flushed. Only the owner thread may write to it.
+ */
+class Thrbuf_: public streambuf
+{
+    // data
+    private:
+
+    Thrlog_& Tlog;	// the output state this buffer belongs to
+    unsigned int Chan;	// buffer index in Thrlog_
+    char Area[THRBUFLEN];   // the put area
+
+    // methods
+    public:
+
+    Thrbuf_(Thrlog_& Tl, unsigned int Ch): Tlog(Tl), Chan(Ch)
+	{ setp(Area, Area+THRBUFLEN); }
+
+    protected:
+
+    int overflow(int Ch);
+    int sync();
+
+    private:
+
+    int drain();
+
+    // forbidden methods
+    Thrbuf_(const Thrbuf_&);
+    Thrbuf_& operator=(const Thrbuf_&);
+};
+// END OF CLASS Thrbuf_
+
+/* Thrlog_: the output state of a worker thread, kept as
+ * thread-specific data. Out and Err are the streams of the thread
+ * (see Runpool_::out(), err()), Err is tied to Out so that
+ * they are not reordered. While the thread has no logfile, its
+ * output is collected in the run buffers and is written to the original
+ * streams in one piece by Runpool_::close_log() at the end of the run,
+ * so that the reports of the runs are not interleaved.
+ */
+struct Thrlog_
+{
+    ofstream *Log;	// the logfile of the current run or NULL
+    char *Buf[2];	// buffered output [0] and error [1] text...
+    unsigned int Len[2], Cap[2];    // ...its length and capacity
+    Thrbuf_ Outbuf, Errbuf;	// the stream buffers...
+    ostream Out, Err;	// ...and the streams of the thread
+    
+    Thrlog_(): Log(NULL), Outbuf(*this, 0), Errbuf(*this, 1),
+	Out(&Outbuf), Err(&Errbuf)
+    {
+	Buf[0]=Buf[1]=NULL;
+	Len[0]=Len[1]=Cap[0]=Cap[1]=0;
+	Err.tie(&Out);
+    }
+    ~Thrlog_() { delete Log; delete [] Buf[0]; delete [] Buf[1]; }
+    
+    void append(unsigned int Chan, const char *Str, unsigned int N);
+};
+// END OF STRUCT Thrlog_
+
+/* Thrlogbuf_: a stream buffer which is installed in cout (Chan==0)
+ * and cerr (Chan==1) while the pool is running. It has no put area
+ * of its own: the characters written by a worker thread are passed
+ * on to the stream buffers of that thread, those of the main thread
+ * go to the original stream buffer. Strings are passed on
+ * in one piece by xsputn().
+ */
+class Thrlogbuf_: public streambuf
+{
+    // data
+    private:
+
+    streambuf *Orig;   // the original buffer (main thread's destination)
+    unsigned int Chan;	// output channel
+
+    // methods
+    public:
+
+    Thrlogbuf_(streambuf *Origbuf, unsigned int Ch):
+	Orig(Origbuf), Chan(Ch) { setp(NULL, NULL); }
+
+    protected:
+
+    int overflow(int Ch);
+    streamsize xsputn(const char *Str, streamsize N);
+    int sync();
+
+    private:
+
+    streambuf *dest() const;
+};
+// END OF CLASS Thrlogbuf_
+
+// ---- Static variables ----
+
+static pthread_key_t Logkey;	// thread-specific Thrlog_ ptr
+static pthread_once_t Logkeyonce=PTHREAD_ONCE_INIT;
+
+static void make_logkey()
+{
+    pthread_key_create(&Logkey, NULL);
+}
+
+// ---- Thrlog_ methods ----
+
+/* append(): appends N characters from Str to the Chan-th buffer,
+ * which grows as needed.
+ */
+void Thrlog_::append(unsigned int Chan, const char *Str, unsigned int N)
+{
+    if (Len[Chan]+N>Cap[Chan])
+    {
+	unsigned int Newcap=(Cap[Chan]? 2*Cap[Chan]: 1024);
+	while (Newcap<Len[Chan]+N) Newcap*=2;
+	char *Newbuf=new char [Newcap];
+	if (Len[Chan]) memcpy(Newbuf, Buf[Chan], Len[Chan]);
+	delete [] Buf[Chan];
+	Buf[Chan]=Newbuf; Cap[Chan]=Newcap;
+    }
+    memcpy(Buf[Chan]+Len[Chan], Str, N);
+    Len[Chan]+=N;
+}
+// END of append()
+
+// ---- Thrbuf_ methods ----
+
+/* overflow(): empties the put area and stores Ch in it.
+ * Returns EOF on error.
+ */
+int Thrbuf_::overflow(int Ch)
+{
+    if (drain()) return(EOF);
+    if (Ch==EOF) return(0);
+    *pptr()=char(Ch); pbump(1);
+    return(Ch);
+}
+
+/* sync(): empties the put area and flushes the logfile if there is one. */
+int Thrbuf_::sync()
+{
+    if (drain()) return(EOF);
+    if (Tlog.Log!=NULL && !Tlog.Log->flush()) return(EOF);
+    return(0);
+}
+
+/* drain(): passes on the contents of the put area to the logfile
+ * or to the run buffer. Returns EOF if the logfile could not be written,
+ * 0 otherwise. Private
+ */
+int Thrbuf_::drain()
+{
+    int Len=pptr()-pbase();
+    
+    if (Len<=0) return(0);
+    setp(Area, Area+THRBUFLEN);
+    if (Tlog.Log==NULL)
+    {
+	Tlog.append(Chan, Area, Len);	// keep until close_log()
+	return(0);
+    }
+    Tlog.Log->write(Area, Len);
+    return(Tlog.Log->good()? 0: EOF);
+}
+
+// ---- Thrlogbuf_ methods ----
+
+/* overflow(), xsputn(): pass on the character Ch or the N characters
+ * in Str to the destination of the calling thread. Return EOF
+ * or the number of characters written, respectively.
+ */
+int Thrlogbuf_::overflow(int Ch)
+{
+    if (Ch==EOF) return(0);
+    return(dest()->sputc(char(Ch)));
+}
+
+streamsize Thrlogbuf_::xsputn(const char *Str, streamsize N)
+{
+    return(dest()->sputn(Str, N));
+}
+
+/* sync(): flushes the destination of the calling thread.
+ * Buffered worker output is not written here, see Runpool_::close_log().
+ */
+int Thrlogbuf_::sync()
+{
+    return(dest()->pubsync());
+}
+
+/* dest(): returns the stream buffer of the Chan channel of
+ * the calling worker thread or the original buffer. Private
+ */
+streambuf *Thrlogbuf_::dest() const
+{
+    Thrlog_ *Tl=(Thrlog_*)pthread_getspecific(Logkey);
+    if (Tl==NULL) return(Orig);
+    return(Chan? (streambuf*)&(Tl->Errbuf): (streambuf*)&(Tl->Outbuf));
+}
+// END of Thrlogbuf_ methods
+
+// ==== THREAD FUNCTIONS ====
+
+/* Thrarg_: the argument of a worker thread. */
+struct Thrarg_
+{
+    Runpool_ *Pool;
+    unsigned int Thridx;
+};
+
+/* pool_watcher(): the signal watcher thread. Waits for the
+ * non-fatal signals which are blocked in all other threads
+ * and stops the pool when one of them arrives.
+ * Runs until cancelled by run_all().
+ */
+void *pool_watcher(void *Pool)
+{
+    Runpool_ *Pp=(Runpool_*)Pool;
+    int Sig;
+
+    while (1)
+    {
+	if (sigwait(&(Pp->Sigset), &Sig)) continue;
+	Pp->stop(Sig);
+    }
+    return(NULL);
+}
+// END of pool_watcher()
+
+/* pool_worker(): the start function of the worker threads.
+ * Sets up the output state of the thread and
+ * calls the worker function of the pool with the thread index.
+ * Exceptions must not escape from a thread: if the worker did
+ * not catch a signal exception, it stops the whole pool here.
+ */
+void *pool_worker(void *Thrarg)
+{
+    Thrarg_ *Ta=(Thrarg_*)Thrarg;
+    Runpool_ *Pp=Ta->Pool;
+    Thrlog_ Tlog;
+
+    // the streams of the thread start with the format of cout, cerr
+    Tlog.Out.flags(Pp->Origflags[0]); Tlog.Err.flags(Pp->Origflags[1]);
+    Tlog.Out.precision(Pp->Origprec[0]); Tlog.Err.precision(Pp->Origprec[1]);
+    Tlog.Out.fill(Pp->Origfill[0]); Tlog.Err.fill(Pp->Origfill[1]);
+    pthread_setspecific(Logkey, &Tlog);
+    try
+    {
+	Pp->Worker(*Pp, Ta->Thridx, Pp->Workarg);
+    }
+    catch(Sigexcept_ Sigexc)
+    {
+	Pp->stop(Sigexc.sigval());
+    }
+    Pp->close_log();	// in case the worker left it open
+    pthread_setspecific(Logkey, NULL);
+    return(NULL);
+}
+// END of pool_worker()
+
+#endif	/* USE_THREADS */
+
+// ==== Runpool_ METHODS ====
+
+// ---- Constructor, destructor ----
+
+/* Sets up the object to manage Thrno worker threads. If Thrno==0
+ * (the default), then no threads will be used.
+ */
+Runpool_::Runpool_(int Thrno):
+	Maxthrno(0), Nextrun(0), Lastrun(0), Stopsig(0),
+	Worker(NULL), Workarg(NULL)
+{
+    #ifdef USE_THREADS
+	pthread_mutex_init(&Runlock, NULL);
+	pthread_mutex_init(&Biglock, NULL);
+	Origbuf[0]=Origbuf[1]=NULL;
+
+	// the non-fatal signals are caught by the watcher thread
+	sigemptyset(&Sigset);
+	sigaddset(&Sigset, SIGHUP);
+	sigaddset(&Sigset, SIGINT);
+	sigaddset(&Sigset, SIGQUIT);
+	sigaddset(&Sigset, SIGPIPE);
+	sigaddset(&Sigset, SIGALRM);
+	sigaddset(&Sigset, SIGTERM);
+
+	pthread_once(&Logkeyonce, make_logkey);
+    #endif
+    set_maxthrno(Thrno);
+}
+
+Runpool_::~Runpool_()
+{
+    #ifdef USE_THREADS
+	pthread_mutex_destroy(&Runlock);
+	pthread_mutex_destroy(&Biglock);
+    #endif
+}
+
+// ---- Access ----
+
+/* set_maxthrno(): sets the maximal number of worker threads
+ * to abs(Thrno). If Thrno==0 or thread support was not compiled in,
+ * then threading is disabled. Return value: the maximal number
+ * of worker threads.
+ */
+int Runpool_::set_maxthrno(int Thrno)
+{
+    #ifdef USE_THREADS
+	Maxthrno=abs(Thrno);
+    #else
+	if (Thrno)
+	    cerr<<"\n? Runpool_::set_maxthrno(): No thread support, "
+		<<"running serially\n";
+	Maxthrno=0;
+    #endif
+    return(Maxthrno);
+}
+// END of set_maxthrno()
+
+// ---- Running ----
+
+/* run_all(): starts min(Runno, Maxthrno) worker threads, each of
+ * them invoking Workfn(*this, Thridx, Arg). Waits until all workers
+ * have returned. Non-fatal signals caught in the meantime are
+ * passed on to the workers (see check_stop()).
+ * Return value: the signal that stopped the pool or 0.
+ */
+int Runpool_::run_all(unsigned int Runno, Worker_ Workfn, void *Arg)
+{
+    if (!Runno) return(0);
+
+    Worker=Workfn; Workarg=Arg;
+    Nextrun=1; Lastrun=Runno; Stopsig=0;
+
+    #ifdef USE_THREADS
+    if (Maxthrno)
+    {
+	unsigned int Thrno=(Runno<Maxthrno)? Runno: Maxthrno, Started, t;
+	pthread_t Watcher, *Threads=new pthread_t [Thrno];
+	Thrarg_ *Thrargs=new Thrarg_ [Thrno];
+	sigset_t Oldset;
+	int Err;
+
+	/* Block the non-fatal signals in this thread: the workers
+	 * inherit the mask, so only the watcher will see them
+	 */
+	pthread_sigmask(SIG_BLOCK, &Sigset, &Oldset);
+	Err=pthread_create(&Watcher, NULL, pool_watcher, this);
+	bool Watching=!Err;
+	if (!Watching)
+	    cerr<<"\n? Runpool_::run_all(): Cannot start signal watcher: "
+		<<strerror(Err)<<endl;
+
+	/* All output goes through the thread-dispatching buffers from now on.
+	 * The format of cout and cerr is saved for the worker streams
+	 * (and for checking it at the end)
+	 */
+	cout<<flush; cerr<<flush;
+	Origbuf[0]=cout.rdbuf(); Origbuf[1]=cerr.rdbuf();
+	save_format(cout, 0); save_format(cerr, 1);
+	Thrlogbuf_ Outbuf(Origbuf[0], 0), Errbuf(Origbuf[1], 1);
+	cout.rdbuf(&Outbuf); cerr.rdbuf(&Errbuf);
+
+	// launch the workers
+	for (Started=0; Started<Thrno; Started++)
+	{
+	    Thrargs[Started].Pool=this;
+	    Thrargs[Started].Thridx=Started;
+	    Err=pthread_create(Threads+Started, NULL, pool_worker, Thrargs+Started);
+	    lock();	// the workers may be writing to the original streams
+	    if (Err)
+		cerr<<"\n? Runpool_::run_all(): Cannot start thread #"
+		    <<(Started+1)<<": "<<strerror(Err)<<endl;
+	    else
+		cout<<"THREAD #"<<(Started+1)<<" started\n"<<flush;
+	    unlock();
+	    if (Err) break;
+	}
+
+	// nobody could be started: the calling thread does all the work
+	if (!Started)
+	{
+	    Thrargs[0].Pool=this; Thrargs[0].Thridx=0;
+	    pool_worker(Thrargs);
+	}
+
+	// wait for the workers to finish
+	for (t=0; t<Started; t++)
+	    pthread_join(Threads[t], NULL);
+
+	// restore the streams and the signal mask
+	cout<<flush; cerr<<flush;
+	cout.rdbuf(Origbuf[0]); cerr.rdbuf(Origbuf[1]);
+	if (check_format(cout, 0) || check_format(cerr, 1))
+	    cerr<<"\n? Runpool_::run_all(): The format of cout/cerr "
+		<<"was changed by a worker thread, restored\n";
+	Origbuf[0]=Origbuf[1]=NULL;
+	if (Watching)
+	{
+	    pthread_cancel(Watcher);
+	    pthread_join(Watcher, NULL);
+	}
+	pthread_sigmask(SIG_SETMASK, &Oldset, NULL);
+
+	delete [] Threads; delete [] Thrargs;
+    }
+    else
+    #endif
+	Worker(*this, 0, Workarg);  // serial
+
+    Worker=NULL; Workarg=NULL;
+    return(Stopsig);
+}
+// END of run_all()
+
+/* next_run(): returns the number of the next simulation [1..Runno]
+ * to be performed by the calling worker thread, or 0 if all runs
+ * have been taken or the pool has been stopped by a signal.
+ */
+unsigned int Runpool_::next_run()
+{
+    unsigned int Rcyc=0;
+
+    #ifdef USE_THREADS
+	pthread_mutex_lock(&Runlock);
+    #endif
+    if (!Stopsig && Nextrun<=Lastrun) Rcyc=Nextrun++;
+    #ifdef USE_THREADS
+	pthread_mutex_unlock(&Runlock);
+    #endif
+    return(Rcyc);
+}
+// END of next_run()
+
+/* check_stop(): throws a Sigexcept_ exception with the signal
+ * value if the pool was stopped by a signal, does nothing otherwise.
+ * To be polled by the workers in their main cycle.
+ */
+void Runpool_::check_stop() const
+{
+    if (Stopsig) throw(Sigexcept_(Stopsig));
+}
+
+/* lock(), unlock(): serialise access to code that uses process-global
+ * state. Do nothing if the pool is not running threads.
+ */
+void Runpool_::lock()
+{
+    #ifdef USE_THREADS
+	if (Maxthrno) pthread_mutex_lock(&Biglock);
+    #endif
+}
+
+void Runpool_::unlock()
+{
+    #ifdef USE_THREADS
+	if (Maxthrno) pthread_mutex_unlock(&Biglock);
+    #endif
+}
+// END of lock(), unlock()
+
+/* stop(): stops the pool on signal Sig: the workers will not get new
+ * runs and check_stop() will throw in the running ones. Only the first
+ * signal is recorded. Private
+ */
+void Runpool_::stop(int Sig)
+{
+    #ifdef USE_THREADS
+	pthread_mutex_lock(&Runlock);
+    #endif
+    if (!Stopsig)
+    {
+	signal_message(Sig);
+	Stopsig=Sig;
+    }
+    #ifdef USE_THREADS
+	pthread_mutex_unlock(&Runlock);
+    #endif
+}
+// END of stop()
+
+#ifdef USE_THREADS
+
+/* save_format(): saves the format state of Str (cout if Chan==0,
+ * cerr if Chan==1) at the start of run_all(). Private
+ */
+void Runpool_::save_format(const ostream& Str, unsigned int Chan)
+{
+    Origflags[Chan]=Str.flags(); Origprec[Chan]=Str.precision();
+    Origwidth[Chan]=Str.width(); Origfill[Chan]=Str.fill();
+}
+
+/* check_format(): compares the format state of Str to the one saved
+ * by save_format() at the end of run_all(), and restores it if it
+ * was changed. Return value: 1 if it was changed, 0 otherwise. Private
+ */
+int Runpool_::check_format(ostream& Str, unsigned int Chan)
+{
+    if (Str.flags()==Origflags[Chan] && Str.precision()==Origprec[Chan] &&
+	    Str.width()==Origwidth[Chan] && Str.fill()==Origfill[Chan])
+	return(0);
+    Str.flags(Origflags[Chan]); Str.precision(Origprec[Chan]);
+    Str.width(Origwidth[Chan]); Str.fill(Origfill[Chan]);
+    return(1);
+}
+// END of save_format(), check_format()
+
+#endif	/* USE_THREADS */
+
+// ---- Logging ----
+
+/* out(), err(): return the output and error streams of the
+ * calling worker thread while the pool is running, cout and cerr
+ * otherwise.
+ */
+ostream& Runpool_::out()
+{
+    #ifdef USE_THREADS
+	Thrlog_ *Tl=Maxthrno? (Thrlog_*)pthread_getspecific(Logkey): NULL;
+	if (Tl!=NULL) return(Tl->Out);
+    #endif
+    return(cout);
+}
+
+ostream& Runpool_::err()
+{
+    #ifdef USE_THREADS
+	Thrlog_ *Tl=Maxthrno? (Thrlog_*)pthread_getspecific(Logkey): NULL;
+	if (Tl!=NULL) return(Tl->Err);
+    #endif
+    return(cerr);
+}
+// END of out(), err()
+
+/* open_log(): redirects the output of the calling
+ * worker thread to the file Logname. Output of the other threads
+ * is not affected. Return value: 1 on success, 0 on error.
+ * close_log(): closes the logfile of the calling thread, its output
+ * will be buffered again. The output buffered while the thread
+ * had no logfile is written to the original cout/cerr buffers in one piece,
+ * with the pool locked.
+ */
+int Runpool_::open_log(const char *Logname)
+{
+    #ifdef USE_THREADS
+	if (!Maxthrno) return(0);
+
+	Thrlog_ *Tl=(Thrlog_*)pthread_getspecific(Logkey);
+	if (Tl==NULL) return(0);    // not a worker thread
+
+	close_log();	// close previous if any
+	ofstream *Log=new ofstream(Logname);
+	if (Log==NULL || !(*Log))
+	{
+	    err()<<"\n? Runpool_::open_log(): Cannot open \""<<Logname<<"\"\n";
+	    delete Log;
+	    return(0);
+	}
+	Tl->Log=Log;
+	return(1);
+    #else
+	return(0);
+    #endif
+}
+
+void Runpool_::close_log()
+{
+    #ifdef USE_THREADS
+	if (!Maxthrno) return;
+
+	Thrlog_ *Tl=(Thrlog_*)pthread_getspecific(Logkey);
+	if (Tl==NULL) return;
+	Tl->Out.flush(); Tl->Err.flush();
+	if (Tl->Log!=NULL)
+	{
+	    delete Tl->Log;	// closes the file
+	    Tl->Log=NULL;
+	}
+	
+	// write the buffered output of the run
+	if (!Tl->Len[0] && !Tl->Len[1]) return;
+	lock();
+	for (register unsigned int c=0; c<2; c++)
+	{
+	    if (!Tl->Len[c]) continue;
+	    Origbuf[c]->sputn(Tl->Buf[c], Tl->Len[c]);
+	    Origbuf[c]->pubsync();
+	    Tl->Len[c]=0;
+	}
+	unlock();
+    #endif
+}
+// END of open_log(), close_log()
+
+// ==== END OF METHODS Runpool.c++ ====
@@ -0,0 +1,182 @@
+#ifndef RUNPOOL_CLASS
+#define RUNPOOL_CLASS
+
+// ==== PROJECT DRAGON: HEADER Runpool.h ====
+
+/* Worker thread pool for in-process parallel simulation runs. */
+
+/* NOTES TO DEVELOPERS:-
+ *
+ * 1) Thread support is optional: compile with -DUSE_THREADS and
+ * link with the POSIX threads library (cf. the THRLIB macro in
+ * the bin/Makefile.<ABI> files). Without USE_THREADS, the class
+ * is still available but set_maxthrno() always disables threading,
+ * so the calling code needs no #ifdef-s.
+ *
+ * 2) The worker threads share the global objects of the program
+ * (Params, Polymer etc.): these must be treated as read-only
+ * while the pool is running. Everything that is modified during
+ * a run (distance matrices, coordinates, Steric_ workspaces...)
+ * must be owned by the worker (see the "simulation context" in Dragon.c++).
+ * Calls into code which still relies on process-global state
+ * must be bracketed with lock() and unlock().
+ *
+ * 3) The workers must write their reports through the streams
+ * returned by out() and err(): these are private to the calling
+ * thread, including their format state (width, precision, flags),
+ * and start with the format of cout and cerr at the time run_all()
+ * was called. While the pool is running, the output of the workers
+ * to the global cout and cerr ends up in the same place, but these
+ * objects are shared by all threads: they may be used only
+ * for unformatted messages (strings, integers and characters
+ * without manipulators) and their format state must not be changed.
+ * run_all() warns if it was changed nevertheless.
+ */
+
+// ---- STANDARD HEADERS ----
+
+#include <stdlib.h>
+#include <iostream.h>
+#include <fstream.h>
+#include <signal.h>
+
+#ifdef USE_THREADS
+    #include <pthread.h>
+#endif
+
+// ==== CLASSES ====
+
+/* Runpool_: runs a number of simulations in parallel threads
+ * within the same process. There is no static division of the
+ * runs among the workers: each worker thread asks for the next
+ * run number with next_run() when it has finished the previous one,
+ * so that no thread sits idle while there are runs left.
+ * Non-fatal signals are caught by a dedicated "watcher" thread
+ * which sets a stop flag: the workers poll this flag with check_stop()
+ * which throws a Sigexcept_ exception just like the signal handler
+ * in the "Sigproc" module does in serial runs.
+ * Each worker may redirect its output to a logfile of its own,
+ * otherwise its output is buffered and written out at the end of each run.
+ */
+class Runpool_
+{
+    // types
+    public:
+
+    /* The worker function type. Worker(Pool, Thridx, Arg) will be invoked
+     * once in each worker thread, Thridx is the index of the thread
+     * [0..Thrno-1], Arg is passed on from run_all(). The worker
+     * should process runs until Pool.next_run() returns 0.
+     */
+    typedef void (*Worker_)(Runpool_& Pool, unsigned int Thridx, void *Arg);
+
+    // data
+    private:
+
+    unsigned int Maxthrno;  // max. no. of worker threads (0: no threads)
+    unsigned int Nextrun, Lastrun;  // the shared run counter and its limit
+    volatile int Stopsig;   // the signal which stopped the pool or 0
+    Worker_ Worker;	// the worker function...
+    void *Workarg;	// ...and its argument during run_all()
+
+    #ifdef USE_THREADS
+	pthread_mutex_t Runlock, Biglock;    // run counter and lock()/unlock() mutexes
+	sigset_t Sigset;    // the signals the watcher thread waits for
+	streambuf *Origbuf[2];	// the original cout, cerr buffers during run_all()
+	long Origflags[2];	// format of cout, cerr at the start of run_all()
+	int Origprec[2], Origwidth[2];
+	char Origfill[2];
+    #endif
+
+    // methods
+    public:
+
+	// constructor
+    /* Sets up the object to manage Thrno worker threads. If Thrno==0
+     * (the default), then no threads will be used.
+     */
+    Runpool_(int Thrno=0);
+
+	// destructor
+    ~Runpool_();
+
+	// access
+    /* set_maxthrno(): sets the maximal number of worker threads
+     * to abs(Thrno). If Thrno==0 or thread support was not compiled in,
+     * then threading is disabled. Return value: the maximal number
+     * of worker threads.
+     */
+    int set_maxthrno(int Thrno);
+
+    /* is_threaded(): returns "true" if the pool has been enabled. */
+    bool is_threaded() const { return(Maxthrno>0); }
+    
+    /* max_thrno(): returns the maximal number of worker threads (0 if disabled). */
+    unsigned int max_thrno() const { return(Maxthrno); }
+
+	// running
+    /* run_all(): starts min(Runno, Maxthrno) worker threads, each of
+     * them invoking Workfn(*this, Thridx, Arg). Waits until all workers
+     * have returned. Non-fatal signals caught in the meantime are
+     * passed on to the workers (see check_stop()).
+     * Return value: the signal that stopped the pool or 0.
+     */
+    int run_all(unsigned int Runno, Worker_ Workfn, void *Arg=NULL);
+
+    /* next_run(): returns the number of the next simulation [1..Runno]
+     * to be performed by the calling worker thread, or 0 if all runs
+     * have been taken or the pool has been stopped by a signal.
+     */
+    unsigned int next_run();
+
+    /* check_stop(): throws a Sigexcept_ exception with the signal
+     * value if the pool was stopped by a signal, does nothing otherwise.
+     * To be polled by the workers in their main cycle.
+     */
+    void check_stop() const;
+
+    /* lock(), unlock(): serialise access to code that uses process-global
+     * state. Do nothing if the pool is not running threads.
+     */
+    void lock();
+    void unlock();
+
+	// logging
+    /* out(), err(): return the output and error streams of the
+     * calling worker thread while the pool is running, cout and cerr
+     * otherwise (see note 3 above).
+     */
+    ostream& out();
+    ostream& err();
+
+    /* open_log(): redirects the output of the calling
+     * worker thread to the file Logname. Output of the other threads
+     * is not affected. Return value: 1 on success, 0 on error.
+     * close_log(): closes the logfile of the calling thread, its output
+     * will be buffered again. Call it at the end of each run: the output
+     * buffered while the thread had no logfile is written to the original
+     * cout/cerr buffers in one piece, with the pool locked.
+     */
+    int open_log(const char *Logname);
+    void close_log();
+
+    // private methods
+    private:
+
+    void stop(int Sig);
+
+    #ifdef USE_THREADS
+	void save_format(const ostream& Str, unsigned int Chan);
+	int check_format(ostream& Str, unsigned int Chan);
+	friend void *pool_watcher(void *Pool);
+	friend void *pool_worker(void *Thrarg);
+    #endif
+
+    // forbidden methods
+    Runpool_(const Runpool_&);
+    Runpool_& operator=(const Runpool_&);
+};
+// END OF CLASS Runpool_
+
+// ==== END OF HEADER Runpool.h ====
+#endif	/* RUNPOOL_CLASS */
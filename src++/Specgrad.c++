@@ -13,6 +13,10 @@
 #ifdef __sgi
 #include <ieeefp.h>
 #endif
+#ifdef USE_THREADS
+    #include <pthread.h>
+    #include <signal.h>
+#endif
 #include "Specgrad.h"
 
 /* NOTE: SGI provides single-precision floating point functions
@@ -24,14 +28,76 @@
 #define fabsf fabs
 #endif
 
+// ---- DEFINITIONS ----
+
+/* The points are processed in blocks which contain about SPEC_BLOCK
+ * pair visits each (cf. make_index()). The block boundaries depend
+ * on the weighted pairs only, not on the number of threads.
+ */
+#define SPEC_BLOCK 2048
+
+// ---- TYPES ----
+
+#ifdef USE_THREADS
+/* Sgthrarg_: the argument of a helper thread. */
+struct Sgthrarg_
+{
+    Sgteam_ *Team;
+    unsigned int Thridx;
+    double *Gsum;   // gradient sums of a point, Team->Dim long
+};
+
+/* Sgteam_: the helper threads of Specgrad_::iterate(). The calling
+ * thread posts a stage by incrementing Gen, then all Thrno threads
+ * (the caller being #0) process every Thrno-th block of the points.
+ * The caller waits until Busy drops to 0. Between the iterate()
+ * calls the helpers keep waiting for the next stage.
+ */
+struct Sgteam_
+{
+    Specgrad_ *Sg;
+    const Trimat_ *Id;	// the ideal distances of the current iterate()
+    pthread_t *Threads;
+    Sgthrarg_ *Args;
+    pthread_mutex_t Lock;
+    pthread_cond_t Go, Done;
+    unsigned int Thrno, Gen, Busy;  // no. of threads, stage counter, no. of busy helpers
+    unsigned int Thrreq, Dim;	// no. of threads asked for, max. dimension
+    int Stage;	    // the current stage
+};
+
+void *specgrad_thread(void *Thrarg);
+#endif
+
 // ---- Static initialisation ----
 
 const double Specgrad_::SMALL=sqrt(DBL_MIN)/DBL_EPSILON;	// unsafe to do 1.0/SMALL
 
 // ==== METHODS ====
 
+/* thread_no(): sets the maximal number of threads used by iterate()
+ * to Thrnew (1 if Thrnew==0) and returns the old value. Without thread
+ * support (USE_THREADS not defined) it is always 1.
+ */
+unsigned int Specgrad_::thread_no(unsigned int Thrnew)
+{
+    unsigned int Oldthrno=Thrno;
+    
+#ifdef USE_THREADS
+    Thrno=(Thrnew)? Thrnew: 1;
+#else
+    Thrno=1;
+#endif
+    return(Oldthrno);
+}
+// END of thread_no()
+
 /* weight(): sets up the calling object to work with a given
- * weight matrix W (with entries >=0.0).
+ * weight matrix W (with entries >=0.0). Only the positions of
+ * the non-zero entries of W are stored (and they are rebuilt
+ * only if they differ from the previous ones), the weights
+ * are read from W by iterate(), therefore W must not change
+ * or go away until the next call to weight().
  * Returns the size of the problem.
  */
 int Specgrad_::weight(const Trimat_& W)
@@ -42,9 +108,46 @@ int Specgrad_::weight(const Trimat_& W)
 	cerr<<"\n? Specgrad_::weight(): 0 matrix size\n";
 	return(0);
     }
-    Wgt=W; Wnorm=1.0;
-    Distact.set_size(N); Bmat.set_size(N);
-    Smat.set_size(N);
+    Wmat=&W; Wmul=1.0;
+    
+    // count the weighted pairs and compare them to the stored ones
+    register unsigned int i, j, p;
+    register const double *Row;
+    bool Same=(Rowbeg.len()==N+1 && Colbeg.len()==N+1);
+    for (p=0, i=0; i<N; i++)
+    {
+	Row=W[i];
+	if (Same && Rowbeg[i]!=p) Same=false;
+	for (j=0; j<i; j++)
+	    if (Row[j]!=0.0)
+	    {
+		if (Same && (p>=Rowbeg[N] || Colidx[p]!=j)) Same=false;
+		p++;
+	    }
+    }
+    if (Same && Rowbeg[N]!=p) Same=false;
+    
+    if (!Same)
+    {
+	// store the new pairs row by row
+	Colidx.len(p); Distact.len(p); Bsval.len(p);
+	Rowbeg.len(N+1); Sdiag.len(N); Bdiag.len(N);
+	for (p=0, i=0; i<N; i++)
+	{
+	    Rowbeg[i]=p; Row=W[i];
+	    for (j=0; j<i; j++)
+		if (Row[j]!=0.0) Colidx[p++]=j;
+	}
+	Rowbeg[N]=p;
+	make_index();
+    
+	/* iterate() starts from the stress of the previous coordinates
+	 * (if there were any): the actual distances are made for the new
+	 * pairs. If the pairs are the same, then Distact is still valid.
+	 */
+	if (Cur>=0 && Xt[Cur].len()==N) actual_dist();
+	else Distact.set_values(0.0);
+    }
     make_smat();    // construct the S matrix from the weights
     
     return(N);
@@ -63,6 +166,20 @@ int Specgrad_::weight(const Trimat_& W)
  */
 float Specgrad_::iterate(const Trimat_& Id, Points_& Coords, 
 	int& Itno, float Eps)
+{
+    if (!Coords.dim())
+    {
+	cerr<<"\n? Specgrad_::iterate(): Dim mismatch within point set\n";
+	return(-2.0);
+    }
+    Work.get(Coords);
+    float Stress=iterate(Id, Work, Itno, Eps);
+    Work.put(Coords);
+    return(Stress);
+}
+
+float Specgrad_::iterate(const Trimat_& Id, Coords_& Coords, 
+	int& Itno, float Eps)
 {
     // size checks
     if (Id.rno()<N)
@@ -74,7 +191,7 @@ float Specgrad_::iterate(const Trimat_& Id, Points_& Coords,
     D=Coords.dim();
     if (!D)
     {
-	cerr<<"\n? Specgrad_::iterate(): Dim mismatch within point set\n";
+	cerr<<"\n? Specgrad_::iterate(): Zero dimension\n";
 	return(-2.0);
     }
     if (Coords.active_len()<N)
@@ -83,33 +200,59 @@ float Specgrad_::iterate(const Trimat_& Id, Points_& Coords,
 	    <<Coords.active_len()<<"<"<<N<<")\n";
 	return(-3.0);
     }
+    if (Wmat==NULL || Wmat->rno()!=N)
+    {
+	cerr<<"\n? Specgrad_::iterate(): No weights\n";
+	return(-4.0);
+    }
     Vector_ Ctr=Coords.centroid();
     Coords-=Ctr;
     norm_weights(Id);	// normalise weight matrix
     
-    // set up the internal coordinate matrix and the negative gradient
+    /* set up the coordinate buffers and the negative gradient.
+     * The current coordinates are in Xt[0] at the start, the new
+     * coordinates always go to the buffer which is neither the
+     * current nor the best one, so the best coordinates are kept
+     * without copying. If Coords holds exactly the N points,
+     * then its storage is swapped into Xt[0].
+     */
     register unsigned int i, j;
-    Xt.set_size(N, D); Xtbest.set_size(N, D);
-    Negrad.set_size(N, D); Oldnegrad.set_size(N, D);
-    for (i=0; i<N; i++)
+    register double *Col;
+    bool View=(Coords.len()==N && Coords.active_len()==N);
+    if (View) Xt[0].swap(Coords);
+    else
+    {
+	Xt[0].len_dim(N, D);
 	for (j=0; j<D; j++)
-	    Xt[i][j]=Coords[i][j];
+	{
+	    Col=Xt[0].col(j);
+	    for (i=0; i<N; i++) Col[i]=Coords(i, j);
+	}
+    }
+    Xt[1].len_dim(N, D); Xt[2].len_dim(N, D);
+    int Best=0, Next;
+    Cur=0;
+    Negrad.len_dim(N, D); Oldnegrad.len_dim(N, D);
     
     // perform the iteration
     int Iter, Maxiter=Itno, Bkstep=0, Saveno=0;
-    float Stress=stress(Id), Ostress=0.0, Bestress=Stress, Alpha=1.0;
+    float Stress, Ostress=0.0, Bestress, Alpha=1.0;
     
     // bootstrap
-    actual_dist();	// generate actual distances
-    make_bmat(Id);	// get "B" matrix
-    make_negrad();	// calc negative gradient
+    start_team();
+    run_stage(STRESS, Id);
+    Stress=Bestress=stress();
+    run_stage(STEP, Id);    // actual distances and "B" matrix
+    run_stage(GRAD, Id);    // negative gradient
     Eps=fabsf(Eps);
     
     for (Iter=1; Stress>1e-6 && Iter<=Maxiter && Bkstep<=Maxiter; Iter++)
     {
-	update_coords(Alpha);	// get new coordinates
-	actual_dist();	// generate actual distances
-	Ostress=Stress; Stress=stress(Id);
+	Next=(Cur==Best)? (Cur+1)%3: 3-Cur-Best;    // the free buffer
+	if (update_coords(Alpha, Xt[Next]))    // get new coordinates
+	    Cur=Next;
+	run_stage(STEP, Id);	// generate actual distances and the "B" matrix
+	Ostress=Stress; Stress=stress();
 	if (Stress>=Ostress) { --Iter; ++Bkstep; } // didn't go up: do another step
 	else
 	{
@@ -117,18 +260,17 @@ float Specgrad_::iterate(const Trimat_& Id, Points_& Coords,
 	    if (Stress<Bestress)    // best so far, save
 	    {
 		Bestress=Stress;
-		Xtbest=Xt; Saveno++;
+		Best=Cur; Saveno++;
 	    }
 	    if (fabsf(Stress-Ostress)<=Eps*Ostress)
 		break;	// goes down and is good enough
 	}
-	
-	Oldnegrad=Negrad;
-	make_bmat(Id);
-	make_negrad();	// here is the new gradient
+    
+	Oldnegrad.swap(Negrad);	// Negrad is overwritten anyway
+	run_stage(GRAD, Id);	// here is the new gradient
 	make_alpha(Alpha);  // and the new "stepsize"
     }
-
+    
     // prepare results
     if (!Saveno)
     {
@@ -137,202 +279,447 @@ float Specgrad_::iterate(const Trimat_& Id, Points_& Coords,
 	    <<", Eps="<<Eps<<"): No convergence\n";
 	Itno=-Maxiter;	// negative iterno means failed convergence
     }
-    else
+    else Itno=Iter;	// report back actual no. of iterations
+    
+    /* hand back the best coordinates (the starting ones if there was
+     * no improvement). Xt[Cur] must keep the last coordinates for weight()
+     */
+    if (View)
     {
-	// copy best coordinates back
-	for (i=0; i<N; i++)
-	    for (j=0; j<D; j++)
-		Coords[i][j]=Xtbest[i][j];
-	Itno=Iter;	// report back actual no. of iterations
+	if (Best!=Cur) Coords.swap(Xt[Best]);
+	else Coords=Xt[Best];
     }
+    else
+	for (j=0; j<D; j++)
+	{
+	    Col=Xt[Best].col(j);
+	    for (i=0; i<N; i++) Coords(i, j)=Col[i];
+	}
     Coords+=Ctr;	// shift to original centroid
     return(Bestress);
 }
 // END of iterate()
 
 /* make_smat(): constructs the "S"-matrix from the
- * internal weight matrix Wgt. Protected
+ * unnormalised weights. Its off-diagonal elements are the
+ * negative weights, only the diagonal is stored. Protected
  */
 void Specgrad_::make_smat()
 {
-    register unsigned int i, j;
-    register double Temp;
+    register unsigned int i, p;
+    register const double *W;
     
+    // row sums in the order of the full symmetric rows
+    Sdiag.set_values(0.0);
     for (i=0; i<N; i++)
     {
-	Smat[i][i]=0.0;
-	for (j=0; j<i; j++)
-	    Smat[i][j]=-Wgt[i][j];
+	W=(*Wmat)[i];
+	for (p=Rowbeg[i]; p<Rowbeg[i+1]; p++)
+	{
+	    Sdiag[i]+=-W[Colidx[p]];
+	    Sdiag[Colidx[p]]+=-W[Colidx[p]];
+	}
     }
+    for (i=0; i<N; i++) Sdiag[i]=-Sdiag[i];
+}
+// END of make_smat()
+
+/* make_index(): makes the column-wise index of the weighted pairs
+ * (the rows in each column are in ascending order) and divides
+ * the points into blocks of about SPEC_BLOCK pair visits. Protected
+ */
+void Specgrad_::make_index()
+{
+    register unsigned int i, k, p, q, Visits;
+    unsigned int Pno=Rowbeg[N], Blkno;
+    
+    // count the pairs in each column, then make the column starts
+    Colbeg.len(N+1); Colpos.len(Pno); Colrow.len(Pno); Colval.len(2*Pno);
+    Colbeg.set_values(0);
+    for (p=0; p<Pno; p++) Colbeg[Colidx[p]+1]++;
+    for (k=0; k<N; k++) Colbeg[k+1]+=Colbeg[k];
+    
+    // put the pairs in place, Colbeg[k] is shifted to Colbeg[k+1] meanwhile
     for (i=0; i<N; i++)
+	for (p=Rowbeg[i]; p<Rowbeg[i+1]; p++)
+	{
+	    q=Colbeg[Colidx[p]]++;
+	    Colpos[p]=q; Colrow[q]=i;
+	}
+    for (k=N; k>0; k--) Colbeg[k]=Colbeg[k-1];
+    Colbeg[0]=0;
+    
+    // blocks: a point visits its row and its column
+    for (Blkno=0, Visits=0, k=0; k<N; k++)
     {
-	Temp=0.0;
-	for (j=0; j<N; j++) Temp+=(i>=j)? Smat[i][j]: Smat[j][i];
-	Smat[i][i]=-Temp;
+	Visits+=Rowbeg[k+1]-Rowbeg[k]+Colbeg[k+1]-Colbeg[k]+1;
+	if (Visits>=SPEC_BLOCK || k==N-1)
+	{
+	    Blkno++; Visits=0;
+	}
     }
+    Blkbeg.len(Blkno+1);
+    Blkbeg[0]=0;
+    for (Blkno=0, Visits=0, k=0; k<N; k++)
+    {
+	Visits+=Rowbeg[k+1]-Rowbeg[k]+Colbeg[k+1]-Colbeg[k]+1;
+	if (Visits>=SPEC_BLOCK || k==N-1)
+	{
+	    Blkbeg[++Blkno]=k+1; Visits=0;
+	}
+    }
+    Blkstress.len(Blkno); Blknum.len(Blkno); Blkden.len(Blkno);
 }
-// END of make_smat()
+// END of make_index()
 
-/* norm_weights(): norms the weights so that the weighted
- * squared sum of ideal distances in Id will equal 1.
- * The norm factor is stored in Wnorm. Protected
+/* norm_weights(): calculates the factor Wmul which norms the weights
+ * so that the weighted squared sum of ideal distances in Id
+ * will equal 1. The weights are multiplied by Wmul when used. Protected
  */
 void Specgrad_::norm_weights(const Trimat_& Id)
 {
-    Wgt*=Wnorm;	// reset previous state
-    Smat*=Wnorm;
+    register unsigned int i, p;
+    register double Temp, Wnorm=0.0;
+    register const double *Row, *W;
     
-    register unsigned int i, j;
-    register double Temp;
-    Wnorm=0.0;
     for (i=0; i<N; i++)
-	for (j=0; j<i; j++)
+    {
+	Row=Id[i]; W=(*Wmat)[i];
+	for (p=Rowbeg[i]; p<Rowbeg[i+1]; p++)
 	{
-	    if (Wgt[i][j]<=0.0) continue;
-	    
-	    Temp=Id[i][j];
+	    if (W[Colidx[p]]<=0.0) continue;
+    
+	    Temp=Row[Colidx[p]];
 	    Temp*=Temp;	// squared ideal dist
-	    Temp*=Wgt[i][j];
+	    Temp*=W[Colidx[p]];
 	    Wnorm+=Temp;
 	}
-    if (Wnorm>SMALL)
-    {
-	Wgt/=Wnorm; Smat/=Wnorm;
     }
-    else Wnorm=1.0;
+    Wmul=(Wnorm>SMALL)? 1.0/Wnorm: 1.0;
 }
 // END of norm_weights()
 
-/* actual_dist(): obtains the member matrix of UNsquared actual
- * distances (Distact) from the vectors in Xt. Protected
+/* actual_dist(): obtains the UNsquared actual distances (Distact)
+ * of the weighted pairs from the current coordinates. Protected
  */
 void Specgrad_::actual_dist()
 {
-    // NOTE: the horrible spelt-out cycles are meant to save time
-    register unsigned int i, j, k;
-    register double Temp, Temp2;
-    
+    register unsigned int i, p;
     for (i=0; i<N; i++)
-    {
-	Distact[i][i]=0.0;
-	for (j=0; j<i; j++)
-	{
-	    Temp=0.0;
-	    for (k=0; k<D; k++)
-	    {
-		Temp2=Xt[i][k]-Xt[j][k];
-		Temp+=Temp2*Temp2;
-	    }
-	    Distact[i][j]=sqrt(Temp);
-	}
-    }
+	for (p=Rowbeg[i]; p<Rowbeg[i+1]; p++)
+	    Distact[p]=sqrt(Xt[Cur].dist2(i, Colidx[p]));
 }
 // END of actual_dist()
 
-/* make_bmat(): constructs the "B" matrix from the weights and the
- * ideal and actual (unsquared) distances. Protected
+// ---- Threads ----
+
+/* start_team(): sizes the gradient sum workspaces and makes sure
+ * that there are helper threads for iterate() if more than
+ * one thread may be used and there are at least 2 blocks. The helpers
+ * of the previous call are kept if their number and workspaces
+ * are still right, otherwise they are replaced. The signals
+ * are blocked in the helpers so that they are delivered to the
+ * calling thread as in serial runs. If no helper can be started,
+ * then everything is done by the calling thread. Protected
  */
-void Specgrad_::make_bmat(const Trimat_& Distid)
+void Specgrad_::start_team()
 {
-    register unsigned int i, j;
-    register double Temp, Temp2;
+    if (Gwork.len()<D) Gwork.len(D);
     
-    for (i=0; i<N; i++)
+#ifdef USE_THREADS
+    unsigned int t, Tno=Blkbeg.len()-1;
+    if (Tno>Thrno) Tno=Thrno;
+    if (Team!=NULL && Team->Thrreq==Tno && Team->Dim>=D)
+	return;	    // the current helpers will do
+    stop_team();
+    if (Tno<2) return;
+    
+    Team=new Sgteam_;
+    Team->Sg=this; Team->Id=NULL;
+    Team->Threads=new pthread_t [Tno-1];
+    Team->Args=new Sgthrarg_ [Tno-1];
+    pthread_mutex_init(&Team->Lock, NULL);
+    pthread_cond_init(&Team->Go, NULL);
+    pthread_cond_init(&Team->Done, NULL);
+    Team->Gen=Team->Busy=0; Team->Stage=QUIT;
+    Team->Thrreq=Tno; Team->Dim=D;
+    for (t=1; t<Tno; t++)
     {
-	Temp=0.0;
-	// rows
-	for (j=0; j<i; j++)
-	{
-	    Temp2=(Wgt[i][j]<=SMALL || Distact[i][j]<=SMALL)? 
-		0.0: -Wgt[i][j]*Distid[i][j]/Distact[i][j];
-	    Bmat[i][j]=Temp2;
-	    Temp+=Temp2;
-	}
-	// cols
-	for (j=i+1; j<N; j++)
-	{
-	    Temp2=(Wgt[j][i]<=SMALL || Distact[j][i]<=SMALL)? 
-		0.0: -Wgt[j][i]*Distid[j][i]/Distact[j][i];
-	    Bmat[j][i]=Temp2;
-	    Temp+=Temp2;
-	}
-	Bmat[i][i]=-Temp;   // diagonal sum
+	Team->Args[t-1].Team=Team; Team->Args[t-1].Thridx=t;
+	Team->Args[t-1].Gsum=new double [D];
     }
+    
+    sigset_t Sigset, Oldset;
+    sigfillset(&Sigset);
+    pthread_sigmask(SIG_BLOCK, &Sigset, &Oldset);
+    for (t=1; t<Tno; t++)
+	if (pthread_create(Team->Threads+t-1, NULL, specgrad_thread, Team->Args+t-1))
+	    break;  // go on with the ones that could be started
+    pthread_sigmask(SIG_SETMASK, &Oldset, NULL);
+    Team->Thrno=t;
+    if (Team->Thrno<2) stop_team();
+#endif
 }
-// END of make_bmat()
+// END of start_team()
 
-/* stress(): calculates the "stress" value, i.e. the weighted
- * difference between the ideal and actual distances. Protected
+/* stop_team(): stops and joins the helper threads. Protected */
+void Specgrad_::stop_team()
+{
+#ifdef USE_THREADS
+    if (Team==NULL) return;
+    
+    unsigned int t;
+    pthread_mutex_lock(&Team->Lock);
+    Team->Stage=QUIT; Team->Gen++;
+    pthread_cond_broadcast(&Team->Go);
+    pthread_mutex_unlock(&Team->Lock);
+    for (t=1; t<Team->Thrno; t++)
+	pthread_join(Team->Threads[t-1], NULL);
+    
+    pthread_mutex_destroy(&Team->Lock);
+    pthread_cond_destroy(&Team->Go);
+    pthread_cond_destroy(&Team->Done);
+    for (t=1; t<Team->Thrreq; t++) delete [] Team->Args[t-1].Gsum;
+    delete [] Team->Threads; delete [] Team->Args;
+    delete Team;
+    Team=NULL;
+#endif
+}
+// END of stop_team()
+
+/* run_stage(): performs one stage of an iteration step on all blocks
+ * of the points, shared among the helper threads if there are any. Protected
  */
-float Specgrad_::stress(const Trimat_& Distid) const
+void Specgrad_::run_stage(Stage_ Stage, const Trimat_& Id)
 {
-    register unsigned int i, j;
-    register float Stress=0.0, Temp;
+#ifdef USE_THREADS
+    if (Team!=NULL)
+    {
+	pthread_mutex_lock(&Team->Lock);
+	Team->Stage=Stage; Team->Id=&Id;
+	Team->Busy=Team->Thrno-1; Team->Gen++;
+	pthread_cond_broadcast(&Team->Go);
+	pthread_mutex_unlock(&Team->Lock);
     
-    for (i=0; i<N; i++)
-	for (j=0; j<i; j++)
-	{
-	    if (Wgt[i][j]<=0.0) continue;
-	    Temp=float(Distid[i][j])-float(Distact[i][j]);
-	    Stress+=float(Wgt[i][j])*Temp*Temp;
-	}
-    return(Stress);
+	stage_blocks(Stage, Id, 0, Team->Thrno, &Gwork[0]);    // caller's share
+    
+	pthread_mutex_lock(&Team->Lock);
+	while (Team->Busy) pthread_cond_wait(&Team->Done, &Team->Lock);
+	pthread_mutex_unlock(&Team->Lock);
+	return;
+    }
+#endif
+    stage_blocks(Stage, Id, 0, 1, &Gwork[0]);
 }
-// END of stress()
+// END of run_stage()
 
-/* make_negrad(): makes the negative gradient of the stress function. Protected */
-void Specgrad_::make_negrad()
+#ifdef USE_THREADS
+/* specgrad_thread(): the start function of the helper threads,
+ * Thrarg points to a Sgthrarg_ structure. Performs the posted
+ * stages until QUIT is posted.
+ */
+void *specgrad_thread(void *Thrarg)
 {
-    // WARNING: Bmat is modified!
-    Bmat-=Smat;
+    Sgthrarg_ *Ta=(Sgthrarg_*)Thrarg;
+    Sgteam_ *Team=Ta->Team;
+    unsigned int Gen=0;
+    int Stage;
+    
+    while (1)
+    {
+	pthread_mutex_lock(&Team->Lock);
+	while (Team->Gen==Gen) pthread_cond_wait(&Team->Go, &Team->Lock);
+	Gen=Team->Gen; Stage=Team->Stage;
+	pthread_mutex_unlock(&Team->Lock);
+	if (Stage==Specgrad_::QUIT) break;
+    
+	Team->Sg->stage_blocks(Specgrad_::Stage_(Stage), *(Team->Id),
+	    Ta->Thridx, Team->Thrno, Ta->Gsum);
+    
+	pthread_mutex_lock(&Team->Lock);
+	if (!--Team->Busy) pthread_cond_signal(&Team->Done);
+	pthread_mutex_unlock(&Team->Lock);
+    }
+    return(NULL);
+}
+// END of specgrad_thread()
+#endif
+
+// ---- Iteration stages ----
 
-    register unsigned int i, j, k;
-    register double Temp;
+/* stage_blocks(): performs the Stage on the blocks First, First+Step...
+ * using Gsum (at least D long) as a workspace.
+ * The stages are:-
+ * STRESS: the stress of the blocks from the current Distact;
+ * STEP: Distact from the current coordinates, the stress of the blocks
+ *	and the off-diagonal elements of the "B" matrix;
+ * GRAD: the diagonal of the "B" matrix, the negative gradient 2*(B-S)*X
+ *	and the step size products of the blocks.
+ * Each point visits its row and then its column in GRAD, so the
+ * sums are made in the order of the full symmetric rows. Protected
+ */
+void Specgrad_::stage_blocks(Stage_ Stage, const Trimat_& Id,
+	unsigned int First, unsigned int Step, double *Gsum)
+{
+    register unsigned int b, i, j, k, p, q;
+    register double Temp, Wgt, Dact, Sum;
+    register float Bstress, Ftemp;
+    register const double *Row, *W;
+    register double *Ng;
+    double Num, Denom;
+    const Coords_& Xcur=Xt[Cur];
+    unsigned int Blkno=Blkbeg.len()-1;
     
-    for (i=0; i<N; i++)
-	for (j=0; j<D; j++)
+    for (b=First; b<Blkno; b+=Step)
+    {
+	switch(Stage)
 	{
-	    Temp=0.0;
-	    for (k=0; k<N; k++)
-		Temp+=Bmat(i, k)*Xt[k][j];
-	    Negrad[i][j]=2.0*Temp;
+	    case STRESS:
+	    Bstress=0.0;
+	    for (i=Blkbeg[b]; i<Blkbeg[b+1]; i++)
+	    {
+		Row=Id[i]; W=(*Wmat)[i];
+		for (p=Rowbeg[i]; p<Rowbeg[i+1]; p++)
+		{
+		    k=Colidx[p];
+		    Wgt=W[k]*Wmul;
+		    if (Wgt<=0.0) continue;
+		    Ftemp=float(Row[k])-float(Distact[p]);
+		    Bstress+=float(Wgt)*Ftemp*Ftemp;
+		}
+	    }
+	    Blkstress[b]=Bstress;
+	    break;
+    
+	    case STEP:
+	    Bstress=0.0;
+	    for (i=Blkbeg[b]; i<Blkbeg[b+1]; i++)
+	    {
+		Row=Id[i]; W=(*Wmat)[i];
+		Sum=0.0;
+		for (p=Rowbeg[i]; p<Rowbeg[i+1]; p++)
+		{
+		    k=Colidx[p];
+		    Dact=sqrt(Xcur.dist2(i, k));
+		    Distact[p]=Dact;
+		    Wgt=W[k]*Wmul;
+		    if (Wgt>0.0)
+		    {
+			Ftemp=float(Row[k])-float(Dact);
+			Bstress+=float(Wgt)*Ftemp*Ftemp;
+		    }
+		    Temp=(Wgt<=SMALL || Dact<=SMALL)? 0.0: -Wgt*Row[k]/Dact;
+		    Sum+=Temp;
+		    Bsval[p]=Temp+Wgt;	// off-diagonal B-S
+		
+		    // the same in column order
+		    q=2*Colpos[p];
+		    Colval[q]=Temp; Colval[q+1]=Temp+Wgt;
+		}
+		Bdiag[i]=Sum;	// the row part only
+	    }
+	    Blkstress[b]=Bstress;
+	    break;
+    
+	    case GRAD:
+	    Num=Denom=0.0;
+	    for (k=Blkbeg[b]; k<Blkbeg[b+1]; k++)
+	    {
+		// diagonal of "B": negative sum of the row, add the column part
+		Sum=Bdiag[k];
+		for (q=Colbeg[k]; q<Colbeg[k+1]; q++) Sum+=Colval[2*q];
+		Bdiag[k]=-Sum;
+    
+		// (B-S)*X, all coordinates in one sweep
+		for (j=0; j<D; j++) Gsum[j]=0.0;
+		for (p=Rowbeg[k]; p<Rowbeg[k+1]; p++)
+		{
+		    Temp=Bsval[p]; i=Colidx[p];
+		    for (j=0; j<D; j++) Gsum[j]+=Temp*Xcur.col(j)[i];
+		}
+		Temp=Bdiag[k]-Sdiag[k]*Wmul;
+		for (j=0; j<D; j++) Gsum[j]+=Temp*Xcur.col(j)[k];
+		for (q=Colbeg[k]; q<Colbeg[k+1]; q++)
+		{
+		    Temp=Colval[2*q+1]; i=Colrow[q];
+		    for (j=0; j<D; j++) Gsum[j]+=Temp*Xcur.col(j)[i];
+		}
+    
+		for (j=0; j<D; j++)
+		{
+		    Ng=Negrad.col(j);
+		    Ng[k]=Gsum[j]*2.0;
+    
+		    // step size products
+		    Temp=Oldnegrad.col(j)[k];
+		    Num+=Ng[k]*Temp;
+		    Denom+=Temp*Temp;
+		}
+	    }
+	    Blknum[b]=Num; Blkden[b]=Denom;
+	    break;
+    
+	    default: break;
 	}
+    }
+}
+// END of stage_blocks()
+
+/* stress(): returns the "stress" value, i.e. the weighted
+ * difference between the ideal and actual distances, from
+ * the block sums made by the last STRESS or STEP stage. Protected
+ */
+float Specgrad_::stress() const
+{
+    register unsigned int b;
+    register float Stress=0.0;
+    
+    for (b=0; b<Blkstress.len(); b++) Stress+=Blkstress[b];
+    return(Stress);
 }
-// END of make_negrad()
+// END of stress()
 
-/* update_coords(): updates the coordinates with the negative gradient,
- * using Alpha as the "stepsize". Protected
+/* update_coords(): puts the current coordinates updated with the negative
+ * gradient into Next, using Alpha as the "stepsize".
+ * Return value: 1 if OK, 0 if Alpha was unusable (Next is not modified then).
+ * Protected
  */
-void Specgrad_::update_coords(float Alpha)
+int Specgrad_::update_coords(float Alpha, Coords_& Next) const
 {
     if (!finite(Alpha) || fabs(Alpha)<SMALL)
     {
 	cerr<<"\n? Specgrad_::update_coords("<<Alpha<<")"<<endl;
-	return;
+	return(0);
     }
     Alpha=1.0/Alpha;
     
     register unsigned int i, j;
-    for (i=0; i<N; i++)
-	for (j=0; j<D; j++)
-	    Xt[i][j]+=Alpha*Negrad[i][j];
+    register double *Col;
+    register const double *Xcol, *Ncol;
+    for (j=0; j<D; j++)
+    {
+	Col=Next.col(j); Xcol=Xt[Cur].col(j); Ncol=Negrad.col(j);
+	for (i=0; i<N; i++)
+	    Col[i]=Xcol[i]+Alpha*Ncol[i];
+    }
+    return(1);
 }
 // END of update_coords()
 
-/* make_alpha(): calculates the new stepsize Alpha. Protected */
+/* make_alpha(): calculates the new stepsize Alpha from the
+ * block sums made by the last GRAD stage. Protected
+ */
 void Specgrad_::make_alpha(float& Alpha) const
 {
-    register unsigned int i, j;
-    register double Num=0.0, Denom=0.0, Temp;
+    register unsigned int b;
+    register double Num=0.0, Denom=0.0;
     
-    // generate inner products
-    for (i=0; i<N; i++)
-	for (j=0; j<D; j++)
-	{
-	    Temp=Oldnegrad[i][j];
-	    Num+=Negrad[i][j]*Temp;
-	    Denom+=Temp*Temp;
-	}
+    // add up the inner products
+    for (b=0; b<Blknum.len(); b++)
+    {
+	Num+=Blknum[b];
+	Denom+=Blkden[b];
+    }
     if (Denom>SMALL) Alpha*=(1.0-Num/Denom);
 }
 // END of make_alpha()
@@ -16,38 +16,108 @@
 
 // ---- MODULES ----
 
+#include "Array.h"
 #include "Points.h"
+#include "Coords.h"
+
+// ---- TYPES ----
+
+struct Sgteam_;	    // helper threads of iterate(), see Specgrad.c++
+
+/* Sgteamptr_: points to the helper threads of a Specgrad_ object.
+ * The helpers belong to one object only, so a copy starts without
+ * them and an assignment keeps the helpers of the target.
+ */
+class Sgteamptr_
+{
+    Sgteam_ *Team;
+    
+    public:
+    Sgteamptr_(): Team(NULL) {}
+    Sgteamptr_(const Sgteamptr_&): Team(NULL) {}
+    Sgteamptr_& operator=(const Sgteamptr_&) { return(*this); }
+    Sgteamptr_& operator=(Sgteam_ *T) { Team=T; return(*this); }
+    operator Sgteam_*() const { return(Team); }
+    Sgteam_ *operator->() const { return(Team); }
+};
 
 // ==== CLASSES ====
 
+/* Class Specgrad_ : minimises the weighted stress of a point set.
+ * Only the pairs with non-zero weights are stored (row i of the lower
+ * triangle holds the pairs (i,Colidx[p]) for Rowbeg[i]<=p<Rowbeg[i+1]),
+ * so an iteration costs time proportional to the number of weighted
+ * pairs. The weights are not copied: they are read from the matrix
+ * passed to weight() and normalised on the fly.
+ * The pairs are indexed column by column as well: column k holds
+ * the pairs (Colrow[q],k) for Colbeg[k]<=q<Colbeg[k+1], the pair p
+ * being at q=Colpos[p]. The "B" and "S" matrices of the majorisation
+ * are kept as their diagonals and as the off-diagonal values of the
+ * pairs, both in row and in column order, so that the gradient of
+ * a point can be made by reading its row and column sequentially
+ * without writing to the other points. The points are processed
+ * in blocks of roughly equal work which may be shared among
+ * several threads (see thread_no()). Sums over all points are
+ * made blockwise and the block sums are added up in a fixed order,
+ * so the results do not depend on the number of threads.
+ */
 class Specgrad_
 {
     // constants
     static const double SMALL;	// unsafe to divide with things smaller than this
+    enum Stage_ {QUIT=0, STRESS, STEP, GRAD};	// iteration stages (cf. run_stage())
     
     // data
     protected:
     
-    Trimat_ Wgt, Distact, Bmat, Smat;   // weight, actual dists, aux matrices
-    Matrix_ Xt;	// transposed matrix of coordinates
-    Matrix_ Negrad, Oldnegrad; // negative gradients of the stress function
-    Matrix_ Xtbest; // coords with the lowest stress
+    const Trimat_ *Wmat;    // the weight matrix (see weight())
+    Array_<unsigned int> Rowbeg, Colidx;	// the weighted pairs (see above)
+    Array_<unsigned int> Colbeg, Colpos, Colrow;    // the same column-wise
+    Array_<unsigned int> Blkbeg;    // block b is points [Blkbeg[b]..Blkbeg[b+1]-1]
+    Array_<double> Distact, Bsval;	// actual dist and "B-S" for each pair
+    Array_<double> Colval;	// "B" and "B-S" of the pairs in column order
+    Array_<double> Sdiag, Bdiag;    // diagonals of the aux matrices (S unnormalised)
+    Array_<float> Blkstress;	// stress of each block
+    Array_<double> Blknum, Blkden;  // the step size products of each block
+    Coords_ Xt[3];  // coordinate buffers: current, best and next in turn
+    int Cur;	    // index of the current coordinates in Xt[] (-1 if none)
+    Coords_ Negrad, Oldnegrad; // negative gradients of the stress function
+    Coords_ Work;   // copy of a Points_ point set
+    Array_<double> Gwork;   // gradient sums of a point for the calling thread
     
-    double Wnorm;    // weight matrix norm
+    double Wmul;    // weight normalisation factor
     unsigned int N, D;	// no. of active points, dimension
+    unsigned int Thrno;	// max. no. of threads in iterate()
+    Sgteamptr_ Team;	// the helper threads of iterate() or NULL
     
     // methods
     public:
     
     /* inits for Size vectors in Dim dimensions */
     Specgrad_(unsigned int Size=10, unsigned int Dim=3):
-	Wgt(Size), Distact(Size), Bmat(Size), 
-	Smat(Size), Xt(Size, Dim), Xtbest(Size, Dim), 
-	Negrad(Size, Dim), Oldnegrad(Size, Dim),
-	Wnorm(1.0), N(Size), D(Dim) {}
+	Wmat(NULL), Rowbeg(0U, Size+1), Sdiag(0.0, Size), Bdiag(Size), 
+	Cur(-1), Negrad(Size, Dim), Oldnegrad(Size, Dim), Work(Size, Dim),
+	Wmul(1.0), N(Size), D(Dim), Thrno(1) {}
+    
+    /* The helper threads are kept between the iterate() calls
+     * and are stopped here.
+     */
+    ~Specgrad_() { stop_team(); }
+    
+    /* thread_no(): returns the maximal number of threads iterate() may use.
+     * thread_no(Thrnew): sets this number to Thrnew (1 if Thrnew==0)
+     * and returns the old value. Without thread support (USE_THREADS
+     * not defined) it is always 1.
+     */
+    unsigned int thread_no() const { return(Thrno); }
+    unsigned int thread_no(unsigned int Thrnew);
     
     /* weight(): sets up the calling object to work with a given
-     * weight matrix W (with entries >=0.0).
+     * weight matrix W (with entries >=0.0). Only the positions of
+     * the non-zero entries of W are stored (and they are rebuilt
+     * only if they differ from the previous ones), the weights
+     * are read from W by iterate(), therefore W must not change
+     * or go away until the next call to weight().
      * Returns the size of the problem.
      */
     int weight(const Trimat_& W);
@@ -61,20 +131,34 @@ class Specgrad_
      * then Itno is set to -Itno on return.
      * Return value: the "stress" (weighted dist difference).
      * Negative stress values indicate serious errors.
+     * The Points_ version copies the points into a Coords_ workspace
+     * and back. The Coords_ version takes over the storage of Coords
+     * and swaps the best coordinates back if Coords holds exactly N
+     * points, all active; otherwise the coordinates are copied.
      */
     float iterate(const Trimat_& Id, Points_& Coords, 
 	    int& Itno, float Eps=0.001);
+    float iterate(const Trimat_& Id, Coords_& Coords, 
+	    int& Itno, float Eps=0.001);
     
     protected:
     
     void make_smat();
+    void make_index();
     void norm_weights(const Trimat_& Id);
     void actual_dist();
-    void make_bmat(const Trimat_& Distid);
-    void make_negrad();
-    void update_coords(float Alpha);
+    void start_team();
+    void stop_team();
+    void run_stage(Stage_ Stage, const Trimat_& Id);
+    void stage_blocks(Stage_ Stage, const Trimat_& Id,
+	    unsigned int First, unsigned int Step, double *Gsum);
+    float stress() const;
+    int update_coords(float Alpha, Coords_& Next) const;
     void make_alpha(float& Alpha) const;
-    float stress(const Trimat_& Distid) const;
+    
+    #ifdef USE_THREADS
+	friend void *specgrad_thread(void *Thrarg);
+    #endif
 };
 // END OF CLASS Specgrad_
 
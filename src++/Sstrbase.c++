@@ -15,6 +15,7 @@
 
 #include "Vector.h"
 #include "Sqmat.h"
+#include "Vec3.h"
 #include "Hirot.h"
 
 // ---- MODULE HEADER ----
@@ -66,15 +67,17 @@ unsigned int Sstrbase_::make_helix(Points_& Hel, double Radius,
  * the torsion angle defined by them (along 2-3) is returned. The
  * value should be between -Pi..+Pi with the sign indicating the
  * usual handedness convention. -2*Pi is returned if any 3 of the 
- * points are colinear. Protected static
+ * points are colinear. The points must be 3D. Protected static
  */
 double Sstrbase_::pos4_angle(const Vector_& P1, const Vector_& P2,
 	const Vector_& P3, const Vector_& P4)
 {
+    Vec3_ Q1(P1), Q2(P2), Q3(P3), Q4(P4);   // no heap temporaries
+    
     // get normal vectors of planes (123) and (234)
-    Vector_ V2=P3-P2;   // torsion is taken along this
-    Vector_ W1=cross_prod(P2-P1,V2);
-    Vector_ W2=cross_prod(V2,P4-P3);
+    Vec3_ V2=Q3-Q2;   // torsion is taken along this
+    Vec3_ W1=cross_prod(Q2-Q1,V2);
+    Vec3_ W2=cross_prod(V2,Q4-Q3);
 
     // colinearity check: return -2Pi if fails
     register double W1len, W2len;
@@ -26,7 +26,7 @@ double apply_secstruct(const Pieces_& Pieces, Points_& Model)
 {
     double Rms, Maxrms=0.0, Avgrms=0.0, Minrms=HUGE_VAL;
     
-    Clist1_<Sstr_> Slist=Pieces.secs();    // secondary struct list iterator
+    Cvlist_<Sstr_> Slist=Pieces.secs();    // secondary struct list iterator
     if (Slist.len())
     {
 	for (Slist.begin(); Slist!=NULL; Slist++)
@@ -62,7 +62,7 @@ int hand_check(const Pieces_& Pieces, Points_& Model)
     register int Flip;
     
     // test secstr regions
-    Clist1_<Sstr_> Slist=Pieces.secs();
+    Cvlist_<Sstr_> Slist=Pieces.secs();
     for (Slist.begin(); Slist!=NULL; Slist++)
     {
 	Flip=(*Slist)->check_torsion(Model, Good, Bad);
@@ -16,7 +16,6 @@
 #include "Vector.h"
 #include "Bits.h"
 #include "String.h"
-#include "Hirot.h"
 
 // ---- MODULE HEADER ----
 
@@ -105,193 +104,110 @@ float Steric_::limit_iddist(float Ideal, const Restraints_& Restraints,
 }
 // END of limit_iddist()
 
-/* ideal_dist(): fills up the ideal distance matrix within the
- * calling object. Dista is the actual CA:CA distance matrix (squared), 
- * Fakebeta can be queried for sidechain centroid (SCC) distances, 
- * Restraints holds the external restraints and various bump lengths, 
- * Polymer supplies CA:SCC distances, Pieces provides the cluster
- * layout, Checkflags controls the adjustment.
- * If the SCORE flag was specified in Checkflags, then *Scores will contain
- * a score update on return, otherwise it is left unchanged.
- * If SCORE is set and Vl!=NULL then the violation list pointed to by Vl is made.
+/* add_pair(): notes that the (i, j) pair may need adjustment
+ * by a subsequent SPARSE adjust_xyz() call. The pair is stored
+ * as d*Adjsize+i (i>j, d=i-j) so that sorting puts the pairs
+ * into the scanning order of the full adjustment.
  */
-void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta, 
+void Steric_::add_pair(unsigned int i, unsigned int j)
+{
+    if (i==j) return;	// not a pair
+    if (i<j) { register unsigned int t=i; i=j; j=t; }
+    if (Adjno>=Adjpair.len())
+	Adjpair.len(2*Adjno+Adjsize);	// grow geometrically
+    Adjpair[Adjno++]=(unsigned long)(i-j)*Adjsize+i;
+}
+// END of add_pair()
+
+/* ulong_cmp(): auxiliary function for the qsort() in sort_pairs(). */
+static int ulong_cmp(const void *X, const void *Y)
+{
+    register unsigned long Kx= *((unsigned long *)X), Ky= *((unsigned long *)Y);
+    return((Kx>Ky)? 1: ((Kx<Ky)? -1: 0));
+}
+/* END of ulong_cmp() */
+
+/* sort_pairs(): sorts the pairs noted by add_pair() and
+ * removes the duplicates.
+ */
+void Steric_::sort_pairs()
+{
+    if (Adjno<2) return;
+    
+    register unsigned int p, q;
+    qsort(&Adjpair[0], Adjno, sizeof(unsigned long), ulong_cmp);
+    for (p=1, q=0; p<Adjno; p++)
+	if (Adjpair[p]!=Adjpair[q]) Adjpair[++q]=Adjpair[p];
+    Adjno=q+1;
+}
+// END of sort_pairs()
+
+/* ideal_scan(): the pairwise checks of ideal_dist().
+ * The Flags template parameter holds the cluster (WITHIN/BETWEEN/ALL) and
+ * RINT, REXT, BOND and SCORE bits of the ideal_dist() check flags, so that
+ * the tests on them are resolved at compile time and the untaken
+ * branches are dropped from the loop. Flags==-1 makes the generic
+ * version which tests the run-time flags in Runflags instead.
+ * Lok is ON for the residues with a distinct SCC. Returns the
+ * updated maximal strictness Maxstrict. Private
+ */
+#define SCANFLAG(F) ((Flags<0)? (Runflags & (F)): (Flags & (F)))
+
+template <int Flags>
+float Steric_::ideal_scan(const Trimat_& Dista, const Fakebeta_& Fakebeta, 
 	const Restraints_& Restraints, const Polymer_& Polymer, 
-	const Pieces_& Pieces, int Checkflags, Scores_* Scores, Viollist_ *Vl)
+	const Pieces_& Pieces, const Bits_& Lok, int Runflags, float Maxstrict, 
+	Scores_* Scores, Viollist_ *Vl)
 {
     static const float BB_FAR=12.0F;	// max. CA dist for beta test
     static const float AB_FAR=9.0F;	// max. CA dist for alpha:beta test
 
     register float D2, Cad, Cad2, D, Id, Idb, 
 	Bumpab, Bumpbb, Bumpbb2, Bmax, 
-	Calow, Caup, Castrict, Maxstrict=-1.0;
+	Calow, Caup, Castrict;
     register unsigned int Rno=Polymer.len(), // no. of residues
 	d, i, j, b;
-    register int Cluno;
-    Bits_ Lok(Rno+2);
+    register int Cluno=-1;
+    const int Clus=SCANFLAG(ALL);   // WITHIN, BETWEEN or ALL
     Viol_ Viol;
     
-    // checkflag check
-    if (!(Checkflags & ALL))   // no clus info, reset to ALL
-    {
-	cerr<<"\n? Steric_::ideal_dist(): No cluster check flags, ALL set\n";
-	Checkflags|=ALL;
-    }
-    if (!(Checkflags & (RESTR | BOND)))   // no restraint choice, reset to RESTR
-    {
-	cerr<<"\n? Steric_::ideal_dist(): No restraint flags, RESTR set\n";
-	Checkflags|=RESTR;
-    }
-    if (Vl!=NULL && !(Checkflags & SCORE))
-    {
-	cerr<<"\n? Steric_::ideal_dist(): Viollist ptr !=NULL, SCORE set\n";
-	Checkflags|=SCORE;
-    }
-    if ((Checkflags & SCORE) && Scores==NULL)
-    {
-	cerr<<"\n? Steric_::ideal_dist(): Score ptr==NULL, SCORE cleared\n";
-	Checkflags&=~SCORE;
-    }
-    
-    Lastflags=Checkflags;    // save last adjustment type
-    Checkflags&=ALL;	// use only the WITHIN/BETWEEN bits from now on
-    
-    /* Init the strictness and ideal distance matrices.
-     * This depends on the adjustment required.
-     */
-    Idist.set_values(0.0);  // all
-    Strimat.set_values(0.0);
-    
-    // init the BOND/NONBD/RESTR/SECSTR scores
-    if (Lastflags & SCORE)
-    {
-	(*Scores)[Scores_::BOND].sum_reset();
-	(*Scores)[Scores_::NONBD].sum_reset();
-	(*Scores)[Scores_::RESTR].sum_reset();
-	(*Scores)[Scores_::SECSTR].sum_reset();
-    }
-    
-    /* init the Lok bit-vector (ON if 0<Lambda[i]<1),
-     * the 0:th and Rno+1:th bits are always OFF (N/C terminal points)
-     */
-    for (i=1; i<=Rno; i++)
-	Lok.set_bit(i, bool(Fakebeta.lambda(i)>0.0F && Fakebeta.lambda(i)<1.0F));
-    
-    // do external non-CA:CA restraints first
-    if (Restraints.restr_no() && (Lastflags & REXT) && !(Lastflags & BOND))
+    Pieces_::Clutype_ Clutyp=Pieces_::UNKNOWN;
+    unsigned int Dmax=SCANFLAG(BOND)? 3: Rno+2;
+    for (d=1; d<Dmax; d++) 
     {
-	// set up the "CA" const string for comparison
-	static const String_ CA("CA");
-	Clist1_<Restr_> Rlist(Restraints.ext_restr());  // iterator
-	bool Liok=false, Ljok=false;
-	
-	/* check the external non-CA:CA dist restraints. Note that
-	 * non-positive distances may occur here. These restraints
-	 * will be taken into account only if there are no bump violations.
-	 */
-	for (Rlist.begin(); Rlist!=NULL; Rlist++)
+	for (i=d; i<Rno+2; i++)
 	{
-	    i=Rlist->pos(1); j=Rlist->pos(2);
-	    
-	    /* decide whether to update this particular pair:
-	     * skip if the check is done within a cluster and (i, j) are
-	     * not in it, or if the check is between different clusters
-	     * and (i, j) happen to be in the same one.
-	     */
-	    if (Checkflags!=ALL)
-	    {
-		Cluno=Pieces.members(i, j);
-		if (Checkflags==WITHIN && Cluno<0 || Checkflags==BETWEEN && Cluno>=0)
-		    continue;
-	    }
+	    j=i-d;
 	    
-	    // true if the i:th (j:th) SCC is distinct from the CA
-	    Liok=bool(Fakebeta.lambda(i)>0.0F && Fakebeta.lambda(i)<1.0F);
-	    Ljok=bool(Fakebeta.lambda(j)>0.0F && Fakebeta.lambda(j)<1.0F);
-	    Cad2=Dista(i, j);
-	    if (Rlist->atom(1)==CA)	// first atom is CA
-	    {
-		if (Rlist->atom(2)==CA)  // CA:CA restraint, will be dealt with later
-		    continue;		    // and shouldn't be here anyway
-		else    // CA:SCC restraint
-		    D2=Ljok? Fakebeta.ab(i, j): Cad2;
-	    }
-	    else	// first atom must be "SCC", i.e. fake C-beta
-	    {
-		if (Rlist->atom(2)==CA)   // SCC:CA restraint
-		    D2=Liok? Fakebeta.ab(j, i): Cad2;
-		else	// SCC:SCC restraint
-		    D2=(Liok && Ljok)? Fakebeta.bb(i, j): Cad2;
-	    }
-    
-	    /* do not bother with wildly non-metric data: 
-	     * experience has shown that D2==0.0 can wreak havoc, 
-	     * so these distances are not adjusted
+	    /* the cluster layout is needed only for the cluster check,
+	     * the choice between RINT and REXT and the scoring
 	     */
-	    if (D2<=0.0) continue;
-	    
-	    // adjust if weight is not lower than previous
-	    if (Rlist->strict()>=Strimat(i, j))
+	    if (Clus!=ALL || (!SCANFLAG(BOND) && SCANFLAG(RESTR)!=RESTR) || SCANFLAG(SCORE))
 	    {
-		Cad=sqrtf(Cad2);
-		Strimat(i, j)=Rlist->strict();
-		if (Maxstrict<Rlist->strict())
-		    Maxstrict=Rlist->strict();
-		if (D2<Rlist->low2() || D2>Rlist->up2())    // violation
-		{
-		    D=sqrtf(D2);
-		    Id=make_iddist(D, Rlist->low(), Rlist->up());
-		    Id*=Cad/D;	// scale to CA:CA
-		    Idist(i, j)=limit_iddist(Id, Restraints, i, j); // limit to CA:CA
-		    
-		    if (Lastflags & SCORE)  // do the scoring
-		    {
-			(*Scores)[Scores_::RESTR]+=
-			    Viol.rel_viol(D, Rlist->low(), Rlist->up(), Rlist->strict());
-			if (Vl!=NULL)
-			{
-			    Viol.atom(1, Rlist->atom(1), i, Viol_::RESTR);
-			    Viol.atom(2, Rlist->atom(2), j);
-			    Vl->add_viol(Viol);
-			}
-		    }
-		}
-		else Idist(i, j)=Cad;	// keep actual with restr's weight
+		Cluno=Pieces.members(i, j);	// -1 if in separate clusters
+		Clutyp=Pieces.clu_type(Cluno);  // UNKNOWN if Cluno==-1
 	    }
-	}	// for Rlist
-    }	    // if (there are external restraints)
-
-    // scan all distances (or just 1st,2nd for BOND checks)
-    Pieces_::Clutype_ Clutyp;
-    int Dmax=(Lastflags & BOND)? 3: Rno+2;
-    for (d=1; d<Dmax; d++) 
-    {
-	for (i=d; i<Rno+2; i++)
-	{
-	    j=i-d;
-	    Cluno=Pieces.members(i, j);	// -1 if in separate clusters
-	    Clutyp=Pieces.clu_type(Cluno);  // UNKNOWN if Cluno==-1
 	    
 	    /* decide whether to update this particular pair:
 	     * skip if cluster membership is not what is required
-	     * by Checkflags
+	     * by Clus
 	     */
-	    if (Checkflags!=ALL)
+	    if (Clus!=ALL)
 	    {
-		if (Checkflags==WITHIN && Cluno<0 || Checkflags==BETWEEN && Cluno>=0)
+		if ((Clus==WITHIN && Cluno<0) || (Clus==BETWEEN && Cluno>=0))
 		    continue;
 	    }
 	    
 	    // Check specific restraints?
-	    if (!(Lastflags & BOND) && Restraints.specific(i, j))
+	    if (!SCANFLAG(BOND) && Restraints.specific(i, j))
 	    {
 		// same secondary structure but RINT is not set, skip
-		if (!(Lastflags & RINT) &&
+		if (!SCANFLAG(RINT) &&
 		    (Clutyp==Pieces_::HELIX || Clutyp==Pieces_::SHEET))
 			continue;
 		
 		// external restraint (different clus or COIL) but REXT is not set, skip
-		if (!(Lastflags & REXT) &&
+		if (!SCANFLAG(REXT) &&
 		    (Clutyp==Pieces_::UNKNOWN || Clutyp==Pieces_::COIL))
 			continue;
 	    }
@@ -313,6 +229,7 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 	    {
 		// get ideal distance (unsquared)
 		Idist[i][j]=make_iddist(Cad, Calow, Caup);
+		add_pair(i, j);
 
 		// increase the strictness of CA:CA virtual bonds
 		if (d<3)
@@ -325,7 +242,7 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 		Strimat[i][j]=Castrict;	// set strictness
 		if (Maxstrict<Castrict)
 		    Maxstrict=Castrict;
-		if (Lastflags & SCORE)  // do the scoring
+		if (SCANFLAG(SCORE))  // do the scoring
 		{
 		    // get the score and violation typing
 		    Scores_::Scotype_ Scotyp;
@@ -386,7 +303,7 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 	     * the check is done for pathological cases only where
 	     * two virtual bonds "cross"
 	     */
-	    if (j && d>4 && (Lastflags & RINT) && Cad<AB_FAR &&
+	    if (j && d>4 && SCANFLAG(RINT) && Cad<AB_FAR &&
 		!Restraints.hard(i, j) && !Restraints.hard(i-1, j) &&
 		!Restraints.hard(i, j-1) && !Restraints.hard(i-1, j-1))
 	    {
@@ -411,8 +328,10 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 		    Idist[i][j-1]=limit_iddist(Newid, Restraints, i, j-1);
 		    Strimat[i][j]=Strimat[i-1][j-1]=
 			Strimat[i-1][j]=Strimat[i][j-1]=Restraints_::STRA;
+		    add_pair(i, j); add_pair(i-1, j-1);
+		    add_pair(i-1, j); add_pair(i, j-1);
 			
-		    if (Lastflags & SCORE)
+		    if (SCANFLAG(SCORE))
 			(*Scores)[Scores_::NONBD]+=
 			    Viol.rel_viol(sqrtf(Mid), 2.0*Restraints_::CA_BUMP, 
 				9999.9, Restraints_::STRA);
@@ -425,6 +344,7 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 	    {
 		Idist[i][j]=Cad; 
 		Strimat[i][j]=(d>=3)? 0.1: Castrict; // enforce 1st,2nd nb, lightweight otherwise
+		if (Dista[i][j]<DBL_EPSILON) add_pair(i, j);	// adjust_xyz() kicks these
 	    }
 	    
 	    /* don't bother if betas are too close in sequence,
@@ -455,7 +375,7 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 		    Id=make_iddist(D, Bumpbb, Bmax);	// alpha
 		    Idb+=Id; ++b;   // make up average ideal dist
 
-		    if (Lastflags & SCORE)  // do the scoring
+		    if (SCANFLAG(SCORE))  // do the scoring
 		    {
 			(*Scores)[Scores_::NONBD]+=
 			    Viol.rel_viol(D, Bumpbb, Bmax, Castrict);
@@ -481,7 +401,7 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 		    Id=make_iddist(D, Bumpab, Bmax); // alpha now
 		    Idb+=Id; ++b;
 		    
-		    if (Lastflags & SCORE)  // do the scoring
+		    if (SCANFLAG(SCORE))  // do the scoring
 		    {
 			(*Scores)[Scores_::NONBD]+=
 			    Viol.rel_viol(D, Bumpab, Bmax, Castrict);
@@ -507,7 +427,7 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 		    Id=make_iddist(D, Bumpab, Bmax); // alpha now
 		    Idb+=Id; ++b;
 
-		    if (Lastflags & SCORE)  // do the scoring
+		    if (SCANFLAG(SCORE))  // do the scoring
 		    {
 			(*Scores)[Scores_::NONBD]+=
 			    Viol.rel_viol(D, Bumpab, Bmax, Castrict);
@@ -524,12 +444,182 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 	    // construct average ideal distance (for the alpha pair)
 	    if (!b) continue;	// no beta-violations
 	    Idist[i][j]=limit_iddist(Idb, Restraints, i, j);	// unsquared ideal "alpha" dist now
+	    add_pair(i, j);
 	    Strimat[i][j]=Castrict;	// with a moderate strictness
 	    if (Maxstrict<Castrict)
 		Maxstrict=Castrict;
 
 	}	/* for i */
     }	    /* for d */
+    return(Maxstrict);
+}
+// END of ideal_scan()
+
+#undef SCANFLAG
+
+/* ideal_dist(): fills up the ideal distance matrix within the
+ * calling object. Dista is the actual CA:CA distance matrix (squared), 
+ * Fakebeta can be queried for sidechain centroid (SCC) distances, 
+ * Restraints holds the external restraints and various bump lengths, 
+ * Polymer supplies CA:SCC distances, Pieces provides the cluster
+ * layout, Checkflags controls the adjustment.
+ * If the SCORE flag was specified in Checkflags, then *Scores will contain
+ * a score update on return, otherwise it is left unchanged.
+ * If SCORE is set and Vl!=NULL then the violation list pointed to by Vl is made.
+ */
+void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta, 
+	const Restraints_& Restraints, const Polymer_& Polymer, 
+	const Pieces_& Pieces, int Checkflags, Scores_* Scores, Viollist_ *Vl)
+{
+    register float D2, Cad, Cad2, D, Id, Maxstrict=-1.0;
+    register unsigned int Rno=Polymer.len(), // no. of residues
+	i, j;
+    Bits_ Lok(Rno+2);
+    Viol_ Viol;
+    
+    // checkflag check
+    if (!(Checkflags & ALL))   // no clus info, reset to ALL
+    {
+	cerr<<"\n? Steric_::ideal_dist(): No cluster check flags, ALL set\n";
+	Checkflags|=ALL;
+    }
+    if (!(Checkflags & (RESTR | BOND)))   // no restraint choice, reset to RESTR
+    {
+	cerr<<"\n? Steric_::ideal_dist(): No restraint flags, RESTR set\n";
+	Checkflags|=RESTR;
+    }
+    if (Vl!=NULL && !(Checkflags & SCORE))
+    {
+	cerr<<"\n? Steric_::ideal_dist(): Viollist ptr !=NULL, SCORE set\n";
+	Checkflags|=SCORE;
+    }
+    if ((Checkflags & SCORE) && Scores==NULL)
+    {
+	cerr<<"\n? Steric_::ideal_dist(): Score ptr==NULL, SCORE cleared\n";
+	Checkflags&=~SCORE;
+    }
+    
+    Lastflags=Checkflags;    // save last adjustment type
+    Checkflags&=ALL;	// use only the WITHIN/BETWEEN bits from now on
+    
+    /* Init the strictness and ideal distance matrices.
+     * This depends on the adjustment required.
+     */
+    Idist.set_values(0.0);  // all
+    Strimat.set_values(0.0);
+    Adjno=0; Adjsize=Rno+2;	// no pairs noted yet
+    
+    // init the BOND/NONBD/RESTR/SECSTR scores
+    if (Lastflags & SCORE)
+    {
+	(*Scores)[Scores_::BOND].sum_reset();
+	(*Scores)[Scores_::NONBD].sum_reset();
+	(*Scores)[Scores_::RESTR].sum_reset();
+	(*Scores)[Scores_::SECSTR].sum_reset();
+    }
+    
+    /* init the Lok bit-vector (ON if 0<Lambda[i]<1),
+     * the 0:th and Rno+1:th bits are always OFF (N/C terminal points)
+     */
+    for (i=1; i<=Rno; i++)
+	Lok.set_bit(i, bool(Fakebeta.lambda(i)>0.0F && Fakebeta.lambda(i)<1.0F));
+    
+    // do external non-CA:CA restraints first
+    if (Restraints.ext_no() && (Lastflags & REXT) && !(Lastflags & BOND))
+    {
+	/* the compiled restraints are pre-sorted by cluster membership:
+	 * Sel points to the indices of the ones to be checked, NULL for all
+	 */
+	const Array_<unsigned int> *Sel=NULL;
+	if (Checkflags==WITHIN) Sel=&Restraints.ext_within();
+	else if (Checkflags==BETWEEN) Sel=&Restraints.ext_between();
+	unsigned int e, Eno=(Sel==NULL)? Restraints.ext_no(): Sel->len();
+	
+	/* check the external non-CA:CA dist restraints. Note that
+	 * non-positive distances may occur here. These restraints
+	 * will be taken into account only if there are no bump violations.
+	 */
+	for (e=0; e<Eno; e++)
+	{
+	    const Restraints_::Extrestr_& Er=Restraints.ext((Sel==NULL)? e: (*Sel)[e]);
+	    i=Er.Pos1; j=Er.Pos2;
+	    
+	    // SCC distances only if the SCC is distinct from the CA (cf. Lok)
+	    Cad2=Dista(i, j);
+	    switch(Er.Type)
+	    {
+		case Restraints_::CA_SCC:
+		D2=Lok.get_bit(j)? Fakebeta.ab(i, j): Cad2; break;
+		case Restraints_::SCC_CA:
+		D2=Lok.get_bit(i)? Fakebeta.ab(j, i): Cad2; break;
+		case Restraints_::SCC_SCC:
+		default:
+		D2=(Lok.get_bit(i) && Lok.get_bit(j))? Fakebeta.bb(i, j): Cad2; break;
+	    }
+    
+	    /* do not bother with wildly non-metric data: 
+	     * experience has shown that D2==0.0 can wreak havoc, 
+	     * so these distances are not adjusted
+	     */
+	    if (D2<=0.0) continue;
+	    
+	    // adjust if weight is not lower than previous
+	    if (Er.Strict>=Strimat(i, j))
+	    {
+		Cad=sqrtf(Cad2);
+		Strimat(i, j)=Er.Strict;
+		if (Maxstrict<Er.Strict)
+		    Maxstrict=Er.Strict;
+		if (D2<Er.Low2 || D2>Er.Up2)    // violation
+		{
+		    D=sqrtf(D2);
+		    Id=make_iddist(D, Er.Low, Er.Up);
+		    Id*=Cad/D;	// scale to CA:CA
+		    Idist(i, j)=limit_iddist(Id, Restraints, i, j); // limit to CA:CA
+		    add_pair(i, j);
+		    
+		    if (Lastflags & SCORE)  // do the scoring
+		    {
+			(*Scores)[Scores_::RESTR]+=
+			    Viol.rel_viol(D, Er.Low, Er.Up, Er.Strict);
+			if (Vl!=NULL)
+			{
+			    Viol.atom(1, (Er.Type==Restraints_::CA_SCC)? "CA": "SCC", i, Viol_::RESTR);
+			    Viol.atom(2, (Er.Type==Restraints_::SCC_CA)? "CA": "SCC", j);
+			    Vl->add_viol(Viol);
+			}
+		    }
+		}
+		else	// keep actual with restr's weight
+		{
+		    Idist(i, j)=Cad;
+		    if (Dista(i, j)<DBL_EPSILON) add_pair(i, j);
+		}
+	    }
+	}	// for e
+    }	    // if (there are external restraints)
+
+    /* scan all distances (or just 1st,2nd for BOND checks) with
+     * the loop compiled for the flags used by the simulation
+     */
+    #define IDEAL_SCAN(F) ideal_scan<F>(Dista, Fakebeta, Restraints, Polymer, \
+	Pieces, Lok, Lastflags, Maxstrict, Scores, Vl)
+    switch(Lastflags & (ALL | RESTR | BOND | SCORE))
+    {
+	case WITHIN | REXT: Maxstrict=IDEAL_SCAN(WITHIN | REXT); break;
+	case WITHIN | RESTR: Maxstrict=IDEAL_SCAN(WITHIN | RESTR); break;
+	case BETWEEN | REXT: Maxstrict=IDEAL_SCAN(BETWEEN | REXT); break;
+	case BETWEEN | RESTR: Maxstrict=IDEAL_SCAN(BETWEEN | RESTR); break;
+	case ALL | REXT: Maxstrict=IDEAL_SCAN(ALL | REXT); break;
+	case ALL | RESTR: Maxstrict=IDEAL_SCAN(ALL | RESTR); break;
+	case ALL | BOND: Maxstrict=IDEAL_SCAN(ALL | BOND); break;
+	case ALL | RESTR | SCORE: Maxstrict=IDEAL_SCAN(ALL | RESTR | SCORE); break;
+	default: Maxstrict=IDEAL_SCAN(-1); break;	// tests the flags at run time
+    }
+    #undef IDEAL_SCAN
+    
+    // put the noted pairs into scanning order for adjust_xyz()
+    sort_pairs();
     
     // normalise strictness (largest is 1.0)
     if (Maxstrict>DBL_EPSILON) Strimat/=Maxstrict;
@@ -544,6 +634,22 @@ void Steric_::ideal_dist(const Trimat_& Dista, const Fakebeta_& Fakebeta,
 }
 // END of ideal_dist()
 
+/* refresh(): brings the distances up to date and calls ideal_dist()
+ * in one go. Dista is recalculated from Model through Distcache,
+ * Fakebeta is updated unless Checkflags contains BOND. The rest
+ * of the arguments are passed on to ideal_dist().
+ */
+void Steric_::refresh(const Points_& Model, Distcache_& Distcache, Trimat_& Dista, 
+	Fakebeta_& Fakebeta, const Restraints_& Restraints, const Polymer_& Polymer, 
+	const Pieces_& Pieces, int Checkflags, Scores_* Scores, Viollist_ *Vl)
+{
+    Distcache.dist_mat2(Model, Dista);
+    if (!(Checkflags & BOND))
+	Fakebeta.update(Dista, Polymer, true);	// C-beta distances on demand
+    ideal_dist(Dista, Fakebeta, Restraints, Polymer, Pieces, Checkflags, Scores, Vl);
+}
+// END of refresh()
+
 // ---- Violation assessment ----
 
 /* reset_viol(): sets the score normalisation factors (the appropriate
@@ -560,7 +666,7 @@ void Steric_::reset_viol(const Restraints_& Restraints, int Size, Scores_& Score
     float Rwgt=0.0;
     if (Restraints.restr_no())
     {
-	Clist1_<Restr_> Rlist(Restraints.ext_restr());  // iterator
+	Cvlist_<Restr_> Rlist(Restraints.ext_restr());  // iterator
 	for (Rlist.begin(); Rlist!=NULL; Rlist++)
 	    Rwgt+=Rlist->strict();
     }
@@ -622,13 +728,28 @@ void Steric_::adjust_dist(Trimat_& Dista, const Pieces_& Pieces,
  * Eps is the relative stress change.
  * Returns the final stress or a negative float on error.
  * Also sets the Noconv int variable to non-0 if the Spectral Gradient
- * did not converge.
+ * did not converge. The coordinates may also be supplied in a
+ * Coords_ object which avoids copying them around.
  * In the second overlaid version, the cluster layout is in Pieces
  * and Checkflags tells the routine what to update (uses Willie's
  * simple but efficient "pairwise displacement" optimisation).
  * No value returned.
  */
 float Steric_::adjust_xyz(Points_& Model, int Maxiter, float Eps, int& Noconv)
+{
+    if (!Model.dim())
+    {
+	cerr<<"\n? Steric_::adjust_xyz(SPECGRAD): Dim mismatch among points\n";
+	Noconv=1;
+	return(-2.0);
+    }
+    Xyz.get(Model);
+    float Stress=adjust_xyz(Xyz, Maxiter, Eps, Noconv);
+    Xyz.put(Model);
+    return(Stress);
+}
+
+float Steric_::adjust_xyz(Coords_& Model, int Maxiter, float Eps, int& Noconv)
 {
     // sanity checks
     Noconv=1;
@@ -661,8 +782,63 @@ float Steric_::adjust_xyz(Points_& Model, int Maxiter, float Eps, int& Noconv)
     return(Stress);
 }
 
+/* adjust_scan(): the pair scan of the pairwise adjust_xyz(). The Clus
+ * template parameter is the cluster check (WITHIN, BETWEEN or ALL),
+ * so that it is resolved at compile time. Visits the pairs up to the
+ * (Dmax-1)-th diagonal, only the ones noted by ideal_dist() if Sparse
+ * is true, and passes them to pair_displ() with the workspace Dvec.
+ * Returns the number of displaced pairs. Private
+ */
+template <int Clus>
+int Steric_::adjust_scan(const Trimat_& Dista, const Pieces_& Pieces, 
+	unsigned int Dmax, bool Sparse, Vector_& Dvec)
+{
+    register unsigned int d, i, j, p, Size=Xyz.len();
+    register int Cluno;
+    int Violno=0;
+    
+    if (Sparse)
+    {
+	// only the pairs noted by ideal_dist(), in the same order
+	for (p=0; p<Adjno; p++)
+	{
+	    d=Adjpair[p]/Adjsize; i=Adjpair[p]%Adjsize;
+	    if (d>=Dmax) break;
+	    j=i-d;
+	    
+	    if (Clus!=ALL)
+	    {
+		Cluno=Pieces.members(i, j);
+		if (((Clus & WITHIN) && Cluno<0) || ((Clus & BETWEEN) && Cluno>=0))
+		    continue;
+	    }
+	    Violno+=pair_displ(Dista, i, j, Dvec);
+	}
+	return(Violno);
+    }
+    
+    for (d=1; d<Dmax; d++)
+    {
+	for (i=d; i<Size; i++)
+	{
+	    j=i-d;
+	    
+	    // check if i,j are good pairs for the adjustment
+	    if (Clus!=ALL)
+	    {
+		Cluno=Pieces.members(i, j);
+		if (((Clus & WITHIN) && Cluno<0) || ((Clus & BETWEEN) && Cluno>=0))
+		    continue;
+	    }
+	    Violno+=pair_displ(Dista, i, j, Dvec);
+	}		/* for i */
+    }	    /* for d */
+    return(Violno);
+}
+// END of adjust_scan()
+
 void Steric_::adjust_xyz(const Trimat_& Dista, Points_& Model,
-    const Pieces_& Pieces, int Checkflags) const
+    const Pieces_& Pieces, int Checkflags)
 {
     /* don't do anything if there's only 1 cluster and BETWEEN was prescribed */
     if (Pieces.clu_no()<=1 && (Checkflags & ALL)==BETWEEN) return;
@@ -670,7 +846,7 @@ void Steric_::adjust_xyz(const Trimat_& Dista, Points_& Model,
     // store original Model mask and switch all vectors ON
     Bits_ Oldmask=Model.mask(true);
     
-    register unsigned int d, i, j, Rno=Model.len()-2, Dim=Model.dim();
+    register unsigned int i, k, Rno=Model.len()-2, Dim=Model.dim();
     if (!Dim)
     {
 	cerr<<"\n? Steric_::adjust_xyz(): Dim mismatch among points\n";
@@ -680,20 +856,18 @@ void Steric_::adjust_xyz(const Trimat_& Dista, Points_& Model,
 	return;
     }
 
-    // displacement vectors and adjustment weighting
-    static Points_ Displ, Maxdispl, Newmodel;
-    static Array_<float> Adjwgt, Maxdisplen2;
-    
+    /* column-wise copy of the coordinates, zeroed displacement vectors
+     * and adjustment weighting (workspace members)
+     */
+    Xyz.get(Model);
     Displ.len_dim(Rno+2, Dim); Maxdispl.len_dim(Rno+2, Dim);
-    Newmodel.len_dim(Rno+2, Dim);
-    for (i=0; i<Rno+2; i++)
-    { Displ[i].set_values(); Maxdispl[i].set_values(); }
     Adjwgt.len(Rno+2); Adjwgt.set_values(0.0);
     Maxdisplen2.len(Rno+2); Maxdisplen2.set_values(0.0);
     
-    int Cluno, Violno=0;
-    register float Factor, Str, Dsplen2;
-    Vector_ Half(Dim), Dvec(Dim);   // midpoint and current displacement
+    int Violno=0;
+    register float Dsplen2;
+    register double Scale, Len2, *Xk;
+    Dvec.dim(Dim);   // current displacement
     
     // checkflag check
     if (!(Checkflags & ALL))   // no clus info, reset to ALL
@@ -702,57 +876,15 @@ void Steric_::adjust_xyz(const Trimat_& Dista, Points_& Model,
 	Checkflags|=ALL;
     }
     
-    // scan distances, adjust violations 
-    for (d=1; d<((Checkflags & BOND)? 3: Rno+2); d++)
+    // scan distances, adjust violations (cluster check resolved at compile time)
+    unsigned int Dmax=(Checkflags & BOND)? 3: Rno+2;
+    bool Sparse=bool((Checkflags & SPARSE) && Adjsize==Rno+2);
+    switch(Checkflags & ALL)
     {
-	for (i=d; i<Rno+2; i++)
-	{
-	    j=i-d;
-	    
-	    // check if i,j are good pairs for the adjustment
-	    if ((Checkflags & ALL)!=ALL)
-	    {
-		Cluno=Pieces.members(i, j);
-		if ((Checkflags & WITHIN) && Cluno<0 || (Checkflags & BETWEEN) && Cluno>=0)
-		    continue;
-	    }
-	    
-	    Str=Strimat[i][j];	// strictness 
-	    if (Str<=0.0) continue; // no displacement
-	    
-	    Factor=(Dista[i][j]<DBL_EPSILON)? 10.0: Idist[i][j]/sqrtf(float(Dista[i][j]));
-	    if (Factor<=0.0 || (Factor>0.99 && Factor<1.01))
-		continue;	// no violation
-	    
-	    // limit extent of adjustment
-	    if (Factor<0.1) Factor=0.1;
-	    else if (Factor>10.0) Factor=10.0;
-
-	    /* get weighted average displacement for each point
-	     * and find the maximal displacement
-	     */
-	    Half=Model[i]; Half+=Model[j];
-	    Half*=0.5;		// Half=(Model[i]+Model[j])/2.0;
-	    Dvec=Model[i]-Half; 
-	    Dvec*=Str*(Factor-1.0); // for weighting
-	    
-	    // store maximal displacement (premul by Str)
-	    Dsplen2=Dvec.vec_len2();	// squared norm will do
-	    if (Dsplen2>Maxdisplen2[i])
-	    {
-		Maxdispl[i]=Dvec; Maxdisplen2[i]=Dsplen2;
-	    }
-	    if (Dsplen2>Maxdisplen2[j])
-	    {
-		Maxdispl[j]=Dvec; Maxdisplen2[j]=Dsplen2;
-	    }
-
-	    // average displacements (weighted by strictness)
-	    Displ[i]+=Dvec; Adjwgt[i]+=Str;
-	    Displ[j]-=Dvec; Adjwgt[j]+=Str;
-	    Violno++;
-	}		/* for i */
-    }	    /* for d */
+	case WITHIN: Violno=adjust_scan<WITHIN>(Dista, Pieces, Dmax, Sparse, Dvec); break;
+	case BETWEEN: Violno=adjust_scan<BETWEEN>(Dista, Pieces, Dmax, Sparse, Dvec); break;
+	default: Violno=adjust_scan<ALL>(Dista, Pieces, Dmax, Sparse, Dvec); break;
+    }
 
     // everything was OK
     if (!Violno)
@@ -761,24 +893,27 @@ void Steric_::adjust_xyz(const Trimat_& Dista, Points_& Model,
 	return;
     }
     
-    // apply the displacements to the model
+    // apply the displacements to the coordinate copy
+    Coords_ *Jump;
     for (i=0; i<Rno+2; i++)
     {
 	if (Adjwgt[i]>DBL_EPSILON)  // Vector_ division has this limit, too
 	{
-	    Dsplen2=Displ[i].vec_len2();
+	    Len2=0.0;
+	    for (k=0; k<Dim; k++) Len2+=Displ.col(k)[i]*Displ.col(k)[i];
+	    Dsplen2=Len2;
 	    if (25.0*Dsplen2<Maxdisplen2[i])	    // frustrated: avg. 5 times less than max
-	    {
-		Maxdispl[i]/=Adjwgt[i];
-		Newmodel[i]=Model[i]+Maxdispl[i];   // use maximal displacement to "jump"
-	    }
+		Jump=&Maxdispl;	// use maximal displacement to "jump"
 	    else
+		Jump=&Displ;	// less frustrated, use avg. displacement
+	    Scale=1.0/Adjwgt[i];
+	    for (k=0; k<Dim; k++)
 	    {
-		Displ[i]/=Adjwgt[i];
-		Newmodel[i]=Model[i]+Displ[i];	    // less frustrated, use avg. displacement
+		Xk=Jump->col(k);
+		Xk[i]*=Scale;
+		Xyz.col(k)[i]+=Xk[i];
 	    }
 	}
-	else Newmodel[i]=Model[i];
     }
 
     /* If the adjustment was to be done between clusters, then translate
@@ -786,50 +921,117 @@ void Steric_::adjust_xyz(const Trimat_& Dista, Points_& Model,
      */
     if ((Checkflags & ALL) == BETWEEN)
     {
-	Vector_ Mctr(Dim), Dctr(Dim), W(Rno+2);
-	Hirot_ Hr;
-	Bits_ Clumask;
-	register unsigned int ci;
+	register unsigned int ci, Clulen;
 	bool Rotate;
+	Ptview_ Mclu, Nclu;	// the current cluster in Model and Newmodel
+	
+	Newmodel.len_dim(Rno+2, Dim);
+	Xyz.put(Newmodel);
+	Cluwgt.dim(Rno+2); Cluwgt.set_values();
 	
 	// adjust clusters (uses non-overlap+full-coverage implicitly)
 	for (ci=0; ci<Pieces.clu_no(); ci++)
 	{
-	    Clumask=Pieces.clus(ci);
-	    Rotate=bool(Clumask.on_no()>Dim);	// makes sense to rotate
-	    Model.mask(Clumask); Newmodel.mask(Clumask);
+	    Clulen=Pieces.clu_len(ci);
+	    Rotate=bool(Clulen>Dim);	// makes sense to rotate
+	    Mclu=Ptview_(Model, Pieces.clu_idx(ci), Clulen);
+	    Nclu=Ptview_(Newmodel, Pieces.clu_idx(ci), Clulen);
 	    
 	    if (Rotate) // prepare weighted rotation
 	    {
 		// larger displacements have larger weight
-		for (i=0; i<Clumask.on_no(); i++)
-		    W[i]=0.01+Displ[i].vec_len2();
-	    	Mctr=Model.centroid(W);
-	    	Dctr=Newmodel.centroid(W);
+		for (i=0; i<Clulen; i++)
+		{
+		    Len2=0.0;
+		    for (k=0; k<Dim; k++) Len2+=Displ.col(k)[i]*Displ.col(k)[i];
+		    Cluwgt[i]=0.01+Len2;
+		}
+	    	Mctr=Mclu.centroid(Cluwgt);
+	    	Dctr=Nclu.centroid(Cluwgt);
 	    }
 	    else    // no weights, simple shift at end
 	    {
-	    	Mctr=Model.centroid();
-	    	Dctr=Newmodel.centroid();
+	    	Mctr=Mclu.centroid();
+	    	Dctr=Nclu.centroid();
 	    }
-	    Model-=Mctr;
+	    Mclu-=Mctr;
 	    
 	    if (Rotate)	// for clusters larger than the current simplex
 	    {
-		Newmodel-=Dctr;
-		Hr.best_rot(Model, Newmodel, W);
-		Model*=Hr.rot_matrix();
+		Nclu-=Dctr;
+		Hr.best_rot(Mclu, Nclu, Cluwgt);
+		Mclu*=Hr.rot_matrix();
 	    }
 	    
 	    // translate the model cluster to the new centroid
-	    Model+=Dctr;
+	    Mclu+=Dctr;
 	}
     }
     else    // not BETWEEN: traditional non-rigid adjustment
-	Model=Newmodel;
+	Xyz.put(Model);
 
     Model.mask(Oldmask);
 }
 // END of adjust_xyz()
 
+/* pair_displ(): the pairwise displacement step of adjust_xyz()
+ * for the (i, j) pair. Adds the displacements to Displ, updates
+ * Maxdispl and the weights. Dvec is workspace (Dim long).
+ * Returns 1 if the pair was displaced, 0 if there was no violation.
+ */
+int Steric_::pair_displ(const Trimat_& Dista, unsigned int i, unsigned int j, 
+	Vector_& Dvec)
+{
+    register unsigned int k, Dim=Xyz.dim();
+    register float Factor, Str, Dsplen2;
+    register double Scale, Half, Len2, *Xk;
+    
+    Str=Strimat[i][j];	// strictness 
+    if (Str<=0.0) return(0); // no displacement
+    
+    Factor=(Dista[i][j]<DBL_EPSILON)? 10.0: Idist[i][j]/sqrtf(float(Dista[i][j]));
+    if (Factor<=0.0 || (Factor>0.99 && Factor<1.01))
+	return(0);	// no violation
+    
+    // limit extent of adjustment
+    if (Factor<0.1) Factor=0.1;
+    else if (Factor>10.0) Factor=10.0;
+
+    /* get weighted average displacement for each point
+     * and find the maximal displacement
+     */
+    Scale=Str*(Factor-1.0);	// for weighting
+    Len2=0.0;
+    for (k=0; k<Dim; k++)
+    {
+	Xk=Xyz.col(k);
+	Half=(Xk[i]+Xk[j])*0.5;
+	Dvec[k]=(Xk[i]-Half)*Scale;
+	Len2+=Dvec[k]*Dvec[k];
+    }
+    
+    // store maximal displacement (premul by Str)
+    Dsplen2=Len2;	// squared norm will do
+    if (Dsplen2>Maxdisplen2[i])
+    {
+	for (k=0; k<Dim; k++) Maxdispl.col(k)[i]=Dvec[k];
+	Maxdisplen2[i]=Dsplen2;
+    }
+    if (Dsplen2>Maxdisplen2[j])
+    {
+	for (k=0; k<Dim; k++) Maxdispl.col(k)[j]=Dvec[k];
+	Maxdisplen2[j]=Dsplen2;
+    }
+
+    // average displacements (weighted by strictness)
+    for (k=0; k<Dim; k++)
+    {
+	Xk=Displ.col(k);
+	Xk[i]+=Dvec[k]; Xk[j]-=Dvec[k];
+    }
+    Adjwgt[i]+=Str; Adjwgt[j]+=Str;
+    return(1);
+}
+// END of pair_displ()
+
 // ==== END OF FUNCTIONS Steric.c++ ====
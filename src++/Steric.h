@@ -15,6 +15,9 @@
 
 #include "Trimat.h"
 #include "Points.h"
+#include "Coords.h"
+#include "Distcache.h"
+#include "Hirot.h"
 
 // ---- MODULE HEADERS ----
 
@@ -44,6 +47,17 @@ class Steric_
     Specgrad_ Sp;   // spectral gradient for the whole lot
     int Lastflags;  // the last adjustments
     
+    // workspace for the majorization adjust_xyz()
+    Coords_ Xyz, Displ, Maxdispl;	// coordinates and displacement vectors
+    Points_ Newmodel;	// target of the rigid-body cluster moves
+    Vector_ Dvec, Mctr, Dctr, Cluwgt;	// displacement, centroids and weights
+    Hirot_ Hr;	// rotation of the rigid-body cluster moves
+    Array_<float> Adjwgt, Maxdisplen2;	// adjustment weighting
+    
+    // pairs the last ideal_dist() may want adjusted (see SPARSE below)
+    Array_<unsigned long> Adjpair;	// d*(Rno+2)+i for the pair (i, i-d)
+    unsigned int Adjno, Adjsize;	// no. of pairs, Rno+2 when they were made
+    
     public:
     /* The actions of the adjustment routines are controlled by the
      * following flags:-
@@ -56,10 +70,13 @@ class Steric_
      * RESTR: do all restraints (==RINT | REXT)
      * BOND: do the virtual CA:CA bonds and CA(i):CA(i+2) only
      * SCORE: generate scores
+     * SPARSE: the pairwise adjust_xyz() visits only the pairs noted
+     *	by the last ideal_dist() instead of scanning the whole matrix.
+     *	Dista must be the same as in that ideal_dist() call.
      * The flags may be OR-ed together.
      */
     enum Adjflags_ {WITHIN=1, BETWEEN=2, ALL=3, SPECGRAD=4, 
-	    RINT=8, REXT=16, RESTR=24, BOND=32, SCORE=64};
+	    RINT=8, REXT=16, RESTR=24, BOND=32, SCORE=64, SPARSE=128};
     
     // methods
     public:
@@ -69,7 +86,9 @@ class Steric_
      * There are 2 extra points for the N/C-terminal moieties.
      */
     Steric_(unsigned int Resno=10): 
-	Strimat(Resno+2), Idist(Resno+2), Lastflags(0) {}
+	Strimat(Resno+2), Idist(Resno+2), Lastflags(0), 
+	Adjwgt(Resno+2), Maxdisplen2(Resno+2), 
+	Adjpair(Resno+2), Adjno(0), Adjsize(0) {}
     
 	// Setup
     /* setup(): Changes the size of the matrices so that
@@ -82,9 +101,16 @@ class Steric_
 	unsigned int Oldrno=Idist.rno()-2;	// old size
 	Strimat.set_size(Rno+2);
 	Idist.set_size(Rno+2);
+	Adjwgt.len(Rno+2); Maxdisplen2.len(Rno+2);
 	return(Oldrno);
     }
     
+    /* spec_threads(): sets the maximal number of threads used by
+     * the Spectral Gradient refinement to Thrno (cf. Specgrad_::thread_no()).
+     * Returns the old value.
+     */
+    unsigned int spec_threads(unsigned int Thrno) { return(Sp.thread_no(Thrno)); }
+    
 	// Ideal distances
     /* ideal_dist(): fills up the ideal distance matrix within the
      * calling object. Dista is the actual CA:CA distance matrix (squared), 
@@ -100,6 +126,18 @@ class Steric_
 	    const Restraints_& Restraints, const Polymer_& Polymer, 
 	    const Pieces_& Pieces, int Checkflags, Scores_* Scores=NULL, Viollist_ *Vl=NULL);
 
+    /* refresh(): brings the distances up to date and calls ideal_dist()
+     * in one go, as needed before each adjustment in Euclidean space.
+     * The squared CA:CA distances in Dista are recalculated from Model
+     * through Distcache (cf. Distcache_::dist_mat2()) and Fakebeta is
+     * updated from them unless Checkflags contains BOND (the bond checks
+     * don't look at the C-betas). The rest of the arguments are passed on
+     * to ideal_dist(). The results are the same as with separate calls.
+     */
+    void refresh(const Points_& Model, Distcache_& Distcache, Trimat_& Dista, 
+	    Fakebeta_& Fakebeta, const Restraints_& Restraints, const Polymer_& Polymer, 
+	    const Pieces_& Pieces, int Checkflags, Scores_* Scores=NULL, Viollist_ *Vl=NULL);
+
 	// Violation assessment
     /* reset_viol(): sets the score normalisation factors (the appropriate
      * sums of various restraint weights) in Scores.
@@ -124,15 +162,20 @@ class Steric_
      * Eps is the relative stress change.
      * Returns the final stress or a negative float on error.
      * Also sets the Noconv int variable to non-0 if the Spectral Gradient
-     * did not converge.
+     * did not converge. The coordinates may also be supplied in a
+     * Coords_ object which avoids copying them around.
      * In the second overlaid version, the cluster layout is in Pieces
      * and Checkflags tells the routine what to update (uses Willie's
      * simple but efficient "pairwise displacement" optimisation).
+     * If SPARSE is set in Checkflags, then only the pairs which had
+     * a violation or a zero distance in the last ideal_dist() are visited,
+     * with the same result as the full scan.
      * No value returned.
      */
     float adjust_xyz(Points_& Model, int Maxiter, float Eps, int& Noconv);
+    float adjust_xyz(Coords_& Model, int Maxiter, float Eps, int& Noconv);
     void adjust_xyz(const Trimat_& Dista, Points_& Model,
-	const Pieces_& Pieces, int Checkflags) const;
+	const Pieces_& Pieces, int Checkflags);
     
 	// Auxiliaries
     private:
@@ -140,6 +183,18 @@ class Steric_
     static float make_iddist(float Actual, float Low, float Up);
     static float limit_iddist(float Ideal, const Restraints_& Restraints, 
 	    unsigned int i, unsigned int j);
+    void add_pair(unsigned int i, unsigned int j);
+    void sort_pairs();
+    template <int Flags> 
+    float ideal_scan(const Trimat_& Dista, const Fakebeta_& Fakebeta, 
+	    const Restraints_& Restraints, const Polymer_& Polymer, 
+	    const Pieces_& Pieces, const Bits_& Lok, int Runflags, float Maxstrict, 
+	    Scores_* Scores, Viollist_ *Vl);
+    template <int Clus> 
+    int adjust_scan(const Trimat_& Dista, const Pieces_& Pieces, 
+	    unsigned int Dmax, bool Sparse, Vector_& Dvec);
+    int pair_displ(const Trimat_& Dista, unsigned int i, unsigned int j, 
+	    Vector_& Dvec);
 
 };
 // END OF CLASS Steric_
@@ -8,6 +8,63 @@
 
 #include "Tangles.h"
 
+// ---- LOCAL DEFINITIONS ----
+
+/* The chain is divided into blocks of TBLOCKLEN consecutive points
+ * for the bounding box tests. The tetrahedron boxes are enlarged by
+ * TBOXSLACK*(1+largest side) so that the tolerances of the SVD-based
+ * containment test cannot make a rejected pair a tangle.
+ */
+#define TBLOCKLEN 8
+#define TBOXSLACK 0.01
+
+// ==== STATIC FUNCTIONS ====
+
+/* Boxes are stored as 6 doubles: the 3 lower limits and then the
+ * 3 upper limits of the coordinates.
+ */
+
+/* box_init(): makes Box empty. */
+static void box_init(double *Box)
+{
+    Box[0]=Box[1]=Box[2]=HUGE_VAL;
+    Box[3]=Box[4]=Box[5]=-HUGE_VAL;
+}
+/* END of box_init() */
+
+/* box_add(): enlarges Box so that it contains the 3D point V. */
+static inline void box_add(double *Box, const Vector_& V)
+{
+    register unsigned int d;
+    for (d=0; d<3; d++)
+    {
+	if (V[d]<Box[d]) Box[d]=V[d];
+	if (V[d]>Box[d+3]) Box[d+3]=V[d];
+    }
+}
+/* END of box_add() */
+
+/* box_apart(): returns true if the boxes B1 and B2 do not overlap. */
+static inline bool box_apart(const double *B1, const double *B2)
+{
+    return(B1[3]<B2[0] || B2[3]<B1[0] || B1[4]<B2[1] || B2[4]<B1[1] ||
+	B1[5]<B2[2] || B2[5]<B1[2]);
+}
+/* END of box_apart() */
+
+/* edge_apart(): returns true if the segment between the 3D points
+ * P and Q is not in the box Box.
+ */
+static inline bool edge_apart(const Vector_& P, const Vector_& Q, const double *Box)
+{
+    register unsigned int d;
+    for (d=0; d<3; d++)
+	if ((P[d]<Box[d] && Q[d]<Box[d]) || (P[d]>Box[d+3] && Q[d]>Box[d+3]))
+	    return(true);
+    return(false);
+}
+/* END of edge_apart() */
+
 // ==== METHODS ====
 
 // ---- Update ----
@@ -110,12 +167,15 @@ unsigned int Tangles_::tangle_elim(const Pieces_& Pieces, Points_& Xyz,
  * and the violating pairs are not saved. In this case, 
  * find_tangles() returns right after the first tangle has been seen
  * and does not perform an exhaustive check.
+ * In 3D the segments are tested only against those tetrahedra
+ * which overlap with their bounding boxes, and the tetrahedra
+ * are decomposed only if there is such a segment.
  * Return value: the number of entanglements found. Private
  */
 unsigned int Tangles_::find_tangles(const Pieces_& Pieces, Points_& Xyz, 
 	int Adjust)
 {
-    Clist1_<Sstr_> Slist=Pieces.secs();    // secstr list iterator
+    Cvlist_<Sstr_> Slist=Pieces.secs();    // secstr list iterator
     unsigned int Slen=Slist.len(), Cluno=Pieces.clu_no();	// no. of secstr items and clusters
     
     if (Adjust) Viols.clear();    // no entanglements yet
@@ -133,7 +193,9 @@ unsigned int Tangles_::find_tangles(const Pieces_& Pieces, Points_& Xyz,
     Bits_ Clash(Cluno);	    // keep track of clashes
     Bits_ Sheetmask;	    // stores mask for current sheet (overlap check)
     bool Issheet;	// true if current secstr is sheet (for overlap checks)
-    
+    bool Made;	    // true if the current tetrahedron has been decomposed
+
+    make_boxes(Pieces, Xyz);
     for (Slist.begin(), Si=0; Si<Slen; Si++, Slist++)	    // all secondary structure segments
     {
 	// obtain array of tetrahedra superimposed on current secstr element
@@ -146,10 +208,9 @@ unsigned int Tangles_::find_tangles(const Pieces_& Pieces, Points_& Xyz,
 	
 	for (Ti=0; Ti<Thedra.len(); Ti++)   // scan all tetrahedra
 	{
-	    // perform SVD on the current tetrahedron
-	    if (make_thedron(Xyz, Thedra[Ti]))
-		continue;   // cannot make it (flat?)
-		
+	    Made=false;
+	    if (Useboxes) thedron_box(Xyz, Thedra[Ti]);
+
 	    // check all segments from Si+1 onward
 	    for (Gi=Si+1; Gi<Cluno; Gi++)
 	    {
@@ -162,7 +223,18 @@ unsigned int Tangles_::find_tangles(const Pieces_& Pieces, Points_& Xyz,
 		if (Issheet && 
 		    (Sheetmask.on_no()+Pieces.clus(Gi).on_no())!=(Sheetmask | Pieces.clus(Gi)).on_no())
 			continue;
-		
+
+		if (Useboxes && box_apart(Thbox, &Clubox[6*Gi]))
+		    continue;	// too far from the tetrahedron
+
+		// perform SVD on the current tetrahedron if not done yet
+		if (!Made)
+		{
+		    if (make_thedron(Xyz, Thedra[Ti]))
+			break;   // cannot make it (flat?)
+		    Made=true;
+		}
+
 		if (contain_segment(Pieces.clus(Gi), Xyz, Thedra[Ti].P1))
 		{
 		    // violation!
@@ -196,8 +268,7 @@ void Tangles_::adjust_tangles(const Pieces_& Pieces, Points_& Xyz, double Tadj)
     if (!Viols) return;	    // no violations
     
     unsigned int Cluno=Pieces.clu_no(), Dim=Xyz.dim();
-    static Bits_ Oldmask;
-    Oldmask=Xyz.mask();	    // update on each entry...
+    Bits_ Oldmask=Xyz.mask();
     
     // set flags in Vmask for all entangled clusters in this adjustment round
     Bits_ Vmask(Cluno); Vmask.set_values(false);
@@ -235,7 +306,7 @@ void Tangles_::adjust_tangles(const Pieces_& Pieces, Points_& Xyz, double Tadj)
     Tmask|=Vmask;   // update flags for centroids
 
     // generate pairwise displacements
-    static Vector_ H;	// pointing from Idx1:Idx2 midpoint to Idx1
+    Vector_ H;	// pointing from Idx1:Idx2 midpoint to Idx1
     double Lh;		// the length of H
     
     Dnos.set_values(0);
@@ -254,7 +325,7 @@ void Tangles_::adjust_tangles(const Pieces_& Pieces, Points_& Xyz, double Tadj)
     }
     
     // apply displacements to coords and centroids
-    static Vector_ Adj;
+    Vector_ Adj;
     Adj.dim(Dim);
     for (i=0; i<Cluno; i++)
     {
@@ -275,7 +346,8 @@ void Tangles_::adjust_tangles(const Pieces_& Pieces, Points_& Xyz, double Tadj)
  * contains a bit of the segment represented by its membership mask
  * Segmask. The coordinates in Xyz are supposed to have been masked
  * to "fully active" before the call. Oidx holds the index of the origin
- * of the tetrahedron.
+ * of the tetrahedron. If the bounding boxes are used, then
+ * the segment bits outside the box of the tetrahedron are skipped.
  * Return value: 1 if containment was detected, 0 if not,  -1 on error.
  * Private
  */
@@ -288,12 +360,15 @@ int Tangles_::contain_segment(const Bits_& Segmask, const Points_& Xyz, unsigned
 	return(-1);
     }
     
-    static Vector_ Sprev(4), Snext(4);
+    double Sbuf[8], *Sprev=Sbuf, *Snext=Sbuf+4, *Stmp;	// lin.comb. coefficients
     register unsigned int k;
     int Start=0;
-    
+    bool Prevok=false;	// true if Sprev belongs to the (k-1)-th point
+
     /* The following cycle walks along the whole chain, and
      * skips discontinuities (useful for sheet clusters).
+     * The lin.comb. coefficients are made only for the ends
+     * of those bits which may be in the tetrahedron.
      */
     for (k=0; k<Xyz.len(); k++)
     {
@@ -301,16 +376,22 @@ int Tangles_::contain_segment(const Bits_& Segmask, const Points_& Xyz, unsigned
 	{
 	    if (!Start)	    // start new contiguous region
 	    {
-		Start=1;
-		make_svect(Xyz[k], Xyz[Oidx], Sprev);
+		Start=1; Prevok=false;
 		continue;
 	    }
 	    else
 	    {
+		if (Useboxes && (!Blkhit.get_bit((k-1)/TBLOCKLEN) ||
+			edge_apart(Xyz[k-1], Xyz[k], Thbox)))
+		{
+		    Prevok=false; continue;	// outside
+		}
+		if (!Prevok) make_svect(Xyz[k-1], Xyz[Oidx], Sprev);
 		make_svect(Xyz[k], Xyz[Oidx], Snext);
 		if (th_viol(Sprev, Snext))
 		    return(1);	// containment detected, no more needs to be done
-		Sprev=Snext;	// otherwise, step along
+		Stmp=Sprev; Sprev=Snext; Snext=Stmp;	// otherwise, step along
+		Prevok=true;
 	    }
 	}
 	else Start=0;	// reset
@@ -319,12 +400,71 @@ int Tangles_::contain_segment(const Bits_& Segmask, const Points_& Xyz, unsigned
 }
 // END of contain_segment()
 
+// ---- Bounding boxes ----
+
+/* make_boxes(): if Xyz is 3-dimensional, then the bounding boxes of
+ * the clusters in Pieces and of the chain blocks (TBLOCKLEN+1 points
+ * each, the last point being the first of the next block) are calculated
+ * and Useboxes is set to true. Otherwise Useboxes will be false (the
+ * SVD-based tests do not decide containment by the boxes in more
+ * dimensions). Xyz must be fully active. Private
+ */
+void Tangles_::make_boxes(const Pieces_& Pieces, const Points_& Xyz)
+{
+    if (!(Useboxes=(Xyz.dim()==3))) return;
+
+    register unsigned int k, Gi, b;
+    unsigned int Len=Xyz.len(), Cluno=Pieces.clu_no(),
+	Blkno=(Len>1)? (Len-2)/TBLOCKLEN+1: 1;
+
+    Clubox.len(6*Cluno); Blkbox.len(6*Blkno); Blkhit.len(Blkno);
+    for (Gi=0; Gi<Cluno; Gi++) box_init(&Clubox[6*Gi]);
+    for (b=0; b<Blkno; b++) box_init(&Blkbox[6*b]);
+
+    for (k=0; k<Len; k++)
+    {
+	for (Gi=0; Gi<Cluno; Gi++)
+	    if (Pieces.clus(Gi).get_bit(k)) box_add(&Clubox[6*Gi], Xyz[k]);
+
+	b=k/TBLOCKLEN;
+	if (b<Blkno) box_add(&Blkbox[6*b], Xyz[k]);
+	if (b && !(k%TBLOCKLEN)) box_add(&Blkbox[6*(b-1)], Xyz[k]);	// shared end point
+    }
+}
+// END of make_boxes()
+
+/* thedron_box(): calculates the (slightly enlarged) bounding box of the
+ * tetrahedron with the apices indexed by Thidx and marks the chain
+ * blocks overlapping with it in Blkhit. Private
+ */
+void Tangles_::thedron_box(const Points_& Xyz, const Thidx_& Thidx)
+{
+    register unsigned int d, b;
+    register double Side, Maxside=0.0;
+
+    box_init(Thbox);
+    box_add(Thbox, Xyz[Thidx.P1]); box_add(Thbox, Xyz[Thidx.P2]);
+    box_add(Thbox, Xyz[Thidx.P3]); box_add(Thbox, Xyz[Thidx.P4]);
+    for (d=0; d<3; d++)
+	if ((Side=Thbox[d+3]-Thbox[d])>Maxside) Maxside=Side;
+    Side=TBOXSLACK*(1.0+Maxside);
+    for (d=0; d<3; d++)
+    {
+	Thbox[d]-=Side; Thbox[d+3]+=Side;
+    }
+
+    for (b=0; b<Blkhit.len(); b++)
+	Blkhit.set_bit(b, !box_apart(Thbox, &Blkbox[6*b]));
+}
+// END of thedron_box()
+
 // ---- Tetrahedra ----
 
 /* make_thedron(): constructs a tetrahedron out of the vectors
  * in Xyz indexed by the P1..P4 indices in Thidx, 
  * the origin is at Thidx.P1 .
- * Performs an SVD and puts the result in Thsvd.
+ * Performs an SVD and puts the result in Thsvd. W and V are also
+ * copied into Thw and Thv for make_svect(), and U' into Thut in 3D.
  * Return value: 1 if an error occurred (iteration limit 
  * exceeded or the 4 vectors don't span a 3D space), 0 if
  * everything was fine. Private
@@ -340,8 +480,8 @@ int Tangles_::make_thedron(const Points_& Xyz, const Thidx_& Thidx)
 	return(1);
     }
     
-    static Matrix_ A(3); // always 3 columns: row no. varies
-    static Vector_ Colvec;  // used as a temporary
+    Matrix_ A(3); // always 3 columns: row no. varies
+    Vector_ Colvec;  // used as a temporary
     
     // init A: col vectors are [p1]-[p0], ...
     A.set_size(Dim, 3); Colvec.dim(Dim);
@@ -359,6 +499,12 @@ int Tangles_::make_thedron(const Points_& Xyz, const Thidx_& Thidx)
 	return(1);
     }
     
+    Thw.get(Thsvd.w()); Thv.get(Thsvd.v());
+    if (Dim==3)
+    {
+	Thut.get(Thsvd.u()); Thut=Thut.get_transpose();
+    }
+
     return(0);	// OK
 }
 // END of make_thedron()
@@ -367,15 +513,39 @@ int Tangles_::make_thedron(const Points_& Xyz, const Thidx_& Thidx)
  * factors with which the point Vec can be made up from the 4 position
  * vectors of a tetrahedron. Thsvd contains the SVD-decomposed
  * "tetrahedron matrix", Orig holds the coordinates of the
- * zeroth apex of the tetrahedron. Private
+ * zeroth apex of the tetrahedron. The equation is solved
+ * with the copies in Thw, Thv (and Thut in 3D) as in Svd_::lin_solve()
+ * but without temporary Vector_-s. Private
  */
-void Tangles_::make_svect(const Vector_& Vec, const Vector_& Orig, Vector_& S) const
+void Tangles_::make_svect(const Vector_& Vec, const Vector_& Orig, double *S) const
 {
-    static Vector_ Point, Sol3(3);
-    
-    Point=Vec; Point-=Orig; // Vec-Orig is the rhs. of the lincomb eqn.
-    Sol3=Thsvd.lin_solve(Point);	// get the 3 indep. coords
+    Vec3_ Sol3;
     
+    if (Vec.dim()==3)
+    {
+	Vec3_ Point(Vec); Point-=Vec3_(Orig);	// rhs. of the lincomb eqn.
+	Vec3_ Wub=Thut*Point;
+	register unsigned int j;
+	for (j=0; j<3; j++)
+	    if (Thw[j]==0.0) Wub[j]=0.0; else Wub[j]/=Thw[j];
+	Sol3=Thv*Wub;	// get the 3 indep. coords
+    }
+    else
+    {
+	// U'*(Vec-Orig) straight from Thsvd.u(), summed as in Svd_::utb()
+	const Matrix_& U=Thsvd.u();
+	register unsigned int i, j, Dim=Vec.dim();
+	register double Temp;
+	Vec3_ Wub;
+	for (j=0; j<3; j++)
+	{
+	    for (Temp=0.0, i=0; i<Dim; i++)
+		Temp+=U[i][j]*(Vec[i]-Orig[i]);
+	    if (Thw[j]!=0.0) Wub[j]=Temp/Thw[j];
+	}
+	Sol3=Thv*Wub;	// get the 3 indep. coords
+    }
+
     /* For traditional reasons, the 3 indep. coords go into the
      * coords 1..3 of S, and S[0] will be 1-(S1+S2+S3). This ordering
      * is probably not necessary...
@@ -406,7 +576,7 @@ void Tangles_::make_svect(const Vector_& Vec, const Vector_& Orig, Vector_& S) c
  * is at least partially contained by the tetrahedron), or
  * 0 if there is no containment. Private
  */
-int Tangles_::th_viol(const Vector_& Sprev, const Vector_& Snext) const
+int Tangles_::th_viol(const double *Sprev, const double *Snext) const
 {
     register double S12, Z0, Z1, Zlo, Zhi, Zmin, Zmax;
     register unsigned int i;
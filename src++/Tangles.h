@@ -22,8 +22,9 @@
 
 #include "Array.h"
 #include "Bits.h"
-#include "List1.h"
+#include "Vlist.h"
 #include "Points.h"
+#include "Vec3.h"
 #include "Svd.h"
 
 // ==== CLASSES ====
@@ -45,11 +46,18 @@ class Tangles_
 	Violpair_(): Idx1(0), Idx2(0) {}
     };
     
-    List1_<Violpair_> Viols;   // stores indices of entangled segments
+    Vlist_<Violpair_> Viols;   // stores indices of entangled segments
     Svd_ Thsvd;	// SVD decomposition of tetrahedra
-    Points_ Displ, Ctrs;	    // displacement and centroid vectors
+    Mat3_ Thut, Thv; Vec3_ Thw;	// U' (3D only), V and W of Thsvd (cf. make_thedron())
+Points_ Displ, Ctrs;	    // displacement and centroid vectors
     Array_<unsigned int> Dnos;	// number of displacements
     Bits_ Tmask;		// true for entangled segments (keep centroids)
+    
+    // bounding boxes for early rejection in 3D (cf. make_boxes())
+    Array_<double> Clubox, Blkbox;  // cluster and chain block boxes
+    double Thbox[6];	// box of the current tetrahedron
+    Bits_ Blkhit;	// chain blocks overlapping Thbox
+    bool Useboxes;	// true if the boxes above are valid
 
     // methods
     public:
@@ -61,7 +69,8 @@ class Tangles_
     Tangles_(const Pieces_& Pieces):
 	Viols(), Thsvd(3, 3), 
 	Displ(Pieces.clu_no()), Ctrs(Pieces.clu_no()),
-	Dnos(Pieces.clu_no()), Tmask(Pieces.clu_no()) {}
+	Dnos(Pieces.clu_no()), Tmask(Pieces.clu_no()), 
+	Useboxes(false) {}
     
 	// update
     /* update_pieces(): updates the internal data members so that tangle
@@ -105,11 +114,13 @@ class Tangles_
     unsigned int find_tangles(const Pieces_& Pieces, Points_& Xyz, int Adjust=0);
     void adjust_tangles(const Pieces_& Pieces, Points_& Xyz, double Tadj);
     int contain_segment(const Bits_& Segmask, const Points_& Xyz, unsigned int Oidx) const;
+    void make_boxes(const Pieces_& Pieces, const Points_& Xyz);
+    void thedron_box(const Points_& Xyz, const Thidx_& Thidx);
 
 	// tetrahedra
     int make_thedron(const Points_& Xyz, const Thidx_& Thidx);
-    void make_svect(const Vector_& Vec, const Vector_& Orig, Vector_& S) const;
-    int th_viol(const Vector_& Sprev, const Vector_& Snext) const;
+    void make_svect(const Vector_& Vec, const Vector_& Orig, double *S) const;
+    int th_viol(const double *Sprev, const double *Snext) const;
     
 };
 // END OF CLASS Tangles_
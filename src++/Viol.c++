@@ -12,6 +12,10 @@
 
 #include "Viol.h"
 
+// ---- PROTOTYPES ----
+
+extern "C" int descend_viol(const void *P1, const void *P2);
+
 // ==== METHODS ====
 
 // ==== Viol_ METHODS ====
@@ -57,37 +61,63 @@ int Viollist_::add_viol(const Viol_& V, float Minrelv)
      */
     if (Minrelv<0.0 || V.rel_viol()<Minrelv) return(0);
     
-    if (!Vl.len()) { Vl+=V; return(1); }    // list was empty: add first
-    
-    // find first item with a rel. violation smaller than the current one
-    for (Vl.begin(); Vl!=NULL && Vl->rel_viol()>V.rel_viol(); Vl++);
-    
-    Vl.insert(V);   // add new item before first smaller
+    Vl+=V;  // sorted when listed, see operator<<
     return(Vl.len());
 }
 // END of add_viol()
 
 /* write_file(): writes the contents of the calling object to
- * a file Outfile or to cout if Outfile==NULL or cannot be opened.
- * Return value: 1 if OK, 0 if written to cout.
+ * a file Outfile or to Out (cout by default) if Outfile==NULL
+ * or cannot be opened. Return value: 1 if OK, 0 if written to Out.
  */
-int Viollist_::write_file(const char *Outfile) const
+int Viollist_::write_file(const char *Outfile, ostream& Out) const
 {
-    if (Outfile==NULL) { cout<<(*this); return(0); }
+    if (Outfile==NULL) { Out<<(*this); return(0); }
     ofstream Outf(Outfile);
-    if (!Outf) { cout<<(*this); return(0); }
+    if (!Outf) { Out<<(*this); return(0); }
     Outf<<(*this); Outf.close(); return(1);
 }
 // END of write_file()
 
+/* Lists the violations in descending relative violation order.
+ * Violations with equal relative violations are listed
+ * in reverse order of their arrival (as if each had been inserted
+ * before the first violation not larger than itself).
+ */
 ostream& operator<<(ostream& Out, const Viollist_& Vl)
 {
-    Clist1_<Viol_> Cvl=Vl.Vl;
-    Out<<"# Restraint violations: "<<Cvl.len()<<endl;
+    register unsigned int i, Vno=Vl.Vl.len();
+    
+    Out<<"# Restraint violations: "<<Vno<<endl;
     Out<<"#     Atom pair     Type  Actual Ideal (Strict) Rel.viol Error\n";
-    for (Cvl.begin(); Cvl!=NULL; Cvl++)
-	Out<<(*Cvl);
+    if (!Vno) return(Out);
+    
+    // sort pointers to the violations instead of moving them around
+    const Viol_ **Vp=new const Viol_* [Vno];
+    for (i=0; i<Vno; i++) Vp[i]=&(Vl.Vl[i]);
+    qsort(Vp, Vno, sizeof(const Viol_*), descend_viol);
+    
+    for (i=0; i<Vno; i++)
+	Out<<(*Vp[i]);
+    delete [] Vp;
     return(Out);
 }
 
+/* descend_viol(): aux function to sort Viol_ pointers in descending
+ * relative violation order. Pointers to equal violations are sorted
+ * in descending address order, i.e. the later ones first (the
+ * violations are stored contiguously in arrival order).
+ * This function has C linkage.
+ */
+int descend_viol(const void *P1, const void *P2)
+{
+    const Viol_ *Vp1=*(const Viol_* const*)P1, *Vp2=*(const Viol_* const*)P2;
+    register float Rv1=Vp1->rel_viol(), Rv2=Vp2->rel_viol();
+    
+    if (Rv2>Rv1) return(1);
+    if (Rv2<Rv1) return(-1);
+    return((Vp2>Vp1)? 1: (Vp2<Vp1)? -1: 0);
+}
+// END of descend_viol()
+
 // ==== END OF METHODS Viol.c++ ====
@@ -16,7 +16,7 @@
 // ---- MODULES ----
 
 #include "String.h"
-#include "List1.h"
+#include "Vlist.h"
 
 /* NOTE: SGI provides single-precision floating point functions
  * such as sqrtf() etc. Some machines (SUNs in particular) don't
@@ -97,15 +97,16 @@ class Viol_
 };
 // END OF CLASS Viol_
 
-/* Class Viollist_: stores a list of violations in descending
- * relative violation order.
+/* Class Viollist_: stores a list of violations. The violations
+ * are collected in the order of their arrival and are sorted
+ * in descending relative violation order in one go on output.
  */
 class Viollist_
 {
     // data
     protected:
     
-    List1_<Viol_> Vl;	// sorted list of violations
+    Vlist_<Viol_> Vl;	// list of violations (unsorted)
     
     // methods
     public:
@@ -118,11 +119,15 @@ class Viollist_
     int add_viol(const Viol_& V, float Minrelv=0.05);
     
     /* write_file(): writes the contents of the calling object to
-     * a file Outfile or to cout if Outfile==NULL or cannot be opened.
-     * Return value: 1 if OK, 0 if written to cout.
+     * a file Outfile or to Out (cout by default) if Outfile==NULL
+     * or cannot be opened. Return value: 1 if OK, 0 if written to Out.
      */
-    int write_file(const char *Outfile) const;
+    int write_file(const char *Outfile, ostream& Out=cout) const;
     
+    /* Lists the violations in descending relative violation order.
+     * Violations with equal relative violations are listed
+     * in reverse order of their arrival.
+     */
     friend ostream& operator<<(ostream& Out, const Viollist_& Vl);
 };
 // END OF CLASS Viollist_
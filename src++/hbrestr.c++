@@ -72,7 +72,7 @@ int main(int argc, char *argv[])
     Out<<"NOE\nRESET\n";
     
     // process the secstr list
-    Clist1_<Sstr_> Slist=Pieces.secs();
+    Cvlist_<Sstr_> Slist=Pieces.secs();
     for (Slist.begin(); Slist!=NULL; Slist++)
     {
 	if ((*Slist)->is_helix())